@@ -0,0 +1,657 @@
+/* vtdbg_cli: inspects saved value tree files (XML, or the binary format of ValueTree::writeToStream)
+   without a display, using the debugger's model, query and diff code */
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "../value_tree_debugger/vtdbg/FlatTreeModel.h"
+#include "../value_tree_debugger/vtdbg/SubtreeStats.h"
+#include "../value_tree_debugger/vtdbg/TreeDiff.h"
+#include "../value_tree_debugger/vtdbg/TreeQuery.h"
+
+#include <iostream>
+#include <limits>
+
+using namespace juce;
+using namespace vtdbg;
+
+namespace
+{
+constexpr int streamBufferSize{ 1 << 16 };
+constexpr int maxValueLength{ 80 };
+constexpr int defaultBenchNodes{ 100000 };
+constexpr int benchRounds{ 10 };
+
+const char* const usage =
+    "Usage: vtdbg_cli <command> ...\n"
+    "  dump <file> [--depth=N]    Print the tree, down to depth N\n"
+    "  stats <file>               Size, shape and value statistics\n"
+    "  search <file> <text>       Nodes whose type, property names or values contain the text\n"
+    "  query <file> <query>       Nodes matching a path query, such as //Track[@muted=true]\n"
+    "  diff <baseline> <file>     Differences of the file from the baseline, exits with 1 if there are any\n"
+    "  convert <in> <out>         Convert between XML (.xml) and binary (any other extension)\n"
+    "  bench [file] [--nodes=N]   Time walks of the value trees against walks of the model, over the\n"
+    "                             file or a generated tree of N nodes, 100000 by default\n"
+    "Timings of each stage are printed to stderr.\n";
+
+/* Prints how long a stage took when it goes out of scope */
+class StageTimer
+{
+public:
+    explicit StageTimer(const char* stageName) :
+        name(stageName),
+        startTicks(Time::getHighResolutionTicks())
+    {
+    }
+
+    ~StageTimer()
+    {
+        const auto ms = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks) * 1000.0;
+        std::cerr << "[" << name << "] " << String{ ms, 2 } << " ms" << std::endl;
+    }
+
+private:
+    const char* name;
+    int64 startTicks;
+};
+
+bool isXmlFile(const File& file)
+{
+    return file.hasFileExtension("xml");
+}
+
+String describeValue(const var& value)
+{
+    auto text = value.isBinaryData() ? "<" + String{ (int)value.getBinaryData()->getSize() } + " bytes>" : value.toString();
+    text = text.replace("\n", "\\n");
+    if (text.length() > maxValueLength)
+        text = text.substring(0, maxValueLength) + "...";
+
+    return text + " (" + SubtreeStats::getValueTypeName(SubtreeStats::getValueType(value)) + ")";
+}
+
+// ============================================================================
+
+/* One node read from a file, without its children */
+struct StreamedNode
+{
+    String type;
+    int depth{ 0 };
+    /* Position of the node in tree order */
+    int64 index{ 0 };
+    NamedValueSet properties;
+    int numChildren{ 0 };
+};
+
+/* Reads the binary format of ValueTree::writeToStream one node at a time in tree order,
+   so a file of any size is read without holding the tree */
+class BinaryTreeReader
+{
+public:
+    explicit BinaryTreeReader(InputStream& inputStream) :
+        input(inputStream)
+    {
+    }
+
+    /* False at the end of the tree, or when the stream is not a value tree */
+    bool next(StreamedNode& node)
+    {
+        // Children still to be read at each level above
+        while (!remaining.empty() && remaining.back() == 0)
+            remaining.pop_back();
+
+        if (started && remaining.empty()) return false;
+
+        node.type = input.readString();
+        if (node.type.isEmpty()) return fail();
+
+        node.depth = static_cast<int>(remaining.size());
+        node.index = numRead++;
+        if (!remaining.empty()) --remaining.back();
+        started = true;
+
+        node.properties.clear();
+        const auto numProperties = input.readCompressedInt();
+        if (numProperties < 0) return fail();
+
+        for (int i = 0; i < numProperties; ++i)
+        {
+            const auto name = input.readString();
+            if (name.isEmpty()) return fail();
+
+            node.properties.set(name, var::readFromStream(input));
+        }
+
+        node.numChildren = input.readCompressedInt();
+        if (node.numChildren < 0) return fail();
+
+        remaining.push_back(node.numChildren);
+        return true;
+    }
+
+    bool hasFailed() const { return failed; }
+
+private:
+    bool fail()
+    {
+        failed = true;
+        return false;
+    }
+
+    InputStream& input;
+    std::vector<int> remaining;
+    int64 numRead{ 0 };
+    bool started{ false };
+    bool failed{ false };
+};
+
+Result readTree(const File& file, ValueTree& tree)
+{
+    StageTimer timer{ "read" };
+
+    if (isXmlFile(file))
+    {
+        // JUCE parses XML as a whole document
+        if (auto xml = parseXML(file))
+            tree = ValueTree::fromXml(*xml);
+    }
+    else
+    {
+        FileInputStream fileStream{ file };
+        if (!fileStream.openedOk())
+            return Result::fail("Can't open " + file.getFullPathName());
+
+        BufferedInputStream stream{ fileStream, streamBufferSize };
+        tree = ValueTree::readFromStream(stream);
+    }
+
+    return tree.isValid() ? Result::ok() : Result::fail("No value tree in " + file.getFullPathName());
+}
+
+/* Visit every node of a file in tree order. Binary files are streamed, XML files are parsed first. */
+template <typename Visitor>
+Result forEachNode(const File& file, Visitor&& visit)
+{
+    StreamedNode node;
+
+    if (!isXmlFile(file))
+    {
+        StageTimer timer{ "stream" };
+
+        FileInputStream fileStream{ file };
+        if (!fileStream.openedOk())
+            return Result::fail("Can't open " + file.getFullPathName());
+
+        BufferedInputStream stream{ fileStream, streamBufferSize };
+        BinaryTreeReader reader{ stream };
+        while (reader.next(node))
+            visit(node);
+
+        return reader.hasFailed() ? Result::fail("Not a value tree, or truncated: " + file.getFullPathName()) : Result::ok();
+    }
+
+    ValueTree tree;
+    const auto result = readTree(file, tree);
+    if (result.failed()) return result;
+
+    StageTimer timer{ "walk" };
+    std::vector<std::pair<ValueTree, int>> stack{ { tree, 0 } };
+
+    while (!stack.empty())
+    {
+        auto [current, depth] = stack.back();
+        stack.pop_back();
+
+        node.type = current.getType().toString();
+        node.depth = depth;
+        node.properties.clear();
+        for (int i = 0; i < current.getNumProperties(); ++i)
+            node.properties.set(current.getPropertyName(i), current.getProperty(current.getPropertyName(i)));
+
+        node.numChildren = current.getNumChildren();
+        visit(node);
+        ++node.index;
+
+        // Pushed in reverse so they come off in order
+        for (int i = current.getNumChildren(); --i >= 0;)
+            stack.emplace_back(current.getChild(i), depth + 1);
+    }
+
+    return Result::ok();
+}
+
+/* A path like /Session[0]/Track[3], the positions tell apart siblings of the same type */
+String getNodePath(const FlatTreeModel& model, int node)
+{
+    StringArray parts;
+    for (auto n = node; n != FlatTreeModel::none; n = model.getParent(n))
+        parts.insert(0, model.getType(n).toString() + "[" + String{ model.getPosition(n) } + "]");
+
+    return "/" + parts.joinIntoString("/");
+}
+
+// ============================================================================
+
+int dump(const File& file, int maxDepth)
+{
+    const auto result = forEachNode(file, [&](const StreamedNode& node)
+    {
+        if (node.depth > maxDepth) return;
+
+        String line;
+        line << String::repeatedString("  ", node.depth) << node.type;
+        for (const auto& property : node.properties)
+            line << " " << property.name.toString() << "=" << describeValue(property.value);
+
+        if (node.depth == maxDepth && node.numChildren > 0)
+            line << " (+" << node.numChildren << " children)";
+
+        std::cout << line << "\n";
+    });
+
+    if (result.failed()) std::cerr << result.getErrorMessage() << std::endl;
+    return result.wasOk() ? 0 : 2;
+}
+
+int stats(const File& file)
+{
+    SubtreeStats stats;
+    const auto startTicks = Time::getHighResolutionTicks();
+
+    const auto result = forEachNode(file, [&](const StreamedNode& node)
+    {
+        stats.addNodeShape(node.depth, node.numChildren);
+        for (const auto& property : node.properties)
+            stats.addProperty((FlatTreeModel::NodeId)node.index, property.name, property.value);
+    });
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 2;
+    }
+
+    // Largest values refer to nodes by their position in tree order
+    stats.computeMs = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks) * 1000.0;
+    std::cout << stats.getDescription();
+    return 0;
+}
+
+int search(const File& file, const String& text)
+{
+    int64 numMatches{ 0 };
+    StringArray path;
+    std::vector<int> positions;
+
+    const auto result = forEachNode(file, [&](const StreamedNode& node)
+    {
+        // The path of the node, each level counting its children as they come
+        positions.resize((size_t)node.depth + 1);
+        const auto position = positions[(size_t)node.depth]++;
+        positions.push_back(0);
+
+        path.removeRange(node.depth, path.size());
+        path.add(node.type + "[" + String{ position } + "]");
+
+        StringArray found;
+        if (node.type.containsIgnoreCase(text))
+            found.add("type");
+
+        for (const auto& property : node.properties)
+            if (property.name.toString().containsIgnoreCase(text) || property.value.toString().containsIgnoreCase(text))
+                found.add(property.name.toString() + "=" + describeValue(property.value));
+
+        if (found.isEmpty()) return;
+
+        ++numMatches;
+        std::cout << "/" << path.joinIntoString("/") << " " << found.joinIntoString(" ") << "\n";
+    });
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 2;
+    }
+
+    std::cerr << numMatches << " nodes match" << std::endl;
+    return 0;
+}
+
+int query(const File& file, const String& queryText)
+{
+    auto result = Result::ok();
+    const auto compiled = TreeQuery::compile(queryText, result);
+    if (result.failed())
+    {
+        std::cerr << "Query: " << result.getErrorMessage() << std::endl;
+        return 2;
+    }
+
+    ValueTree tree;
+    result = readTree(file, tree);
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 2;
+    }
+
+    FlatTreeModel model;
+    {
+        StageTimer timer{ "model" };
+        model.rebuild(tree);
+    }
+
+    const auto matches = compiled.evaluate(model);
+    std::cerr << "[query] " << String{ matches.evaluationMs, 2 } << " ms, " << matches.nodesTested << " nodes tested, "
+              << matches.indexedSteps << " of the steps indexed" << std::endl;
+
+    for (auto node : matches.nodes)
+        std::cout << getNodePath(model, node) << "\n";
+
+    std::cerr << (int)matches.nodes.size() << " nodes match" << std::endl;
+    return 0;
+}
+
+int diff(const File& baselineFile, const File& file)
+{
+    ValueTree baselineTree, tree;
+    auto result = readTree(baselineFile, baselineTree);
+    if (result.wasOk()) result = readTree(file, tree);
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 2;
+    }
+
+    // Typed like the baseline, which the diff reads back the same way
+    if (isXmlFile(file))
+        tree = TreeDiff::withTypedValues(tree);
+
+    FlatTreeModel model;
+    TreeDiff treeDiff{ model };
+    {
+        StageTimer timer{ "model" };
+        model.rebuild(tree);
+        treeDiff.setBaseline(baselineTree);
+    }
+
+    std::cerr << "[diff] " << String{ treeDiff.getLastUpdateMs(), 2 } << " ms" << std::endl;
+
+    // Only subtrees containing differences are walked
+    const auto& baseline = treeDiff.getBaseline();
+    std::vector<int> stack{ model.getRoot() };
+
+    while (!stack.empty())
+    {
+        const auto node = stack.back();
+        stack.pop_back();
+
+        const auto* difference = treeDiff.find(model.getNodeId(node));
+        if (difference == nullptr) continue;
+
+        const auto path = getNodePath(model, node);
+
+        if (difference->added)
+        {
+            // Its descendants are all added too
+            std::cout << "+ " << path << "\n";
+            continue;
+        }
+
+        if (baseline.getType(difference->baselineNode) != model.getType(node))
+            std::cout << "~ " << path << " type was " << baseline.getType(difference->baselineNode).toString() << "\n";
+
+        for (const auto& property : difference->properties)
+        {
+            const auto* baselineValue = treeDiff.findBaselineValue(model.getNodeId(node), property);
+            const auto* value = model.getTree(node).getPropertyPointer(property);
+
+            std::cout << "~ " << path << " @" << property.toString() << ": "
+                      << (baselineValue != nullptr ? describeValue(*baselineValue) : String{ "missing" }) << " -> "
+                      << (value != nullptr ? describeValue(*value) : String{ "missing" }) << "\n";
+        }
+
+        if (difference->childrenRemoved)
+            std::cout << "- " << path << " " << difference->childrenRemoved << " children removed\n";
+
+        for (auto child = model.getFirstChild(node); child != FlatTreeModel::none; child = model.getNextSibling(child))
+            stack.push_back(child);
+    }
+
+    std::cerr << treeDiff.getNumDifferences() << " nodes differ" << std::endl;
+    return treeDiff.getNumDifferences() > 0 ? 1 : 0;
+}
+
+int convert(const File& input, const File& output)
+{
+    ValueTree tree;
+    const auto result = readTree(input, tree);
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 2;
+    }
+
+    StageTimer timer{ "write" };
+    output.deleteFile();
+    FileOutputStream fileStream{ output, streamBufferSize };
+    if (!fileStream.openedOk())
+    {
+        std::cerr << "Can't write " << output.getFullPathName() << std::endl;
+        return 2;
+    }
+
+    if (isXmlFile(output))
+    {
+        if (auto xml = tree.createXml())
+            xml->writeTo(fileStream);
+    }
+    else
+    {
+        tree.writeToStream(fileStream);
+    }
+
+    return 0;
+}
+
+/* A tree of numNodes nodes, ten children each, with an int, a double and a string property */
+ValueTree makeBenchTree(int numNodes)
+{
+    const Identifier types[]{ "Session", "Track", "Plugin", "Parameter", "Point" };
+    ValueTree root{ types[0] };
+
+    // Filled breadth first, so the tree is as shallow as ten children each allow
+    std::vector<std::pair<ValueTree, int>> queue{ { root, 0 } };
+    int numMade{ 1 };
+
+    for (size_t next = 0; next < queue.size() && numMade < numNodes; ++next)
+    {
+        auto parent = queue[next].first;
+        const auto depth = queue[next].second + 1;
+
+        for (int i = 0; i < 10 && numMade < numNodes; ++i, ++numMade)
+        {
+            ValueTree child{ types[jmin(depth, 4)] };
+            child.setProperty("id", numMade, nullptr);
+            child.setProperty("gain", numMade * 0.5, nullptr);
+            child.setProperty("name", "Node " + String{ numMade }, nullptr);
+            parent.appendChild(child, nullptr);
+            queue.emplace_back(child, depth);
+        }
+    }
+
+    return root;
+}
+
+/* The fastest of benchRounds runs in ms, the result of each run is kept so it isn't optimised away */
+template <typename Walk>
+double timeBest(Walk&& walk, double& result)
+{
+    auto best = std::numeric_limits<double>::max();
+    for (int round = 0; round < benchRounds; ++round)
+    {
+        const auto startTicks = Time::getHighResolutionTicks();
+        result = walk();
+        best = jmin(best, Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks) * 1000.0);
+    }
+
+    return best;
+}
+
+int bench(const File* file, int numNodes)
+{
+    ValueTree tree;
+    if (file != nullptr)
+    {
+        const auto result = readTree(*file, tree);
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 2;
+        }
+    }
+    else
+    {
+        StageTimer timer{ "generate" };
+        tree = makeBenchTree(numNodes);
+    }
+
+    FlatTreeModel model;
+    {
+        StageTimer timer{ "model" };
+        model.rebuild(tree);
+    }
+
+    // Handles of every node for the walks up, collected outside the timings
+    std::vector<ValueTree> handles;
+    model.forEachInSubtree(model.getRoot(), [&](int node) { handles.push_back(model.getTree(node)); });
+
+    const Identifier gain{ "gain" };
+    const auto gainIndex = model.findIdentifier(gain);
+
+    std::cout << model.getNumNodes() << " nodes, fastest of " << benchRounds << " rounds
+";
+
+    const auto report = [](const char* walkName, double treeMs, double modelMs, double treeResult, double modelResult)
+    {
+        std::cout << String{ walkName }.paddedRight(' ', 10) << "ValueTree " << String{ treeMs, 2 } << " ms, model "
+                  << String{ modelMs, 2 } << " ms, " << String{ treeMs / jmax(modelMs, 0.001), 1 } << "x"
+                  << (treeResult == modelResult ? "" : " (results differ)") << "\n";
+    };
+
+    double treeResult{ 0.0 }, modelResult{ 0.0 };
+
+    // Every node in tree order, counting properties
+    auto treeMs = timeBest([&]
+    {
+        double numProperties{ 0.0 };
+        std::vector<ValueTree> stack{ tree };
+        while (!stack.empty())
+        {
+            const auto current = stack.back();
+            stack.pop_back();
+            numProperties += current.getNumProperties();
+            for (int i = current.getNumChildren(); --i >= 0;)
+                stack.push_back(current.getChild(i));
+        }
+        return numProperties;
+    }, treeResult);
+
+    auto modelMs = timeBest([&]
+    {
+        double numProperties{ 0.0 };
+        model.forEachInSubtree(model.getRoot(), [&](int node) { numProperties += model.getNumProperties(node); });
+        return numProperties;
+    }, modelResult);
+
+    report("walk", treeMs, modelMs, treeResult, modelResult);
+
+    // Every node in tree order, adding up a numeric property
+    treeMs = timeBest([&]
+    {
+        double sum{ 0.0 };
+        std::vector<ValueTree> stack{ tree };
+        while (!stack.empty())
+        {
+            const auto current = stack.back();
+            stack.pop_back();
+            if (const auto* value = current.getPropertyPointer(gain))
+                sum += (double)*value;
+            for (int i = current.getNumChildren(); --i >= 0;)
+                stack.push_back(current.getChild(i));
+        }
+        return sum;
+    }, treeResult);
+
+    modelMs = timeBest([&]
+    {
+        double sum{ 0.0 };
+        model.forEachInSubtree(model.getRoot(), [&](int node)
+        {
+            for (int i = 0; i < model.getNumProperties(node); ++i)
+                if (model.getPropertyNameIndex(node, i) == gainIndex)
+                    sum += (double)model.getPropertyValue(node, i);
+        });
+        return sum;
+    }, modelResult);
+
+    report("property", treeMs, modelMs, treeResult, modelResult);
+
+    // From every node up to the root, as finding paths and depths does
+    treeMs = timeBest([&]
+    {
+        double depths{ 0.0 };
+        for (const auto& handle : handles)
+            for (auto parent = handle.getParent(); parent.isValid(); parent = parent.getParent())
+                ++depths;
+        return depths;
+    }, treeResult);
+
+    modelMs = timeBest([&]
+    {
+        double depths{ 0.0 };
+        for (const auto& handle : handles)
+            for (auto node = model.getParent(model.findNode(handle)); node != FlatTreeModel::none; node = model.getParent(node))
+                ++depths;
+        return depths;
+    }, modelResult);
+
+    report("parents", treeMs, modelMs, treeResult, modelResult);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    ArgumentList args{ argc, argv };
+
+    StringArray positional;
+    for (const auto& arg : args.arguments)
+        if (!arg.isOption())
+            positional.add(arg.text);
+
+    const auto command = positional[0];
+    const auto getFile = [&](int index) { return File::getCurrentWorkingDirectory().getChildFile(positional[index]); };
+
+    if (command == "dump" && positional.size() == 2)
+    {
+        const auto depth = args.getValueForOption("--depth|-d");
+        return dump(getFile(1), depth.isEmpty() ? std::numeric_limits<int>::max() : depth.getIntValue());
+    }
+
+    if (command == "stats" && positional.size() == 2)   return stats(getFile(1));
+    if (command == "search" && positional.size() == 3)  return search(getFile(1), positional[2]);
+    if (command == "query" && positional.size() == 3)   return query(getFile(1), positional[2]);
+    if (command == "diff" && positional.size() == 3)    return diff(getFile(1), getFile(2));
+    if (command == "convert" && positional.size() == 3) return convert(getFile(1), getFile(2));
+
+    if (command == "bench" && positional.size() <= 2)
+    {
+        const auto nodes = args.getValueForOption("--nodes|-n");
+        const auto file = positional.size() == 2 ? getFile(1) : File{};
+        return bench(positional.size() == 2 ? &file : nullptr, nodes.isEmpty() ? defaultBenchNodes : jmax(1, nodes.getIntValue()));
+    }
+
+    std::cerr << usage;
+    return 2;
+}
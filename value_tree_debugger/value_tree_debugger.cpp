@@ -1,3 +1,21 @@
 #include "value_tree_debugger.h"
 
+#include "vtdbg/AdaptiveSampler.cpp"
+#include "vtdbg/ChangeLog.cpp"
+#include "vtdbg/ExclusionFilter.cpp"
+#include "vtdbg/FlatTreeModel.cpp"
+#include "vtdbg/FreezeSnapshot.cpp"
+#include "vtdbg/OverheadGovernor.cpp"
+#include "vtdbg/SessionStats.cpp"
+#include "vtdbg/StressGenerator.cpp"
+#include "vtdbg/SubtreeClipboard.cpp"
+#include "vtdbg/SubtreeStats.cpp"
+#include "vtdbg/TextLineIndex.cpp"
+#include "vtdbg/TimeTravel.cpp"
+#include "vtdbg/TraceExporter.cpp"
+#include "vtdbg/TreeDiff.cpp"
+#include "vtdbg/TreeQuery.cpp"
+#include "vtdbg/ValueComparison.cpp"
+#include "vtdbg/ValueHistory.cpp"
+#include "vtdbg/Watchpoints.cpp"
 #include "vtdbg/ValueTreeDebugger.cpp"
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include "AdaptiveSampler.h"
+
+namespace vtdbg
+{
+AdaptiveSampler::AdaptiveSampler(const FlatTreeModel& treeModel) :
+    model(treeModel)
+{
+}
+
+AdaptiveSampler::~AdaptiveSampler()
+{
+    stopTimer();
+}
+
+void AdaptiveSampler::addSubtree(const juce::ValueTree& subtree)
+{
+    const auto node = model.findNode(subtree);
+    if (node == FlatTreeModel::none || containsSubtree(subtree)) return;
+
+    Subtree added;
+    added.root = model.getNodeId(node);
+    subtrees.push_back(added);
+    eventCounts.push_back(0);
+
+    // Takes its nodes from the subtree it is nested in, if any, leaving those of subtrees nested in it
+    reassign(node, getOwner(node), (int)subtrees.size() - 1);
+    updateTimer();
+}
+
+void AdaptiveSampler::removeSubtree(const juce::ValueTree& subtree)
+{
+    const auto node = model.findNode(subtree);
+    if (node == FlatTreeModel::none) return;
+
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+        if (subtrees[i].root != model.getNodeId(node)) continue;
+
+        // Catch up with what was missed before following events again
+        if (subtrees[i].mode == Mode::sampling)
+            poll(subtrees[i]);
+
+        // Its nodes go back to the subtree it is nested in, if any
+        const auto parent = model.getParent(node);
+        reassign(node, (int)i, parent != FlatTreeModel::none ? getOwner(parent) : -1);
+        eraseSubtree(i);
+        updateTimer();
+
+        if (onModeChanged) onModeChanged();
+        return;
+    }
+}
+
+bool AdaptiveSampler::containsSubtree(const juce::ValueTree& subtree) const
+{
+    const auto node = model.findNode(subtree);
+    if (node == FlatTreeModel::none) return false;
+
+    for (const auto& entry : subtrees)
+        if (entry.root == model.getNodeId(node))
+            return true;
+
+    return false;
+}
+
+void AdaptiveSampler::clear()
+{
+    subtrees.clear();
+    eventCounts.clear();
+    membership.clear();
+    updateTimer();
+}
+
+int AdaptiveSampler::getNumSampling() const
+{
+    int numSampling{ 0 };
+    for (const auto& subtree : subtrees)
+        if (subtree.mode == Mode::sampling)
+            ++numSampling;
+
+    return numSampling;
+}
+
+void AdaptiveSampler::setThreshold(double eventsPerSecond)
+{
+    threshold = juce::jmax(1.0, eventsPerSecond);
+}
+
+void AdaptiveSampler::setSampleIntervalMs(int intervalMs)
+{
+    sampleIntervalMs = juce::jmax(1, intervalMs);
+    if (isTimerRunning())
+        startTimer(sampleIntervalMs);
+}
+
+bool AdaptiveSampler::eventArrived(const juce::ValueTree& tree)
+{
+    const auto node = model.findNode(tree);
+    if (node == FlatTreeModel::none) return false;
+
+    const auto it = membership.find(model.getNodeId(node));
+    if (it == membership.end()) return false;
+
+    ++eventCounts[(size_t)it->second];
+    return subtrees[(size_t)it->second].mode == Mode::sampling;
+}
+
+void AdaptiveSampler::nodeAdded(int node)
+{
+    const auto parent = model.getParent(node);
+    if (subtrees.empty() || parent == FlatTreeModel::none) return;
+
+    const auto owner = getOwner(parent);
+    if (owner < 0) return;
+
+    model.forEachInSubtree(node, [&](int n) { membership[model.getNodeId(n)] = owner; });
+}
+
+void AdaptiveSampler::nodeRemoved(int node)
+{
+    if (subtrees.empty()) return;
+
+    // A node outside every subtree can still hold the roots of some, whose nodes are then the only
+    // ones to drop
+    if (getOwner(node) >= 0)
+        model.forEachInSubtree(node, [&](int n) { membership.erase(model.getNodeId(n)); });
+
+    bool removed{ false };
+    for (size_t i = subtrees.size(); i-- > 0;)
+    {
+        const auto root = model.findNode(subtrees[i].root);
+        if (root != FlatTreeModel::none && !isInside(root, node)) continue;
+
+        if (root != FlatTreeModel::none)
+            model.forEachInSubtree(root, [&](int n) { membership.erase(model.getNodeId(n)); });
+
+        eraseSubtree(i);
+        removed = true;
+    }
+
+    if (removed)
+    {
+        updateTimer();
+        if (onModeChanged) onModeChanged();
+    }
+}
+
+void AdaptiveSampler::timerCallback()
+{
+    for (auto& subtree : subtrees)
+        if (subtree.mode == Mode::sampling)
+            poll(subtree);
+
+    const auto nowMs = juce::Time::getMillisecondCounterHiRes();
+    if (nowMs - lastRateMs >= rateWindowMs)
+        updateModes(nowMs);
+}
+
+void AdaptiveSampler::updateTimer()
+{
+    if (subtrees.empty())
+    {
+        stopTimer();
+    }
+    else if (!isTimerRunning())
+    {
+        lastRateMs = juce::Time::getMillisecondCounterHiRes();
+        startTimer(sampleIntervalMs);
+    }
+}
+
+void AdaptiveSampler::reassign(int root, int from, int to)
+{
+    if (from == to) return;
+
+    model.forEachInSubtree(root, [&](int node)
+    {
+        const auto it = membership.find(model.getNodeId(node));
+        const auto owner = it != membership.end() ? it->second : -1;
+        if (owner != from) return;
+
+        if (to >= 0)
+            membership[model.getNodeId(node)] = to;
+        else
+            membership.erase(it);
+    });
+}
+
+void AdaptiveSampler::eraseSubtree(size_t index)
+{
+    subtrees.erase(subtrees.begin() + (std::ptrdiff_t)index);
+    eventCounts.erase(eventCounts.begin() + (std::ptrdiff_t)index);
+
+    // Only the indices move, no nodes are visited
+    for (auto& entry : membership)
+        if (entry.second > (int)index)
+            --entry.second;
+}
+
+int AdaptiveSampler::getOwner(int node) const
+{
+    const auto it = membership.find(model.getNodeId(node));
+    return it != membership.end() ? it->second : -1;
+}
+
+bool AdaptiveSampler::isInside(int node, int ancestor) const
+{
+    for (; node != FlatTreeModel::none; node = model.getParent(node))
+        if (node == ancestor)
+            return true;
+
+    return false;
+}
+
+void AdaptiveSampler::updateModes(double nowMs)
+{
+    const auto seconds = (nowMs - lastRateMs) / 1000.0;
+    lastRateMs = nowMs;
+    bool modeChanged{ false };
+
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+        auto& subtree = subtrees[i];
+        subtree.eventRate = (double)eventCounts[i] / juce::jmax(seconds, 0.001);
+        eventCounts[i] = 0;
+
+        // Half the threshold to switch back, so a rate near it doesn't flip the mode every window
+        if (subtree.mode == Mode::events && subtree.eventRate > threshold)
+        {
+            subtree.mode = Mode::sampling;
+            modeChanged = true;
+        }
+        else if (subtree.mode == Mode::sampling && subtree.eventRate < threshold * 0.5)
+        {
+            poll(subtree);
+            subtree.mode = Mode::events;
+            modeChanged = true;
+        }
+    }
+
+    if (modeChanged && onModeChanged)
+        onModeChanged();
+}
+
+void AdaptiveSampler::poll(Subtree& subtree)
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const auto root = model.findNode(subtree.root);
+    if (root == FlatTreeModel::none) return;
+
+    const auto index = (int)(&subtree - subtrees.data());
+    changed.clear();
+
+    model.forEachInSubtree(root, [&](int node)
+    {
+        const auto it = membership.find(model.getNodeId(node));
+        if (it != membership.end() && it->second != index) return;
+
+        if (!model.isContentCurrent(node))
+            findChangedProperties(node);
+    });
+
+    ++subtree.polls;
+    subtree.changesFound += (juce::int64)changed.size();
+    subtree.lastPollMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+    // Passed on once the walk is done, as they update the model
+    if (onSampledChange)
+        for (auto& [tree, property] : changed)
+            onSampledChange(tree, property);
+
+    changed.clear();
+}
+
+void AdaptiveSampler::findChangedProperties(int node)
+{
+    const auto& tree = model.getTree(node);
+    const auto numMirrored = model.getNumProperties(node);
+
+    for (int i = 0; i < tree.getNumProperties(); ++i)
+    {
+        const auto name = tree.getPropertyName(i);
+        bool matches{ false };
+
+        for (int j = 0; j < numMirrored; ++j)
+        {
+            if (model.getPropertyName(node, j) == name)
+            {
+                matches = model.getPropertyValue(node, j).equalsWithSameType(tree[name]);
+                break;
+            }
+        }
+
+        if (!matches)
+            changed.emplace_back(tree, name);
+    }
+
+    // Removed properties
+    for (int j = 0; j < numMirrored; ++j)
+        if (!tree.hasProperty(model.getPropertyName(node, j)))
+            changed.emplace_back(tree, model.getPropertyName(node, j));
+}
+
+} // namespace vtdbg
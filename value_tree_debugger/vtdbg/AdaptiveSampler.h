@@ -0,0 +1,103 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace vtdbg
+{
+/* Subtrees whose properties change faster than is worth following event by event, such as meters.
+   Each subtree added starts in event mode. When its rate of property changes goes over the
+   threshold it switches to sampling: the changes are dropped as they arrive, and the subtree is
+   polled at the sample interval instead, finding the nodes whose content hash no longer matches
+   their value tree. Once the rate falls under half the threshold it switches back.
+   Structural changes are always followed by events, and update which subtree a node belongs to
+   for the added or removed nodes only. */
+class AdaptiveSampler : private juce::Timer
+{
+public:
+    explicit AdaptiveSampler(const FlatTreeModel& treeModel);
+    ~AdaptiveSampler() override;
+
+    enum class Mode
+    {
+        events,
+        sampling,
+    };
+
+    struct Subtree
+    {
+        FlatTreeModel::NodeId root{ 0 };
+        Mode mode{ Mode::events };
+        /* Property changes per second, measured over the last rate window */
+        double eventRate{ 0.0 };
+        juce::int64 polls{ 0 };
+        /* Properties found changed by polling */
+        juce::int64 changesFound{ 0 };
+        double lastPollMs{ 0.0 };
+    };
+
+    void addSubtree(const juce::ValueTree& subtree);
+    void removeSubtree(const juce::ValueTree& subtree);
+    bool containsSubtree(const juce::ValueTree& subtree) const;
+    void clear();
+    /* Whether there are subtrees, until then eventArrived needn't be called */
+    bool isActive() const { return !subtrees.empty(); }
+    const std::vector<Subtree>& getSubtrees() const { return subtrees; }
+    int getNumSampling() const;
+
+    /* Changes per second above which a subtree is sampled */
+    void setThreshold(double eventsPerSecond);
+    double getThreshold() const { return threshold; }
+    void setSampleIntervalMs(int intervalMs);
+    int getSampleIntervalMs() const { return sampleIntervalMs; }
+
+    /* Call for every property change, before the model is updated. Counts the change, and returns
+       true if the tree is in a sampled subtree, so the change should be ignored. */
+    bool eventArrived(const juce::ValueTree& tree);
+    /* Call after a node was mirrored, by a change or while the model is built, to put it and its
+       descendants in the subtree of its parent */
+    void nodeAdded(int node);
+    /* Call before the model removes a node, to drop it and its descendants, and the subtrees
+       whose root goes with it */
+    void nodeRemoved(int node);
+
+    /* Called for each property found changed by polling, as if its change had just arrived */
+    std::function<void(juce::ValueTree&, const juce::Identifier&)> onSampledChange;
+    /* Called when a subtree switched mode */
+    std::function<void()> onModeChanged;
+
+private:
+    void timerCallback() override;
+    void updateTimer();
+    /* Give the nodes of a subtree owned by one subtree, or by none, to another, or to none */
+    void reassign(int root, int from, int to);
+    void eraseSubtree(size_t index);
+    int getOwner(int node) const;
+    bool isInside(int node, int ancestor) const;
+    void updateModes(double nowMs);
+    void poll(Subtree& subtree);
+    /* Collect the properties of a node which differ from the model */
+    void findChangedProperties(int node);
+
+    const FlatTreeModel& model;
+    std::vector<Subtree> subtrees;
+    /* The subtree each node belongs to, by index into subtrees, with the events counted since the
+       rates were last measured */
+    std::unordered_map<FlatTreeModel::NodeId, int> membership;
+    std::vector<juce::int64> eventCounts;
+
+    double threshold{ 1000.0 };
+    int sampleIntervalMs{ 50 };
+    static constexpr double rateWindowMs{ 500.0 };
+    double lastRateMs{ 0.0 };
+
+    /* Found by a poll and passed on once it is done, kept to reuse the storage */
+    std::vector<std::pair<juce::ValueTree, juce::Identifier>> changed;
+};
+
+} // namespace vtdbg
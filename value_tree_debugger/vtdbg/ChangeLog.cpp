@@ -0,0 +1,320 @@
+#include "ChangeLog.h"
+
+namespace vtdbg
+{
+/* Longest time the replay spends applying operations in one timer tick when running as fast as possible */
+constexpr double replaySliceSeconds{ 0.010 };
+
+void ChangeRecorder::start(const FlatTreeModel& model)
+{
+    log = juce::ValueTree{ ChangeLogIds::changeLog };
+    operations = juce::ValueTree{ ChangeLogIds::operations };
+
+    juce::ValueTree initial{ ChangeLogIds::initial };
+    if (model.getRoot() != FlatTreeModel::none)
+    {
+        initial.setProperty(ChangeLogIds::ids, getSubtreeIds(model, model.getRoot()), nullptr);
+        initial.appendChild(model.getTree(model.getRoot()).createCopy(), nullptr);
+    }
+
+    log.appendChild(initial, nullptr);
+    log.appendChild(operations, nullptr);
+    startTime = juce::Time::getMillisecondCounterHiRes();
+}
+
+juce::ValueTree ChangeRecorder::stop()
+{
+    auto recorded = log;
+    log = {};
+    operations = {};
+    return recorded;
+}
+
+void ChangeRecorder::propertyChanged(const FlatTreeModel& model, int node, const juce::Identifier& property)
+{
+    if (!isRecording()) return;
+
+    const auto& tree = model.getTree(node);
+    const auto* value = tree.getPropertyPointer(property);
+
+    auto op = addOperation(value != nullptr ? ChangeLogIds::setProperty : ChangeLogIds::removeProperty);
+    op.setProperty(ChangeLogIds::node, (juce::int64)model.getNodeId(node), nullptr);
+    op.setProperty(ChangeLogIds::name, property.toString(), nullptr);
+    if (value != nullptr)
+        op.setProperty(ChangeLogIds::value, *value, nullptr);
+}
+
+void ChangeRecorder::childAdded(const FlatTreeModel& model, int child, int index)
+{
+    if (!isRecording()) return;
+
+    auto op = addOperation(ChangeLogIds::addChild);
+    op.setProperty(ChangeLogIds::parent, (juce::int64)model.getNodeId(model.getParent(child)), nullptr);
+    op.setProperty(ChangeLogIds::index, index, nullptr);
+    op.setProperty(ChangeLogIds::ids, getSubtreeIds(model, child), nullptr);
+    op.appendChild(model.getTree(child).createCopy(), nullptr);
+}
+
+void ChangeRecorder::childRemoved(const FlatTreeModel& model, int parentNode, int index)
+{
+    if (!isRecording()) return;
+
+    auto op = addOperation(ChangeLogIds::removeChild);
+    op.setProperty(ChangeLogIds::parent, (juce::int64)model.getNodeId(parentNode), nullptr);
+    op.setProperty(ChangeLogIds::index, index, nullptr);
+}
+
+void ChangeRecorder::childMoved(const FlatTreeModel& model, int parentNode, int oldIndex, int newIndex)
+{
+    if (!isRecording()) return;
+
+    auto op = addOperation(ChangeLogIds::moveChild);
+    op.setProperty(ChangeLogIds::parent, (juce::int64)model.getNodeId(parentNode), nullptr);
+    op.setProperty(ChangeLogIds::oldIndex, oldIndex, nullptr);
+    op.setProperty(ChangeLogIds::index, newIndex, nullptr);
+}
+
+juce::String ChangeRecorder::getSubtreeIds(const FlatTreeModel& model, int node)
+{
+    juce::String ids;
+    model.forEachInSubtree(node, [&](int n) { ids << (juce::int64)model.getNodeId(n) << ' '; });
+    return ids.trimEnd();
+}
+
+juce::ValueTree ChangeRecorder::addOperation(const juce::String& type)
+{
+    juce::ValueTree op{ ChangeLogIds::op };
+    op.setProperty(ChangeLogIds::type, type, nullptr);
+    op.setProperty(ChangeLogIds::time, (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0, nullptr);
+    operations.appendChild(op, nullptr);
+    return op;
+}
+
+// ============================================================================
+
+ReplayEngine::~ReplayEngine()
+{
+    stopTimer();
+}
+
+juce::Result ReplayEngine::load(const juce::ValueTree& changeLog)
+{
+    pause();
+
+    if (!changeLog.hasType(ChangeLogIds::changeLog))
+        return juce::Result::fail("Not a change log");
+
+    const auto newInitial = changeLog.getChildWithName(ChangeLogIds::initial);
+    const auto newOperations = changeLog.getChildWithName(ChangeLogIds::operations);
+
+    if (!newInitial.isValid() || newInitial.getNumChildren() != 1 || !newOperations.isValid())
+        return juce::Result::fail("The change log is incomplete");
+
+    static const juce::StringArray knownTypes{ ChangeLogIds::setProperty, ChangeLogIds::removeProperty, ChangeLogIds::addChild,
+                                               ChangeLogIds::removeChild, ChangeLogIds::moveChild };
+    for (int i = 0; i < newOperations.getNumChildren(); ++i)
+    {
+        const auto type = newOperations.getChild(i)[ChangeLogIds::type].toString();
+        if (!knownTypes.contains(type))
+            return juce::Result::fail("Operation " + juce::String{ i } + " has the unknown type \"" + type + "\"");
+    }
+
+    initial = newInitial;
+    operations = newOperations;
+    rewind();
+    return juce::Result::ok();
+}
+
+void ReplayEngine::setTarget(juce::ValueTree targetTree, juce::UndoManager* undoManager)
+{
+    pause();
+    target = targetTree;
+    um = undoManager;
+    rewind();
+}
+
+void ReplayEngine::rewind()
+{
+    pause();
+    position = 0;
+    numFailed = 0;
+    nodes.clear();
+    targetReset = false;
+
+    if (onStateChanged) onStateChanged();
+}
+
+void ReplayEngine::resetTarget()
+{
+    // Keeping its own identity, so listeners stay attached
+    const juce::ScopedValueSetter<bool> applyingNow{ applying, true };
+    if (um != nullptr) um->beginNewTransaction("Reset for replay");
+    target.copyPropertiesAndChildrenFrom(initial.getChild(0), um);
+    if (um != nullptr) um->beginNewTransaction("Replay");
+
+    mapSubtree(target, initial[ChangeLogIds::ids].toString());
+    targetReset = true;
+}
+
+void ReplayEngine::play()
+{
+    if (!isLoaded() || !target.isValid() || position >= getNumOperations()) return;
+
+    if (!targetReset)
+        resetTarget();
+
+    playStartClock = juce::Time::getMillisecondCounterHiRes() / 1000.0;
+    playStartLogTime = getTimeOfOperation(position);
+    startTimer(5);
+}
+
+void ReplayEngine::pause()
+{
+    if (!isTimerRunning()) return;
+
+    stopTimer();
+    if (onStateChanged) onStateChanged();
+}
+
+bool ReplayEngine::step()
+{
+    if (!isLoaded() || !target.isValid() || position >= getNumOperations()) return false;
+
+    if (!targetReset)
+        resetTarget();
+
+    const juce::ScopedValueSetter<bool> applyingNow{ applying, true };
+    if (!apply(operations.getChild(position++)))
+        ++numFailed;
+
+    return true;
+}
+
+double ReplayEngine::runToEnd()
+{
+    pause();
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    while (step()) {}
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    if (onStateChanged) onStateChanged();
+    return seconds;
+}
+
+void ReplayEngine::setSpeed(double newSpeed)
+{
+    speed = juce::jmax(0.0, newSpeed);
+
+    if (isPlaying())
+    {
+        // Keep the position, continue at the new speed
+        stopTimer();
+        play();
+    }
+}
+
+void ReplayEngine::timerCallback()
+{
+    if (speed <= 0.0)
+    {
+        const auto sliceEnd = juce::Time::getMillisecondCounterHiRes() + replaySliceSeconds * 1000.0;
+        while (juce::Time::getMillisecondCounterHiRes() < sliceEnd && step()) {}
+    }
+    else
+    {
+        const auto elapsed = juce::Time::getMillisecondCounterHiRes() / 1000.0 - playStartClock;
+        const auto logTime = playStartLogTime + elapsed * speed;
+
+        while (position < getNumOperations() && getTimeOfOperation(position) <= logTime)
+            step();
+    }
+
+    if (position >= getNumOperations())
+        pause();
+}
+
+bool ReplayEngine::apply(const juce::ValueTree& op)
+{
+    const auto type = op[ChangeLogIds::type].toString();
+
+    if (type == ChangeLogIds::setProperty || type == ChangeLogIds::removeProperty)
+    {
+        auto node = findNode(op[ChangeLogIds::node]);
+        if (!node.isValid()) return false;
+
+        const juce::Identifier name{ op[ChangeLogIds::name].toString() };
+        if (type == ChangeLogIds::setProperty)
+            node.setProperty(name, op[ChangeLogIds::value], um);
+        else
+            node.removeProperty(name, um);
+
+        return true;
+    }
+
+    auto parent = findNode(op[ChangeLogIds::parent]);
+    if (!parent.isValid()) return false;
+
+    const int index = op[ChangeLogIds::index];
+
+    if (type == ChangeLogIds::addChild)
+    {
+        if (op.getNumChildren() != 1) return false;
+
+        auto child = op.getChild(0).createCopy();
+        mapSubtree(child, op[ChangeLogIds::ids].toString());
+        parent.addChild(child, index, um);
+        return true;
+    }
+
+    if (type == ChangeLogIds::removeChild)
+    {
+        if (!juce::isPositiveAndBelow(index, parent.getNumChildren())) return false;
+
+        parent.removeChild(index, um);
+        return true;
+    }
+
+    if (type == ChangeLogIds::moveChild)
+    {
+        const int oldIndex = op[ChangeLogIds::oldIndex];
+        if (!juce::isPositiveAndBelow(oldIndex, parent.getNumChildren())) return false;
+
+        parent.moveChild(oldIndex, index, um);
+        return true;
+    }
+
+    // Unknown types are turned down by load
+    return false;
+}
+
+juce::ValueTree ReplayEngine::findNode(const juce::var& id) const
+{
+    const auto it = nodes.find((juce::uint32)(juce::int64)id);
+    return it != nodes.end() ? it->second : juce::ValueTree{};
+}
+
+void ReplayEngine::mapSubtree(const juce::ValueTree& tree, const juce::String& ids)
+{
+    // Ids are listed in tree order, walk the subtree in the same order
+    const auto tokens = juce::StringArray::fromTokens(ids, false);
+    int next = 0;
+
+    std::function<void(const juce::ValueTree&)> visit = [&](const juce::ValueTree& node)
+    {
+        if (next < tokens.size())
+            nodes[(juce::uint32)tokens[next++].getLargeIntValue()] = node;
+
+        for (const auto& child : node)
+            visit(child);
+    };
+
+    visit(tree);
+}
+
+double ReplayEngine::getTimeOfOperation(int index) const
+{
+    return operations.getChild(index)[ChangeLogIds::time];
+}
+
+} // namespace vtdbg
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <functional>
+#include <unordered_map>
+
+namespace vtdbg
+{
+/* A change log is a value tree holding a copy of the tree when recording started,
+   and the operations applied to it since. Nodes are referred to by their mirror
+   node ids, the initial tree and added subtrees list the ids of their nodes in tree order.
+
+   <ChangeLog>
+     <Initial ids="1 2 3">...copy of the tree...</Initial>
+     <Operations>
+       <Op type="set" time="0.25" node="2" name="gain" value="0.5"/>
+       <Op type="add" time="0.50" parent="1" index="0" ids="7 8">...copy of the child...</Op>
+       ...
+*/
+namespace ChangeLogIds
+{
+const juce::Identifier changeLog{ "ChangeLog" };
+const juce::Identifier initial{ "Initial" };
+const juce::Identifier operations{ "Operations" };
+const juce::Identifier op{ "Op" };
+const juce::Identifier type{ "type" };
+const juce::Identifier time{ "time" };
+const juce::Identifier node{ "node" };
+const juce::Identifier parent{ "parent" };
+const juce::Identifier index{ "index" };
+const juce::Identifier oldIndex{ "oldIndex" };
+const juce::Identifier name{ "name" };
+const juce::Identifier value{ "value" };
+const juce::Identifier ids{ "ids" };
+
+const juce::String setProperty{ "set" };
+const juce::String removeProperty{ "unset" };
+const juce::String addChild{ "add" };
+const juce::String removeChild{ "remove" };
+const juce::String moveChild{ "move" };
+}
+
+/* Records the changes seen by the debugger into a change log */
+class ChangeRecorder
+{
+public:
+    void start(const FlatTreeModel& model);
+    /* Stop recording and return the log */
+    juce::ValueTree stop();
+    bool isRecording() const { return log.isValid(); }
+    int getNumOperations() const { return operations.getNumChildren(); }
+
+    // Called after the model has been updated
+    void propertyChanged(const FlatTreeModel& model, int node, const juce::Identifier& property);
+    void childAdded(const FlatTreeModel& model, int child, int index);
+    void childRemoved(const FlatTreeModel& model, int parentNode, int index);
+    void childMoved(const FlatTreeModel& model, int parentNode, int oldIndex, int newIndex);
+
+    static juce::String getSubtreeIds(const FlatTreeModel& model, int node);
+
+private:
+    juce::ValueTree addOperation(const juce::String& type);
+
+    juce::ValueTree log;
+    juce::ValueTree operations;
+    double startTime{ 0.0 };
+};
+
+/* Applies a change log to a target tree, in real time, faster, or as fast as possible.
+   Loading only reads the log. The target is reset to the initial state of the log when
+   playback or stepping starts, which a UI should confirm first as it replaces the tree. */
+class ReplayEngine : private juce::Timer
+{
+public:
+    ~ReplayEngine() override;
+
+    /* Fails on a log which isn't complete or has operations of an unknown type */
+    juce::Result load(const juce::ValueTree& changeLog);
+    bool isLoaded() const { return operations.isValid(); }
+
+    /* Where the next playback applies the log, left as it is until then */
+    void setTarget(juce::ValueTree targetTree, juce::UndoManager* undoManager);
+    /* Back to the first operation, the target is reset again when playback starts */
+    void rewind();
+    /* Whether the target has been reset for this pass over the log, and so changed */
+    bool hasStarted() const { return targetReset; }
+    /* While an operation is being applied to the target, so its changes aren't recorded again */
+    bool isApplying() const { return applying; }
+
+    void play();
+    void pause();
+    bool isPlaying() const { return isTimerRunning(); }
+    /* Apply the next operation, returns false at the end of the log */
+    bool step();
+    /* Apply all remaining operations at once, returns the time it took in seconds */
+    double runToEnd();
+
+    /* Speed relative to the recording, 0 replays as fast as possible */
+    void setSpeed(double newSpeed);
+    double getSpeed() const { return speed; }
+
+    int getPosition() const { return position; }
+    int getNumOperations() const { return operations.getNumChildren(); }
+    /* Operations whose nodes could not be found in the target */
+    int getNumFailed() const { return numFailed; }
+
+    /* Called when playback stops or the position changes through the controls */
+    std::function<void()> onStateChanged;
+
+private:
+    void timerCallback() override;
+    /* Reset the target to the initial state of the log, as one undo transaction */
+    void resetTarget();
+    bool apply(const juce::ValueTree& op);
+    juce::ValueTree findNode(const juce::var& id) const;
+    void mapSubtree(const juce::ValueTree& tree, const juce::String& ids);
+    double getTimeOfOperation(int index) const;
+
+    juce::ValueTree initial;
+    juce::ValueTree operations;
+    juce::ValueTree target;
+    juce::UndoManager* um{ nullptr };
+    std::unordered_map<juce::uint32, juce::ValueTree> nodes;
+
+    int position{ 0 };
+    int numFailed{ 0 };
+    bool targetReset{ false };
+    bool applying{ false };
+    double speed{ 1.0 };
+    double playStartClock{ 0.0 };
+    double playStartLogTime{ 0.0 };
+};
+
+} // namespace vtdbg
@@ -0,0 +1,252 @@
+#include "ExclusionFilter.h"
+
+namespace vtdbg
+{
+const juce::Array<juce::Identifier> ExclusionFilter::identifyingProperties{ "id", "uid", "uuid", "name" };
+
+void ExclusionFilter::excludeType(const juce::Identifier& type)
+{
+    types.insert(type);
+}
+
+void ExclusionFilter::excludeSubtree(const juce::ValueTree& subtree)
+{
+    if (!subtree.isValid() || !subtreePaths.addIfNotAlreadyThere(getPath(subtree))) return;
+
+    subtrees.insert(subtree);
+}
+
+void ExclusionFilter::excludeProperty(const juce::Identifier& property)
+{
+    properties.insert(property);
+}
+
+void ExclusionFilter::clear()
+{
+    types.clear();
+    properties.clear();
+    subtreePaths.clear();
+    subtrees.clear();
+}
+
+int ExclusionFilter::getNumRules() const
+{
+    return static_cast<int>(types.size() + properties.size()) + subtreePaths.size();
+}
+
+int ExclusionFilter::getNumPositionalRules() const
+{
+    int count{ 0 };
+    for (const auto& path : subtreePaths)
+        if (isPositional(path))
+            ++count;
+
+    return count;
+}
+
+juce::String ExclusionFilter::describe() const
+{
+    juce::StringArray lines;
+    for (const auto& type : types)
+        lines.add("Every " + type.toString());
+
+    lines.addArray(subtreePaths);
+
+    for (const auto& property : properties)
+        lines.add("Property " + property.toString());
+
+    return lines.joinIntoString("\n");
+}
+
+void ExclusionFilter::setRoot(const juce::ValueTree& rootTree)
+{
+    root = rootTree;
+    subtrees.clear();
+
+    // A path whose subtree isn't in this tree stays a rule for trees which have it
+    for (const auto& path : subtreePaths)
+    {
+        const auto subtree = findPath(root, path);
+        if (subtree.isValid())
+            subtrees.insert(subtree);
+    }
+}
+
+bool ExclusionFilter::isExcludedRoot(const juce::ValueTree& tree) const
+{
+    return (!types.empty() && types.count(tree.getType()) > 0)
+        || (!subtrees.empty() && subtrees.count(tree) > 0);
+}
+
+bool ExclusionFilter::isInExcludedSubtree(const juce::ValueTree& tree) const
+{
+    if (!hasSubtreeRules()) return false;
+
+    for (auto node = tree; node.isValid(); node = node.getParent())
+        if (isExcludedRoot(node))
+            return true;
+
+    return false;
+}
+
+juce::ValueTree ExclusionFilter::toValueTree() const
+{
+    juce::ValueTree rules{ ExclusionIds::rules };
+
+    for (const auto& type : types)
+        rules.appendChild(juce::ValueTree{ ExclusionIds::type, { { ExclusionIds::name, type.toString() } } }, nullptr);
+
+    for (const auto& path : subtreePaths)
+        rules.appendChild(juce::ValueTree{ ExclusionIds::subtree, { { ExclusionIds::path, path } } }, nullptr);
+
+    for (const auto& property : properties)
+        rules.appendChild(juce::ValueTree{ ExclusionIds::property, { { ExclusionIds::name, property.toString() } } }, nullptr);
+
+    return rules;
+}
+
+void ExclusionFilter::fromValueTree(const juce::ValueTree& rules)
+{
+    clear();
+
+    for (const auto& rule : rules)
+    {
+        const auto name = rule[ExclusionIds::name].toString();
+
+        if (rule.hasType(ExclusionIds::type) && juce::Identifier::isValidIdentifier(name))
+            types.insert(name);
+        else if (rule.hasType(ExclusionIds::property) && juce::Identifier::isValidIdentifier(name))
+            properties.insert(name);
+        else if (rule.hasType(ExclusionIds::subtree))
+            subtreePaths.addIfNotAlreadyThere(rule[ExclusionIds::path].toString());
+    }
+
+    setRoot(root);
+}
+
+juce::Result ExclusionFilter::save(const juce::File& file) const
+{
+    const auto result = file.getParentDirectory().createDirectory();
+    if (result.failed()) return result;
+
+    if (!file.replaceWithText(toValueTree().toXmlString()))
+        return juce::Result::fail("Could not write " + file.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+juce::Result ExclusionFilter::load(const juce::File& file)
+{
+    if (!file.existsAsFile())
+    {
+        clear();
+        return juce::Result::ok();
+    }
+
+    const auto rules = juce::ValueTree::fromXml(file.loadFileAsString());
+    if (!rules.hasType(ExclusionIds::rules))
+        return juce::Result::fail(file.getFullPathName() + " has no exclusion rules");
+
+    fromValueTree(rules);
+    return juce::Result::ok();
+}
+
+juce::File ExclusionFilter::getDefaultFile(const juce::Identifier& rootType)
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("ValueTreeDebugger")
+        .getChildFile("Exclusions")
+        .getChildFile(juce::File::createLegalFileName(rootType.toString()) + ".xml");
+}
+
+/* The step of a path naming the child among its siblings */
+static juce::String getStep(const juce::ValueTree& parent, const juce::ValueTree& child)
+{
+    for (const auto& name : ExclusionFilter::identifyingProperties)
+    {
+        const auto* value = child.getPropertyPointer(name);
+        if (value == nullptr) continue;
+
+        // The value is written in the path as it is, so it can't hold the path's separators
+        const auto text = value->toString();
+        if (text.isEmpty() || text.containsAnyOf("/[]")) continue;
+
+        bool unique{ true };
+        for (const auto& sibling : parent)
+        {
+            if (sibling != child && sibling.hasType(child.getType()) && sibling[name].toString() == text)
+            {
+                unique = false;
+                break;
+            }
+        }
+
+        if (unique)
+            return child.getType().toString() + "[@" + name.toString() + "=" + text + "]";
+    }
+
+    return child.getType().toString() + "[" + juce::String{ parent.indexOf(child) } + "]";
+}
+
+juce::String ExclusionFilter::getPath(const juce::ValueTree& tree)
+{
+    juce::String path;
+    auto node = tree;
+    for (auto parent = node.getParent(); parent.isValid(); parent = node.getParent())
+    {
+        path = "/" + getStep(parent, node) + path;
+        node = parent;
+    }
+
+    return "/" + node.getType().toString() + path;
+}
+
+bool ExclusionFilter::isPositional(const juce::String& path)
+{
+    for (const auto& step : juce::StringArray::fromTokens(path, "/", {}))
+        if (step.containsChar('[') && !step.contains("[@"))
+            return true;
+
+    return false;
+}
+
+juce::ValueTree ExclusionFilter::findPath(const juce::ValueTree& rootTree, const juce::String& path)
+{
+    const auto steps = juce::StringArray::fromTokens(path, "/", {});
+    if (steps.size() < 2 || steps[0].isNotEmpty() || rootTree.getType().toString() != steps[1]) return {};
+
+    auto node = rootTree;
+    for (int i = 2; i < steps.size() && node.isValid(); ++i)
+    {
+        const auto& step = steps[i];
+        const auto type = step.upToFirstOccurrenceOf("[", false, false);
+        const auto selector = step.fromFirstOccurrenceOf("[", false, false).upToLastOccurrenceOf("]", false, false);
+
+        if (selector.startsWithChar('@'))
+        {
+            const auto name = selector.substring(1).upToFirstOccurrenceOf("=", false, false);
+            const auto value = selector.fromFirstOccurrenceOf("=", false, false);
+            if (!juce::Identifier::isValidIdentifier(name)) return {};
+
+            auto parent = node;
+            node = {};
+            for (const auto& child : parent)
+            {
+                if (child.getType().toString() == type && child[juce::Identifier{ name }].toString() == value)
+                {
+                    node = child;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            node = node.getChild(selector.getIntValue());
+            if (node.getType().toString() != type) return {};
+        }
+    }
+
+    return node;
+}
+
+} // namespace vtdbg
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <unordered_set>
+
+namespace vtdbg
+{
+/* Identifiers of the saved rules */
+namespace ExclusionIds
+{
+const juce::Identifier rules{ "ExclusionRules" };
+const juce::Identifier type{ "Type" };
+const juce::Identifier subtree{ "Subtree" };
+const juce::Identifier property{ "Property" };
+const juce::Identifier name{ "name" };
+const juce::Identifier path{ "path" };
+} // namespace ExclusionIds
+
+/* Subtrees and properties the debugger leaves out, such as meters and transient UI state. A change
+   to them costs one check in the listener and nothing more: excluded subtrees aren't mirrored
+   beyond their root, and their changes never reach the model or the view.
+   Subtrees are excluded by type, every Meter wherever it is, or one at a time by path. Properties
+   are excluded by name wherever they are. The rules are saved as XML to outlast the session, one
+   file per type of root, so the rules of one tree don't apply to another. */
+class ExclusionFilter
+{
+public:
+    void excludeType(const juce::Identifier& type);
+    /* Kept as the path from the root, see getPath */
+    void excludeSubtree(const juce::ValueTree& subtree);
+    void excludeProperty(const juce::Identifier& property);
+    void clear();
+
+    bool isEmpty() const { return getNumRules() == 0; }
+    int getNumRules() const;
+    /* Subtree rules whose path has a step by position, which points elsewhere once children are
+       added, removed or moved, in this session or the next */
+    int getNumPositionalRules() const;
+    /* One rule per line */
+    juce::String describe() const;
+
+    /* Find the subtrees of the path rules in the tree, after it is set */
+    void setRoot(const juce::ValueTree& rootTree);
+
+    // Change path, checked before anything else
+    bool isExcludedProperty(const juce::Identifier& property) const { return !properties.empty() && properties.count(property) > 0; }
+    bool hasSubtreeRules() const { return !types.empty() || !subtrees.empty(); }
+    /* Whether the tree is the root of an excluded subtree, shown as a placeholder. Two hash lookups,
+       the model keeps the answer for each node it mirrors, see FlatTreeModel::isExcluded. */
+    bool isExcludedRoot(const juce::ValueTree& tree) const;
+    /* Whether the tree is an excluded subtree or inside one, a walk to the root. For trees the model
+       doesn't mirror yet, the others are answered by the model. */
+    bool isInExcludedSubtree(const juce::ValueTree& tree) const;
+
+    juce::ValueTree toValueTree() const;
+    void fromValueTree(const juce::ValueTree& rules);
+    juce::Result save(const juce::File& file) const;
+    /* A missing file is no rules */
+    juce::Result load(const juce::File& file);
+    /* Where the debugger keeps the rules for trees of a root type between sessions */
+    static juce::File getDefaultFile(const juce::Identifier& rootType);
+
+    /* Steps of types and, to tell siblings of one type apart, the first of identifyingProperties
+       whose value is unique among them, such as /Session/Track[@id=3]/Meter. Only without one is the
+       position used, /Session/Track[2]/Meter[0]. */
+    static juce::String getPath(const juce::ValueTree& tree);
+    static juce::ValueTree findPath(const juce::ValueTree& rootTree, const juce::String& path);
+    static bool isPositional(const juce::String& path);
+
+    static const juce::Array<juce::Identifier> identifyingProperties;
+
+private:
+    std::unordered_set<juce::Identifier, IdentifierHash> types;
+    std::unordered_set<juce::Identifier, IdentifierHash> properties;
+    juce::StringArray subtreePaths;
+    /* The subtrees of the path rules found in the current tree */
+    std::unordered_set<juce::ValueTree, ValueTreeHash> subtrees;
+    juce::ValueTree root;
+};
+
+} // namespace vtdbg
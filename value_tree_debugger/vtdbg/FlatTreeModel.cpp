@@ -0,0 +1,824 @@
+#include "FlatTreeModel.h"
+
+namespace vtdbg
+{
+/* Spreads the bits of a hash, so sums of hashes stay well distributed (the splitmix64 finaliser) */
+static juce::uint64 mixHash(juce::uint64 x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+/* Hash of a value including its type, so 1 and 1.0 differ */
+static juce::uint64 hashVar(const juce::var& value)
+{
+    if (value.isString())
+        return mixHash(1 + (juce::uint64)value.toString().hashCode64());
+
+    if (value.isInt() || value.isInt64())
+        return mixHash(2 + (juce::uint64)(juce::int64)value);
+
+    if (value.isBool())
+        return mixHash(3 + (value ? 1u : 0u));
+
+    if (value.isDouble())
+    {
+        const double number = value;
+        juce::uint64 bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        return mixHash(4 + bits);
+    }
+
+    if (auto* block = value.getBinaryData())
+    {
+        juce::uint64 hash = 5;
+        for (size_t i = 0; i < block->getSize(); ++i)
+            hash = hash * 1099511628211ull + (juce::uint8)(*block)[i];
+
+        return mixHash(hash);
+    }
+
+    if (auto* array = value.getArray())
+    {
+        juce::uint64 hash = 6;
+        for (const auto& element : *array)
+            hash = mixHash(hash * 31 + hashVar(element));
+
+        return hash;
+    }
+
+    // Void, undefined, and objects and methods, which are compared by type only
+    if (value.isVoid())      return mixHash(7);
+    if (value.isUndefined()) return mixHash(8);
+    if (value.isMethod())    return mixHash(9);
+    return mixHash(10);
+}
+
+void FlatTreeModel::rebuild(const juce::ValueTree& rootTree)
+{
+    clear();
+
+    if (rootTree.isValid())
+        root = addSubtree(rootTree, none, 0);
+}
+
+void FlatTreeModel::beginRebuild(const juce::ValueTree& rootTree)
+{
+    clear();
+
+    if (!rootTree.isValid()) return;
+
+    root = mirrorNode(rootTree, 0);
+    buildQueue.push_back(nodeIds[(size_t)root]);
+}
+
+bool FlatTreeModel::buildStep(double deadlineMs, juce::Array<int>& expandedNodes)
+{
+    // Checking the clock costs more than mirroring a node, so only look every few nodes
+    constexpr int nodesPerClockCheck{ 16 };
+    int sinceClockCheck{ 0 };
+
+    const auto pastDeadline = [&]()
+    {
+        if (++sinceClockCheck < nodesPerClockCheck) return false;
+
+        sinceClockCheck = 0;
+        return juce::Time::getMillisecondCounterHiRes() >= deadlineMs;
+    };
+
+    if (!buildQueue.empty())
+        ++generation;
+
+    while (!buildQueue.empty())
+    {
+        const auto node = findNode(buildQueue.front());
+        if (node == none)
+        {
+            // Removed before its turn came
+            buildQueue.pop_front();
+            continue;
+        }
+
+        // A copy, the handle array can grow while the children are added
+        const auto tree = handles[(size_t)node];
+        if (isExcluded(node))
+        {
+            buildQueue.pop_front();
+            continue;
+        }
+
+        auto lastChild = numChildren[(size_t)node] > 0 ? getChild(node, numChildren[(size_t)node] - 1) : none;
+        bool expanded{ false };
+
+        // Children are mirrored in order, edits keep the mirrored ones a prefix of the tree's
+        while (numChildren[(size_t)node] < tree.getNumChildren())
+        {
+            if (pastDeadline())
+            {
+                if (expanded)
+                {
+                    expandedNodes.add(node);
+                    updateHashesUpwards(node);
+                }
+
+                return true;
+            }
+
+            const auto child = mirrorNode(tree.getChild(numChildren[(size_t)node]), depths[(size_t)node] + 1);
+            parents[(size_t)child] = node;
+
+            if (lastChild == none)
+                firstChildren[(size_t)node] = child;
+            else
+                nextSiblings[(size_t)lastChild] = child;
+
+            lastChild = child;
+            positions[(size_t)child] = numChildren[(size_t)node]++;
+            childLists[(size_t)node].push_back(child);
+            childHashSums[(size_t)node] += getChildTerm(child);
+            buildQueue.push_back(nodeIds[(size_t)child]);
+            expanded = true;
+        }
+
+        if (expanded)
+        {
+            expandedNodes.add(node);
+            updateHashesUpwards(node);
+        }
+        buildQueue.pop_front();
+
+        if (pastDeadline())
+            return !buildQueue.empty();
+    }
+
+    return false;
+}
+
+void FlatTreeModel::clear()
+{
+    // Handles are looked up by their shared object, see ValueTreeHash
+    static const bool handleLayoutAsExpected = ValueTreeHash::isLayoutAsExpected();
+    jassert(handleLayoutAsExpected);
+    juce::ignoreUnused(handleLayoutAsExpected);
+
+    root = none;
+    numLiveNodes = 0;
+    ++generation;
+
+    parents.clear();
+    firstChildren.clear();
+    nextSiblings.clear();
+    numChildren.clear();
+    positions.clear();
+    contentHashes.clear();
+    childHashSums.clear();
+    subtreeHashes.clear();
+    depths.clear();
+    types.clear();
+    propStarts.clear();
+    propCounts.clear();
+    typeSlots.clear();
+    excludedFlags.clear();
+    nodeIds.clear();
+    handles.clear();
+    childLists.clear();
+    freeNodes.clear();
+    nodeIndices.clear();
+    handleIndices.clear();
+    buildQueue.clear();
+    removedSubtrees.clear();
+    numRemovedNodes = 0;
+
+    propNames.clear();
+    propValues.clear();
+    propSlots.clear();
+    deadProperties = 0;
+
+    // The identifiers stay interned, so their lists are kept
+    for (auto& nodes : nodesOfType) nodes.clear();
+    for (auto& nodes : nodesWithProperty) nodes.clear();
+}
+
+std::shared_ptr<const FlatTreeModel> FlatTreeModel::createSnapshot() const
+{
+    auto snapshot = std::make_shared<FlatTreeModel>();
+    snapshot->root = root;
+    snapshot->numLiveNodes = numLiveNodes;
+    snapshot->nextNodeId = nextNodeId;
+    snapshot->generation = generation;
+
+    // Only the shared arrays, the rest would be a deep copy on the message thread.
+    // Value trees are only safe to touch there anyway.
+    snapshot->parents = parents;
+    snapshot->firstChildren = firstChildren;
+    snapshot->nextSiblings = nextSiblings;
+    snapshot->numChildren = numChildren;
+    snapshot->depths = depths;
+    snapshot->types = types;
+    snapshot->propStarts = propStarts;
+    snapshot->propCounts = propCounts;
+    snapshot->nodeIds = nodeIds;
+    snapshot->propNames = propNames;
+    snapshot->propValues = propValues;
+    snapshot->deadProperties = deadProperties;
+
+    // Few, one per distinct type and property name
+    snapshot->identifiers = identifiers;
+    return snapshot;
+}
+
+int FlatTreeModel::propertyChanged(const juce::ValueTree& tree, const juce::Identifier& property)
+{
+    const auto node = findNode(tree);
+    if (node == none) return none;
+
+    ++generation;
+
+    const auto nameIndex = intern(property);
+    const auto start = propStarts[(size_t)node];
+    const auto count = propCounts[(size_t)node];
+
+    for (int i = start; i < start + count; ++i)
+    {
+        if (propNames[(size_t)i] != nameIndex) continue;
+
+        contentHashes[(size_t)node] -= getPropertyHash(nameIndex, propValues[(size_t)i]);
+
+        if (const auto* value = tree.getPropertyPointer(property))
+        {
+            propValues[(size_t)i] = *value;
+            contentHashes[(size_t)node] += getPropertyHash(nameIndex, *value);
+        }
+        else
+        {
+            // Removed: close the gap, keeping the tree's property order
+            unindexProperty(node, i);
+            for (int j = i; j < start + count - 1; ++j)
+            {
+                propNames[(size_t)j] = propNames[(size_t)(j + 1)];
+                propValues[(size_t)j] = std::move(propValues[(size_t)(j + 1)]);
+            }
+            std::move(propSlots.begin() + i + 1, propSlots.begin() + start + count, propSlots.begin() + i);
+            propValues[(size_t)(start + count - 1)] = juce::var{};
+            --propCounts[(size_t)node];
+            ++deadProperties;
+        }
+
+        updateHashesUpwards(node);
+        return node;
+    }
+
+    // Added: properties are appended to the end of the tree's set
+    if (const auto* value = tree.getPropertyPointer(property))
+    {
+        if ((size_t)(start + count) != propNames.size())
+        {
+            // Move the range to the end of the arrays so it can grow, the slots may reallocate
+            propSlots.reserve(propSlots.size() + (size_t)count + 1);
+            propStarts[(size_t)node] = static_cast<int>(propNames.size());
+            for (int i = start; i < start + count; ++i)
+            {
+                propNames.push_back(propNames[(size_t)i]);
+                propValues.push_back(propValues[(size_t)i]);
+                propSlots.push_back(propSlots[(size_t)i]);
+            }
+            deadProperties += (size_t)count;
+        }
+
+        propNames.push_back(nameIndex);
+        propValues.push_back(*value);
+        propSlots.push_back(0);
+        indexProperty(node, static_cast<int>(propNames.size()) - 1);
+        ++propCounts[(size_t)node];
+        contentHashes[(size_t)node] += getPropertyHash(nameIndex, *value);
+        updateHashesUpwards(node);
+
+        if (deadProperties > 1024 && deadProperties > propNames.size() / 2)
+            compactProperties();
+    }
+
+    return node;
+}
+
+int FlatTreeModel::childAdded(const juce::ValueTree& parentTree, const juce::ValueTree& child, bool undoingOrRedoing)
+{
+    const auto parentNode = findNode(parentTree);
+    if (parentNode == none) return none;
+
+    // While the parent is still being built only its first children are mirrored,
+    // a child added beyond them is picked up when the build reaches it
+    const auto index = parentTree.indexOf(child);
+    const auto numMirrored = numChildren[(size_t)parentNode];
+    if (index > numMirrored || (index == numMirrored && numMirrored + 1 < parentTree.getNumChildren()))
+        return none;
+
+    ++generation;
+    return addSubtree(child, parentNode, index, undoingOrRedoing);
+}
+
+int FlatTreeModel::childRemoved(const juce::ValueTree& parentTree, int index)
+{
+    const auto parentNode = findNode(parentTree);
+    if (parentNode == none) return none;
+
+    const auto child = getChild(parentNode, index);
+    if (child == none) return none;
+
+    ++generation;
+    unlinkChild(child);
+    rememberRemovedSubtree(child);
+    freeSubtree(child);
+    childrenHashesChanged(parentNode);
+    return parentNode;
+}
+
+int FlatTreeModel::childOrderChanged(const juce::ValueTree& parentTree, int oldIndex, int newIndex)
+{
+    const auto parentNode = findNode(parentTree);
+    if (parentNode == none) return none;
+
+    // Only differs from a complete node while the parent is still being built
+    const auto numMirrored = numChildren[(size_t)parentNode];
+    const bool wasMirrored = oldIndex < numMirrored;
+    const bool isMirrored = newIndex < numMirrored;
+
+    if (!wasMirrored && !isMirrored) return none;
+
+    ++generation;
+
+    if (!wasMirrored)
+    {
+        // Moved into the mirrored children
+        addSubtree(parentTree.getChild(newIndex), parentNode, newIndex);
+        return parentNode;
+    }
+
+    const auto child = getChild(parentNode, oldIndex);
+    unlinkChild(child);
+
+    if (isMirrored)
+        linkChild(parentNode, child, newIndex);
+    else
+        freeSubtree(child); // Moved beyond them, the build mirrors it again when it gets there
+
+    childrenHashesChanged(parentNode);
+    return parentNode;
+}
+
+int FlatTreeModel::findNode(const juce::ValueTree& tree) const
+{
+    if (root == none || !tree.isValid()) return none;
+
+    const auto it = handleIndices.find(tree);
+    return it != handleIndices.end() ? it->second : none;
+}
+
+int FlatTreeModel::findNode(NodeId id) const
+{
+    const auto it = nodeIndices.find(id);
+    return it != nodeIndices.end() ? it->second : none;
+}
+
+int FlatTreeModel::intern(const juce::Identifier& id)
+{
+    const auto it = identifierIndices.find(id);
+    if (it != identifierIndices.end()) return it->second;
+
+    const auto index = static_cast<int>(identifiers.size());
+    identifiers.push_back(id);
+    identifierHashes.push_back(mixHash((juce::uint64)id.toString().hashCode64()));
+    identifierIndices.emplace(id, index);
+    nodesOfType.emplace_back();
+    nodesWithProperty.emplace_back();
+    return index;
+}
+
+bool FlatTreeModel::isContentCurrent(int node) const
+{
+    const auto& tree = handles[(size_t)node];
+    if (tree.getNumProperties() != propCounts[(size_t)node]) return false;
+
+    const auto contentHash = hashContent(tree);
+    return contentHash != 0 && contentHash == contentHashes[(size_t)node];
+}
+
+juce::uint64 FlatTreeModel::hashContent(const juce::ValueTree& tree) const
+{
+    const auto typeIndex = findIdentifier(tree.getType());
+    if (typeIndex == none) return 0;
+
+    auto contentHash = identifierHashes[(size_t)typeIndex];
+    for (int i = 0; i < tree.getNumProperties(); ++i)
+    {
+        const auto& name = tree.getPropertyName(i);
+        const auto nameIndex = findIdentifier(name);
+        if (nameIndex == none) return 0;
+
+        contentHash += getPropertyHash(nameIndex, *tree.getPropertyPointer(name));
+    }
+
+    return contentHash;
+}
+
+int FlatTreeModel::findIdentifier(const juce::Identifier& id) const
+{
+    const auto it = identifierIndices.find(id);
+    return it != identifierIndices.end() ? it->second : none;
+}
+
+int FlatTreeModel::allocateNode(NodeId reusedId)
+{
+    int node;
+
+    if (!freeNodes.empty())
+    {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    else
+    {
+        node = getCapacity();
+        parents.push_back(none);
+        firstChildren.push_back(none);
+        nextSiblings.push_back(none);
+        numChildren.push_back(0);
+        positions.push_back(0);
+        contentHashes.push_back(0);
+        childHashSums.push_back(0);
+        subtreeHashes.push_back(0);
+        depths.push_back(0);
+        types.push_back(0);
+        propStarts.push_back(0);
+        propCounts.push_back(0);
+        typeSlots.push_back(0);
+        excludedFlags.push_back(0);
+        nodeIds.push_back(0);
+        handles.emplace_back();
+        childLists.emplace_back();
+    }
+
+    parents[(size_t)node] = none;
+    firstChildren[(size_t)node] = none;
+    nextSiblings[(size_t)node] = none;
+    numChildren[(size_t)node] = 0;
+    positions[(size_t)node] = 0;
+    childHashSums[(size_t)node] = 0;
+    childLists[(size_t)node].clear();
+    const bool canReuse = reusedId != 0 && nodeIndices.find(reusedId) == nodeIndices.end();
+    nodeIds[(size_t)node] = canReuse ? reusedId : nextNodeId++;
+    nodeIndices[nodeIds[(size_t)node]] = node;
+    ++numLiveNodes;
+    return node;
+}
+
+int FlatTreeModel::addSubtree(const juce::ValueTree& tree, int parentNode, int index, bool undoingOrRedoing)
+{
+    // A subtree coming back keeps the ids it had, wherever its nodes are unchanged
+    bool trusted{ false };
+    const auto matches = [&](const RemovedNode& removed, const juce::ValueTree& node)
+    {
+        if (removed.object != ValueTreeHash::getObject(node)) return false;
+        return trusted || (removed.numChildren == node.getNumChildren() && removed.contentHash == hashContent(node));
+    };
+
+    std::vector<RemovedNode> previousIds;
+    for (auto it = removedSubtrees.rbegin(); it != removedSubtrees.rend(); ++it)
+    {
+        // Added by the change right after its removal, childAdded has counted this one already
+        trusted = undoingOrRedoing || it->generation + 1 == generation;
+        if (matches(it->nodes.front(), tree))
+        {
+            numRemovedNodes -= it->nodes.size();
+            previousIds = std::move(it->nodes);
+            removedSubtrees.erase(std::next(it).base());
+            break;
+        }
+    }
+
+    size_t position{ 0 };
+    const auto getPreviousId = [&](const juce::ValueTree& node) -> NodeId
+    {
+        const auto i = position++;
+        return i < previousIds.size() && matches(previousIds[i], node) ? previousIds[i].id : 0;
+    };
+
+    const auto top = mirrorNode(tree, parentNode == none ? 0 : depths[(size_t)parentNode] + 1, getPreviousId(tree));
+
+    if (parentNode != none)
+        linkChild(parentNode, top, index);
+
+    // Children are appended in order, so each link is O(1)
+    struct Pending { int node; int lastChild; int nextIndex; };
+    std::vector<Pending> stack;
+    if (!isExcluded(top))
+        stack.push_back({ top, none, 0 });
+    std::vector<int> added{ top };
+
+    while (!stack.empty())
+    {
+        auto& pending = stack.back();
+        const auto& parentTree = handles[(size_t)pending.node];
+
+        if (pending.nextIndex >= parentTree.getNumChildren())
+        {
+            stack.pop_back();
+            continue;
+        }
+
+        const auto childTree = parentTree.getChild(pending.nextIndex++);
+        const auto parent = pending.node;
+        const auto child = mirrorNode(childTree, depths[(size_t)parent] + 1, getPreviousId(childTree));
+        parents[(size_t)child] = parent;
+
+        if (pending.lastChild == none)
+            firstChildren[(size_t)parent] = child;
+        else
+            nextSiblings[(size_t)pending.lastChild] = child;
+
+        pending.lastChild = child;
+        positions[(size_t)child] = numChildren[(size_t)parent]++;
+        childLists[(size_t)parent].push_back(child);
+        added.push_back(child);
+
+        // pending is invalidated by the push
+        if (!isExcluded(child))
+            stack.push_back({ child, none, 0 });
+    }
+
+    // Children come after their parent in tree order, so in reverse every subtree is done before its parent
+    for (auto it = added.rbegin(); it != added.rend(); ++it)
+    {
+        computeSubtreeHash(*it);
+        if (*it != top)
+            childHashSums[(size_t)parents[(size_t)*it]] += getChildTerm(*it);
+    }
+
+    if (parentNode != none)
+        childrenHashesChanged(parentNode);
+
+    return top;
+}
+
+int FlatTreeModel::mirrorNode(const juce::ValueTree& tree, int depth, NodeId reusedId)
+{
+    const auto node = allocateNode(reusedId);
+    handles[(size_t)node] = tree;
+    handleIndices[tree] = node;
+    excludedFlags[(size_t)node] = isSubtreeExcluded && isSubtreeExcluded(tree) ? 1 : 0;
+    types[(size_t)node] = intern(tree.getType());
+    depths[(size_t)node] = depth;
+    indexType(node);
+    copyProperties(node, tree);
+
+    auto contentHash = identifierHashes[(size_t)types[(size_t)node]];
+    for (int i = 0; i < propCounts[(size_t)node]; ++i)
+        contentHash += getPropertyHash(getPropertyNameIndex(node, i), getPropertyValue(node, i));
+
+    contentHashes[(size_t)node] = contentHash;
+    computeSubtreeHash(node);
+    return node;
+}
+
+juce::uint64 FlatTreeModel::getPropertyHash(int nameIndex, const juce::var& value) const
+{
+    // Summed per node, so the order of the properties doesn't matter
+    return mixHash(identifierHashes[(size_t)nameIndex] * 31 + hashVar(value));
+}
+
+juce::uint64 FlatTreeModel::getChildTerm(int child) const
+{
+    // The position is mixed in, so reordering children changes the sum
+    return mixHash(subtreeHashes[(size_t)child] + (juce::uint64)positions[(size_t)child] * 0x9e3779b97f4a7c15ull);
+}
+
+void FlatTreeModel::computeSubtreeHash(int node)
+{
+    subtreeHashes[(size_t)node] = mixHash(contentHashes[(size_t)node] ^ mixHash(childHashSums[(size_t)node] + (juce::uint64)numChildren[(size_t)node]));
+}
+
+void FlatTreeModel::updateHashesUpwards(int node)
+{
+    // Each ancestor swaps the old term of the child on the path for the new one, O(depth)
+    for (;;)
+    {
+        const auto oldTerm = getChildTerm(node);
+        computeSubtreeHash(node);
+
+        const auto parent = parents[(size_t)node];
+        if (parent == none) return;
+
+        childHashSums[(size_t)parent] += getChildTerm(node) - oldTerm;
+        node = parent;
+    }
+}
+
+void FlatTreeModel::childrenHashesChanged(int parentNode)
+{
+    // Positions have shifted, so the sum is rebuilt, O(children) then O(depth)
+    juce::uint64 sum{ 0 };
+    for (auto child = firstChildren[(size_t)parentNode]; child != none; child = nextSiblings[(size_t)child])
+        sum += getChildTerm(child);
+
+    childHashSums[(size_t)parentNode] = sum;
+    updateHashesUpwards(parentNode);
+}
+
+void FlatTreeModel::rememberRemovedSubtree(int node)
+{
+    RemovedSubtree removed;
+    removed.generation = generation;
+    forEachInSubtree(node, [&](int n)
+    {
+        // The tree's own count, which includes children not mirrored yet
+        if (removed.nodes.size() < maxRemovedNodes)
+            removed.nodes.push_back({ ValueTreeHash::getObject(handles[(size_t)n]), contentHashes[(size_t)n],
+                                      handles[(size_t)n].getNumChildren(), nodeIds[(size_t)n] });
+    });
+
+    numRemovedNodes += removed.nodes.size();
+    removedSubtrees.push_back(std::move(removed));
+
+    // The oldest go first, the newest is always kept
+    while (removedSubtrees.size() > 1 && (removedSubtrees.size() > maxRemovedSubtrees || numRemovedNodes > maxRemovedNodes))
+    {
+        numRemovedNodes -= removedSubtrees.front().nodes.size();
+        removedSubtrees.pop_front();
+    }
+}
+
+void FlatTreeModel::freeSubtree(int node)
+{
+    juce::Array<int> toFree;
+    forEachInSubtree(node, [&](int n) { toFree.add(n); });
+
+    for (auto n : toFree)
+    {
+        unindexNode(n);
+        nodeIndices.erase(nodeIds[(size_t)n]);
+        nodeIds[(size_t)n] = 0;
+        handleIndices.erase(handles[(size_t)n]);
+        handles[(size_t)n] = juce::ValueTree{};
+        childLists[(size_t)n].clear();
+        deadProperties += (size_t)propCounts[(size_t)n];
+        propCounts[(size_t)n] = 0;
+        freeNodes.push_back(n);
+        --numLiveNodes;
+    }
+
+    if (node == root)
+        root = none;
+}
+
+void FlatTreeModel::linkChild(int parentNode, int child, int index)
+{
+    parents[(size_t)child] = parentNode;
+
+    if (index < 0 || index > numChildren[(size_t)parentNode])
+        index = numChildren[(size_t)parentNode];
+
+    auto& children = childLists[(size_t)parentNode];
+
+    if (index == 0)
+    {
+        nextSiblings[(size_t)child] = firstChildren[(size_t)parentNode];
+        firstChildren[(size_t)parentNode] = child;
+    }
+    else
+    {
+        const auto previous = children[(size_t)(index - 1)];
+        nextSiblings[(size_t)child] = nextSiblings[(size_t)previous];
+        nextSiblings[(size_t)previous] = child;
+    }
+
+    children.insert(children.begin() + index, child);
+    ++numChildren[(size_t)parentNode];
+
+    for (int position = index; child != none; child = nextSiblings[(size_t)child])
+        positions[(size_t)child] = position++;
+}
+
+void FlatTreeModel::unlinkChild(int child)
+{
+    const auto parentNode = parents[(size_t)child];
+    if (parentNode == none) return;
+
+    auto& children = childLists[(size_t)parentNode];
+    const auto position = positions[(size_t)child];
+
+    if (position == 0)
+        firstChildren[(size_t)parentNode] = nextSiblings[(size_t)child];
+    else
+        nextSiblings[(size_t)children[(size_t)(position - 1)]] = nextSiblings[(size_t)child];
+
+    children.erase(children.begin() + position);
+
+    for (auto next = nextSiblings[(size_t)child]; next != none; next = nextSiblings[(size_t)next])
+        --positions[(size_t)next];
+
+    parents[(size_t)child] = none;
+    nextSiblings[(size_t)child] = none;
+    --numChildren[(size_t)parentNode];
+}
+
+void FlatTreeModel::copyProperties(int node, const juce::ValueTree& tree)
+{
+    const auto count = tree.getNumProperties();
+    propStarts[(size_t)node] = static_cast<int>(propNames.size());
+    propCounts[(size_t)node] = count;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const auto name = tree.getPropertyName(i);
+        propNames.push_back(intern(name));
+        propValues.push_back(tree.getProperty(name));
+        propSlots.push_back(0);
+        indexProperty(node, static_cast<int>(propNames.size()) - 1);
+    }
+}
+
+void FlatTreeModel::indexType(int node)
+{
+    auto& nodes = nodesOfType[(size_t)types[(size_t)node]];
+    typeSlots[(size_t)node] = static_cast<int>(nodes.size());
+    nodes.push_back(node);
+}
+
+void FlatTreeModel::unindexNode(int node)
+{
+    // Swap with the last of the list, so removal is O(1)
+    auto& nodes = nodesOfType[(size_t)types[(size_t)node]];
+    const auto slot = typeSlots[(size_t)node];
+    nodes[(size_t)slot] = nodes.back();
+    typeSlots[(size_t)nodes[(size_t)slot]] = slot;
+    nodes.pop_back();
+
+    const auto start = propStarts[(size_t)node];
+    for (int i = start; i < start + propCounts[(size_t)node]; ++i)
+        unindexProperty(node, i);
+}
+
+void FlatTreeModel::indexProperty(int node, int entry)
+{
+    auto& nodes = nodesWithProperty[(size_t)propNames[(size_t)entry]];
+    propSlots[(size_t)entry] = static_cast<int>(nodes.size());
+    nodes.push_back(node);
+}
+
+void FlatTreeModel::unindexProperty(int node, int entry)
+{
+    const auto nameIndex = propNames[(size_t)entry];
+    auto& nodes = nodesWithProperty[(size_t)nameIndex];
+    const auto slot = propSlots[(size_t)entry];
+    const auto moved = nodes.back();
+    nodes[(size_t)slot] = moved;
+    nodes.pop_back();
+
+    if (moved == node) return;
+
+    // The moved node has the property too, find it among its few properties to update its slot
+    const auto start = propStarts[(size_t)moved];
+    for (int i = start; i < start + propCounts[(size_t)moved]; ++i)
+    {
+        if (propNames[(size_t)i] == nameIndex)
+        {
+            propSlots[(size_t)i] = slot;
+            return;
+        }
+    }
+
+    jassertfalse;
+}
+
+void FlatTreeModel::compactProperties()
+{
+    ChunkedArray<int> newNames;
+    ChunkedArray<juce::var> newValues;
+    std::vector<int> newSlots;
+    newSlots.reserve(propNames.size() - deadProperties);
+
+    for (int node = 0; node < getCapacity(); ++node)
+    {
+        if (!isLive(node)) continue;
+
+        const auto start = propStarts[(size_t)node];
+        propStarts[(size_t)node] = static_cast<int>(newNames.size());
+
+        for (int i = start; i < start + propCounts[(size_t)node]; ++i)
+        {
+            newNames.push_back(propNames[(size_t)i]);
+            newValues.push_back(std::move(propValues[(size_t)i]));
+            newSlots.push_back(propSlots[(size_t)i]);
+        }
+    }
+
+    propNames = std::move(newNames);
+    propValues = std::move(newValues);
+    propSlots = std::move(newSlots);
+    deadProperties = 0;
+}
+
+} // namespace vtdbg
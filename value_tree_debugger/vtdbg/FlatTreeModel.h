@@ -0,0 +1,326 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace vtdbg
+{
+/* Hashes an Identifier by its pooled string, which is unique per name */
+struct IdentifierHash
+{
+    size_t operator()(const juce::Identifier& id) const noexcept
+    {
+        return std::hash<const void*>{}(id.getCharPointer().getAddress());
+    }
+};
+
+/* An array kept in fixed-size chunks which copies of it share. A chunk is copied when it is
+   written while shared, so copying the array costs one pointer per chunk and writing to it
+   afterwards at most one chunk copy per chunk touched. The model writes on the message thread,
+   while copies are read on others. */
+template <typename T>
+class ChunkedArray
+{
+public:
+    static constexpr size_t chunkSize{ 4096 };
+
+    size_t size() const { return count; }
+
+    const T& operator[](size_t i) const { return (*chunks[i / chunkSize])[i % chunkSize]; }
+    T& operator[](size_t i) { return getWritableChunk(i / chunkSize)[i % chunkSize]; }
+
+    void push_back(T value)
+    {
+        if (count % chunkSize == 0)
+        {
+            chunks.push_back(std::make_shared<std::vector<T>>());
+            chunks.back()->reserve(chunkSize);
+        }
+
+        getWritableChunk(chunks.size() - 1).push_back(std::move(value));
+        ++count;
+    }
+
+    void clear()
+    {
+        chunks.clear();
+        count = 0;
+    }
+
+private:
+    std::vector<T>& getWritableChunk(size_t index)
+    {
+        // A count read as too high while another thread lets go of a copy only costs a needless copy
+        auto& chunk = chunks[index];
+        if (chunk.use_count() > 1)
+        {
+            auto copy = std::make_shared<std::vector<T>>();
+            copy->reserve(chunkSize);
+            copy->assign(chunk->begin(), chunk->end());
+            chunk = std::move(copy);
+        }
+
+        return *chunk;
+    }
+
+    std::vector<std::shared_ptr<std::vector<T>>> chunks;
+    size_t count{ 0 };
+};
+
+/* Hashes a value tree handle by the shared object it refers to, so handles to one node hash alike.
+   JUCE has no accessor for the object, so this relies on the private layout of juce::ValueTree in
+   JUCE 6 to 8: a SharedObject::Ptr as its first member, then the listener list. The asserts below
+   catch a handle without room for both, isLayoutAsExpected checks the pointer itself at run time. */
+struct ValueTreeHash
+{
+    static_assert(sizeof(juce::ReferenceCountedObjectPtr<juce::ReferenceCountedObject>) == sizeof(void*),
+                  "A shared object pointer is expected to be a bare pointer");
+    static_assert(sizeof(juce::ValueTree) > sizeof(void*),
+                  "A value tree handle is expected to hold its shared object pointer and its listeners");
+
+    size_t operator()(const juce::ValueTree& tree) const noexcept { return std::hash<const void*>{}(getObject(tree)); }
+
+    static const void* getObject(const juce::ValueTree& tree) noexcept
+    {
+        const void* object;
+        std::memcpy(&object, &tree, sizeof(object));
+        return object;
+    }
+
+    /* Whether copies of a handle give the same pointer, other trees another one, and an invalid
+       handle none. Checked the first time a model is built or cleared. */
+    static bool isLayoutAsExpected()
+    {
+        const juce::ValueTree tree{ "Tree" }, copy{ tree }, other{ "Tree" };
+        return getObject(juce::ValueTree{}) == nullptr && getObject(tree) != nullptr
+            && getObject(tree) == getObject(copy) && getObject(tree) != getObject(other);
+    }
+};
+
+/* A debugger-owned mirror of a value tree, stored as flat arrays indexed by node.
+   Nodes link to each other by index (parent, first child, next sibling), each node also keeps
+   the list of its children so the child at an index is found in O(1), and each node owns a
+   contiguous range of the property arrays. Nodes are found from their value tree through a hash
+   of its handle, in O(1). Indices of removed nodes are reused, node ids are not, except by the
+   same value tree coming back after it was removed. */
+class FlatTreeModel
+{
+public:
+    using NodeId = juce::uint32;
+    static constexpr int none{ -1 };
+
+    /* Mirror a whole tree, dropping the previous contents */
+    void rebuild(const juce::ValueTree& rootTree);
+
+    /* Nodes for which this returns true are mirrored without their children, so the debugger
+       pays nothing for subtrees it has been told to leave out. Rebuild after changing it. */
+    std::function<bool(const juce::ValueTree&)> isSubtreeExcluded;
+    /* Whether the node was mirrored without its children. Nodes inside such subtrees aren't
+       mirrored at all, so once the model is built a tree it can't find is in one. */
+    bool isExcluded(int node) const { return excludedFlags[(size_t)node] != 0; }
+    void clear();
+
+    /* A copy of the structure, types and properties which can be read from any thread. It shares
+       the chunks of those arrays with the model, which copies a chunk only when it changes one a
+       snapshot still holds, so taking it is O(nodes / chunk size). It has no value tree handles,
+       hashes, positions or indexes: only the links, depths, types, ids and properties can be read. */
+    std::shared_ptr<const FlatTreeModel> createSnapshot() const;
+
+    /* Mirror only the root now, buildStep adds the rest breadth first so the top levels come first.
+       Until a node is reached only its first children, possibly none, are mirrored. */
+    void beginRebuild(const juce::ValueTree& rootTree);
+    /* Mirror more of the tree until the deadline (a Time::getMillisecondCounterHiRes value),
+       adding every node which gained children to expandedNodes. Returns true while there is more to do. */
+    bool buildStep(double deadlineMs, juce::Array<int>& expandedNodes);
+    bool isBuilding() const { return !buildQueue.empty(); }
+    /* Mirrored nodes whose children are still to be mirrored */
+    int getNumPendingNodes() const { return static_cast<int>(buildQueue.size()); }
+
+    /* Incremental updates, each returns the affected node or none if it is not mirrored */
+    int propertyChanged(const juce::ValueTree& tree, const juce::Identifier& property);
+    /* A removed subtree added back keeps its ids. Pass undoingOrRedoing while an undo manager
+       performs an undo or redo, see RemovedSubtree. */
+    int childAdded(const juce::ValueTree& parentTree, const juce::ValueTree& child, bool undoingOrRedoing = false);
+    int childRemoved(const juce::ValueTree& parentTree, int index);
+    int childOrderChanged(const juce::ValueTree& parentTree, int oldIndex, int newIndex);
+
+    /* Find the node mirroring a tree, or none */
+    int findNode(const juce::ValueTree& tree) const;
+    /* Find a live node from its id, or none */
+    int findNode(NodeId id) const;
+
+    int getRoot() const { return root; }
+    int getNumNodes() const { return numLiveNodes; }
+    /* Size of the node arrays, including free slots */
+    int getCapacity() const { return static_cast<int>(parents.size()); }
+    bool isLive(int node) const { return nodeIds[(size_t)node] != 0; }
+    /* Incremented on every change */
+    juce::uint32 getGeneration() const { return generation; }
+
+    int getParent(int node) const { return parents[(size_t)node]; }
+    int getFirstChild(int node) const { return firstChildren[(size_t)node]; }
+    int getNextSibling(int node) const { return nextSiblings[(size_t)node]; }
+    int getNumChildren(int node) const { return numChildren[(size_t)node]; }
+    int getChild(int node, int index) const { return juce::isPositiveAndBelow(index, numChildren[(size_t)node]) ? childLists[(size_t)node][(size_t)index] : none; }
+    int getDepth(int node) const { return depths[(size_t)node]; }
+    int getTypeIndex(int node) const { return types[(size_t)node]; }
+    /* Index of the node among the children of its parent */
+    int getPosition(int node) const { return positions[(size_t)node]; }
+    const juce::Identifier& getType(int node) const { return identifiers[(size_t)types[(size_t)node]]; }
+    NodeId getNodeId(int node) const { return nodeIds[(size_t)node]; }
+    const juce::ValueTree& getTree(int node) const { return handles[(size_t)node]; }
+
+    int getNumProperties(int node) const { return propCounts[(size_t)node]; }
+    int getPropertyNameIndex(int node, int i) const { return propNames[(size_t)(propStarts[(size_t)node] + i)]; }
+    const juce::Identifier& getPropertyName(int node, int i) const { return identifiers[(size_t)getPropertyNameIndex(node, i)]; }
+    const juce::var& getPropertyValue(int node, int i) const { return propValues[(size_t)(propStarts[(size_t)node] + i)]; }
+
+    /* Hash of the node's type and properties, whatever their order */
+    juce::uint64 getContentHash(int node) const { return contentHashes[(size_t)node]; }
+    /* Hash of the node's content and, in order, its children's subtree hashes. Kept up to date
+       in O(depth) for property changes and O(children + depth) for structural ones, so equal
+       subtrees of two models can be recognised without visiting them. */
+    juce::uint64 getSubtreeHash(int node) const { return subtreeHashes[(size_t)node]; }
+    /* Whether the node's value tree still has the properties its content hash was made from, for
+       finding changes by polling rather than listening. Doesn't allocate. */
+    bool isContentCurrent(int node) const;
+    /* The content hash a node mirroring the tree would have, 0 if its type or a property name
+       was never interned. Doesn't allocate. */
+    juce::uint64 hashContent(const juce::ValueTree& tree) const;
+
+    /* Live nodes of a type, or having a property, in no particular order. Indexed by interned
+       identifier and kept up to date in O(1) per change, so queries needn't walk the tree. */
+    const std::vector<int>& getNodesOfType(int identifierIndex) const { return nodesOfType[(size_t)identifierIndex]; }
+    const std::vector<int>& getNodesWithProperty(int identifierIndex) const { return nodesWithProperty[(size_t)identifierIndex]; }
+
+    /* Types and property names share one table of interned identifiers */
+    int intern(const juce::Identifier& id);
+    int findIdentifier(const juce::Identifier& id) const;
+    const juce::Identifier& getIdentifier(int index) const { return identifiers[(size_t)index]; }
+    int getNumIdentifiers() const { return static_cast<int>(identifiers.size()); }
+
+    /* Visit a node and all of its descendants in tree order, without recursion */
+    template <typename Visitor>
+    void forEachInSubtree(int start, Visitor&& visit) const
+    {
+        for (int node = start; node != none;)
+        {
+            visit(node);
+
+            if (firstChildren[(size_t)node] != none)
+            {
+                node = firstChildren[(size_t)node];
+                continue;
+            }
+
+            while (node != start && nextSiblings[(size_t)node] == none)
+                node = parents[(size_t)node];
+
+            node = node == start ? none : nextSiblings[(size_t)node];
+        }
+    }
+
+private:
+    int allocateNode(NodeId reusedId = 0);
+    int addSubtree(const juce::ValueTree& tree, int parentNode, int index, bool undoingOrRedoing = false);
+    /* Allocate a node for the tree and copy its type and properties, leaving it unlinked */
+    int mirrorNode(const juce::ValueTree& tree, int depth, NodeId reusedId = 0);
+    /* Keep the ids of a subtree about to be removed, for when it is added back by an undo or a move */
+    void rememberRemovedSubtree(int node);
+    void freeSubtree(int node);
+    void linkChild(int parentNode, int child, int index);
+    void unlinkChild(int child);
+    void copyProperties(int node, const juce::ValueTree& tree);
+
+    void indexType(int node);
+    /* Remove the node and all of its properties from the indexes */
+    void unindexNode(int node);
+    /* entry is the position of the property in the property arrays */
+    void indexProperty(int node, int entry);
+    void unindexProperty(int node, int entry);
+
+    juce::uint64 getPropertyHash(int nameIndex, const juce::var& value) const;
+    /* The contribution of a child to its parent's sum of child hashes */
+    juce::uint64 getChildTerm(int child) const;
+    void computeSubtreeHash(int node);
+    /* After the content or child sum of a node changed */
+    void updateHashesUpwards(int node);
+    /* After children were added, removed or moved, which shifts their positions */
+    void childrenHashesChanged(int parentNode);
+    void compactProperties();
+
+    int root{ none };
+    int numLiveNodes{ 0 };
+    NodeId nextNodeId{ 1 };
+    juce::uint32 generation{ 0 };
+
+    // Node arrays, the ones read by snapshots are shared with them
+    ChunkedArray<int> parents;
+    ChunkedArray<int> firstChildren;
+    ChunkedArray<int> nextSiblings;
+    ChunkedArray<int> numChildren;
+    std::vector<int> positions;
+    std::vector<juce::uint64> contentHashes;
+    std::vector<juce::uint64> childHashSums;
+    std::vector<juce::uint64> subtreeHashes;
+    ChunkedArray<int> depths;
+    ChunkedArray<int> types;
+    ChunkedArray<int> propStarts;
+    ChunkedArray<int> propCounts;
+    /* Position of the node in its list of nodesOfType */
+    std::vector<int> typeSlots;
+    std::vector<juce::uint8> excludedFlags;
+    ChunkedArray<NodeId> nodeIds;
+    std::vector<juce::ValueTree> handles;
+    /* The children of each node in order, matching the sibling links */
+    std::vector<std::vector<int>> childLists;
+    std::vector<int> freeNodes;
+    std::unordered_map<NodeId, int> nodeIndices;
+    std::unordered_map<juce::ValueTree, int, ValueTreeHash> handleIndices;
+    /* Nodes still to be reached by buildStep */
+    std::deque<NodeId> buildQueue;
+    /* What is kept of a removed node to know it when it comes back. Holding its handle would keep
+       the removed tree alive, so it is known by the address of its shared object, which a freed
+       tree can pass on to a new one. */
+    struct RemovedNode
+    {
+        const void* object;
+        juce::uint64 contentHash;
+        int numChildren;
+        NodeId id;
+    };
+    /* The address alone is trusted while the removed tree can't have been freed: during an undo
+       or redo, whose undo manager holds it, and when it is added back by the very next change, as
+       in a move. Otherwise the content and number of children have to match as well. */
+    struct RemovedSubtree
+    {
+        std::vector<RemovedNode> nodes;
+        juce::uint32 generation;
+    };
+    /* Recently removed subtrees, nodes in tree order, oldest first, at most maxRemovedNodes in all */
+    std::deque<RemovedSubtree> removedSubtrees;
+    size_t numRemovedNodes{ 0 };
+    static constexpr size_t maxRemovedSubtrees{ 64 };
+    static constexpr size_t maxRemovedNodes{ 16384 };
+
+    // Property arrays, each node owns the range [propStart, propStart + propCount)
+    ChunkedArray<int> propNames;
+    ChunkedArray<juce::var> propValues;
+    /* Position of the node in the list of nodesWithProperty for this property */
+    std::vector<int> propSlots;
+    size_t deadProperties{ 0 };
+
+    std::vector<juce::Identifier> identifiers;
+    std::vector<juce::uint64> identifierHashes;
+    std::vector<std::vector<int>> nodesOfType;
+    std::vector<std::vector<int>> nodesWithProperty;
+    std::unordered_map<juce::Identifier, int, IdentifierHash> identifierIndices;
+};
+
+} // namespace vtdbg
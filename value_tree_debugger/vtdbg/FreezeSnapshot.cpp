@@ -0,0 +1,111 @@
+#include "FreezeSnapshot.h"
+
+namespace vtdbg
+{
+void FreezeSnapshot::freeze(const FlatTreeModel& model, const std::vector<FlatTreeModel::NodeId>& shownNodes)
+{
+    clear();
+    frozen = true;
+
+    for (auto id : shownNodes)
+    {
+        const auto node = model.findNode(id);
+        if (node == FlatTreeModel::none) continue;
+
+        auto& lists = keepProperties(id, model.getTree(node));
+        lists.childrenKept = true;
+
+        for (auto child = model.getFirstChild(node); child != FlatTreeModel::none; child = model.getNextSibling(child))
+        {
+            const auto& childTree = model.getTree(child);
+            lists.children.emplace_back(childTree, model.getNodeId(child));
+            keepProperties(model.getNodeId(child), childTree);
+        }
+    }
+}
+
+void FreezeSnapshot::unfreeze()
+{
+    clear();
+    frozen = false;
+}
+
+void FreezeSnapshot::clear()
+{
+    numPending = 0;
+    keptValues.clear();
+    keptLists.clear();
+    changedNodes.clear();
+    structureChangedNodes.clear();
+}
+
+void FreezeSnapshot::propertyChanging(const FlatTreeModel& model, int node, const juce::Identifier& property)
+{
+    jassert(frozen);
+    ++numPending;
+
+    const auto id = model.getNodeId(node);
+    changedNodes.insert(id);
+
+    // Only the first change is kept, later ones would overwrite the value shown
+    auto& kept = keptValues[id];
+    for (const auto& value : kept)
+        if (value.name == property)
+            return;
+
+    const auto numProperties = model.getNumProperties(node);
+    for (int i = 0; i < numProperties; ++i)
+    {
+        if (model.getPropertyName(node, i) != property) continue;
+
+        kept.push_back({ property, model.getPropertyValue(node, i) });
+        return;
+    }
+
+    kept.push_back({ property, juce::var{} });
+}
+
+void FreezeSnapshot::childrenChanged(FlatTreeModel::NodeId node)
+{
+    jassert(frozen);
+    ++numPending;
+    structureChangedNodes.insert(node);
+}
+
+void FreezeSnapshot::nodeChanged(FlatTreeModel::NodeId node)
+{
+    changedNodes.insert(node);
+}
+
+const juce::var* FreezeSnapshot::findValue(FlatTreeModel::NodeId node, const juce::Identifier& property) const
+{
+    const auto it = keptValues.find(node);
+    if (it == keptValues.end()) return nullptr;
+
+    for (const auto& value : it->second)
+        if (value.name == property)
+            return &value.value;
+
+    return nullptr;
+}
+
+const FreezeSnapshot::Lists* FreezeSnapshot::findLists(FlatTreeModel::NodeId node) const
+{
+    const auto it = keptLists.find(node);
+    return it != keptLists.end() ? &it->second : nullptr;
+}
+
+FreezeSnapshot::Lists& FreezeSnapshot::keepProperties(FlatTreeModel::NodeId node, const juce::ValueTree& tree)
+{
+    // A shown node is often the child of another shown node, its names are kept once
+    const auto inserted = keptLists.find(node) == keptLists.end();
+    auto& lists = keptLists[node];
+
+    if (inserted)
+        for (int i = 0; i < tree.getNumProperties(); ++i)
+            lists.properties.add(tree.getPropertyName(i));
+
+    return lists;
+}
+
+} // namespace vtdbg
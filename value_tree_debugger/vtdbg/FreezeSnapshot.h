@@ -0,0 +1,73 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace vtdbg
+{
+/* What the debugger shows while frozen: the tree as it was when frozen. Freezing keeps the property
+   names and children of the nodes shown, and the property names of their children, so items opened
+   or scrolled in while frozen show the same lists. Values are kept copy on write: the first change
+   to a property while frozen keeps the value the model still holds from before it. The nodes
+   changed are kept too, so unfreezing refreshes only their items. */
+class FreezeSnapshot
+{
+public:
+    /* The lists of a node as they were when frozen */
+    struct Lists
+    {
+        juce::Array<juce::Identifier> properties;
+        /* Only kept for the nodes shown, the others can't be opened while frozen */
+        bool childrenKept{ false };
+        std::vector<std::pair<juce::ValueTree, FlatTreeModel::NodeId>> children;
+    };
+
+    void freeze(const FlatTreeModel& model, const std::vector<FlatTreeModel::NodeId>& shownNodes);
+    /* Forget the kept values and changed nodes, read those first */
+    void unfreeze();
+    /* Forget what changed but stay frozen, for a new tree */
+    void clear();
+    bool isFrozen() const { return frozen; }
+
+    /* Called before the model takes the change */
+    void propertyChanging(const FlatTreeModel& model, int node, const juce::Identifier& property);
+    /* Called after the model took a change to the node's children */
+    void childrenChanged(FlatTreeModel::NodeId node);
+    /* A node whose view is out of date for another reason, such as the baseline difference */
+    void nodeChanged(FlatTreeModel::NodeId node);
+
+    /* The value the property had when frozen, or nullptr if it hasn't changed since.
+       A property added since has a void value. */
+    const juce::var* findValue(FlatTreeModel::NodeId node, const juce::Identifier& property) const;
+    /* The lists kept when frozen, or nullptr for a node which wasn't shown or the child of one */
+    const Lists* findLists(FlatTreeModel::NodeId node) const;
+
+    /* Changes which arrived since freezing */
+    juce::int64 getNumPending() const { return numPending; }
+    const std::unordered_set<FlatTreeModel::NodeId>& getChangedNodes() const { return changedNodes; }
+    const std::unordered_set<FlatTreeModel::NodeId>& getStructureChangedNodes() const { return structureChangedNodes; }
+
+private:
+    Lists& keepProperties(FlatTreeModel::NodeId node, const juce::ValueTree& tree);
+
+    struct KeptValue
+    {
+        juce::Identifier name;
+        juce::var value;
+    };
+
+    bool frozen{ false };
+    juce::int64 numPending{ 0 };
+    /* Few properties of a node change, so they are searched in a short vector */
+    std::unordered_map<FlatTreeModel::NodeId, std::vector<KeptValue>> keptValues;
+    std::unordered_map<FlatTreeModel::NodeId, Lists> keptLists;
+    std::unordered_set<FlatTreeModel::NodeId> changedNodes;
+    std::unordered_set<FlatTreeModel::NodeId> structureChangedNodes;
+};
+
+} // namespace vtdbg
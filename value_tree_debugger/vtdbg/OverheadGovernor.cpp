@@ -0,0 +1,118 @@
+#include "OverheadGovernor.h"
+
+namespace vtdbg
+{
+OverheadGovernor::OverheadGovernor() = default;
+
+OverheadGovernor::~OverheadGovernor()
+{
+    stopTimer();
+}
+
+void OverheadGovernor::setBudget(double msPerFrame, double newFrameMs)
+{
+    budgetMs = juce::jmax(0.0, msPerFrame);
+    frameMs = juce::jmax(1.0, newFrameMs);
+    windowTicks = 0;
+    windowStartMs = juce::Time::getMillisecondCounterHiRes();
+    calmWindows = 0;
+    loadMs = 0.0;
+
+    if (isEnabled())
+    {
+        startTimer(flushIntervalMs);
+    }
+    else
+    {
+        stopTimer();
+        setLevel(Level::full);
+    }
+}
+
+juce::String OverheadGovernor::getLevelName(Level levelToName)
+{
+    switch (levelToName)
+    {
+    case Level::full:          return "full updates";
+    case Level::coalesced:     return "coalesced updates";
+    case Level::valuesPaused:  return "values paused";
+    case Level::structureOnly: return "structure only";
+    }
+
+    return {};
+}
+
+OverheadGovernor::ScopedMeasurement::ScopedMeasurement(OverheadGovernor& governorToUse) :
+    governor(governorToUse)
+{
+    if (!governor.isEnabled()) return;
+
+    counted = true;
+    if (governor.depth++ == 0)
+        startTicks = juce::Time::getHighResolutionTicks();
+}
+
+OverheadGovernor::ScopedMeasurement::~ScopedMeasurement()
+{
+    if (counted && --governor.depth == 0)
+        governor.addTime(juce::Time::getHighResolutionTicks() - startTicks);
+}
+
+void OverheadGovernor::addTime(juce::int64 ticks)
+{
+    windowTicks += ticks;
+}
+
+void OverheadGovernor::timerCallback()
+{
+    // The flush is the debugger's time as well
+    {
+        ScopedMeasurement measurement{ *this };
+        if (onFlush) onFlush();
+    }
+
+    const auto nowMs = juce::Time::getMillisecondCounterHiRes();
+    if (nowMs - windowStartMs >= windowMs)
+        evaluate(nowMs);
+}
+
+void OverheadGovernor::evaluate(double nowMs)
+{
+    const auto numFrames = (nowMs - windowStartMs) / frameMs;
+    loadMs = juce::Time::highResolutionTicksToSeconds(windowTicks) * 1000.0 / juce::jmax(1.0, numFrames);
+    windowTicks = 0;
+    windowStartMs = nowMs;
+
+    if (loadMs > budgetMs)
+    {
+        calmWindows = 0;
+        if (level != Level::structureOnly)
+            setLevel((Level)((int)level + 1));
+    }
+    else if (loadMs < budgetMs * 0.5 && level != Level::full)
+    {
+        // The load measured at a lower level understates what the level above costs, so step up slowly
+        if (++calmWindows >= calmWindowsToStepUp)
+        {
+            calmWindows = 0;
+            setLevel((Level)((int)level - 1));
+        }
+    }
+    else
+    {
+        calmWindows = 0;
+    }
+}
+
+void OverheadGovernor::setLevel(Level newLevel)
+{
+    if (level == newLevel) return;
+
+    const auto previous = level;
+    level = newLevel;
+
+    if (onLevelChanged)
+        onLevelChanged(previous);
+}
+
+} // namespace vtdbg
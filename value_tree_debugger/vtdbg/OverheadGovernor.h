@@ -0,0 +1,85 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include <functional>
+
+namespace vtdbg
+{
+/* Keeps the time the debugger spends on the message thread within a budget per frame, such as
+   0.5 ms per 16 ms. The debugger's callbacks and repaints are measured, and while the average over
+   a window is over budget the level steps down one at a time:
+       full           every change is shown as it arrives
+       coalesced      property changes are shown a few times a second
+       valuesPaused   property changes are shown once the level is back up
+       structureOnly  value history and the baseline comparison are left out as well
+   After a second well under budget it steps back up one level. */
+class OverheadGovernor : private juce::Timer
+{
+public:
+    OverheadGovernor();
+    ~OverheadGovernor() override;
+
+    enum class Level
+    {
+        full,
+        coalesced,
+        valuesPaused,
+        structureOnly,
+    };
+
+    /* Zero disables the governor, and the level goes back to full */
+    void setBudget(double msPerFrame, double frameMs = 16.0);
+    bool isEnabled() const { return budgetMs > 0.0; }
+    double getBudgetMs() const { return budgetMs; }
+    double getFrameMs() const { return frameMs; }
+
+    Level getLevel() const { return level; }
+    /* Milliseconds per frame measured over the last window */
+    double getLoadMs() const { return loadMs; }
+    static juce::String getLevelName(Level levelToName);
+
+    /* Measures the time until it is destroyed, nested measurements are only counted once */
+    class ScopedMeasurement
+    {
+    public:
+        explicit ScopedMeasurement(OverheadGovernor& governorToUse);
+        ~ScopedMeasurement();
+
+    private:
+        OverheadGovernor& governor;
+        juce::int64 startTicks{ 0 };
+        bool counted{ false };
+    };
+
+    /* For measurements which can't be scoped, such as from a paint to its paintOverChildren */
+    void addTime(juce::int64 ticks);
+
+    /* Called after the level changed, with the level before */
+    std::function<void(Level)> onLevelChanged;
+    /* Called every flushIntervalMs while the governor is enabled, to show coalesced changes */
+    std::function<void()> onFlush;
+
+    static constexpr int flushIntervalMs{ 100 };
+
+private:
+    void timerCallback() override;
+    void evaluate(double nowMs);
+    void setLevel(Level newLevel);
+
+    double budgetMs{ 0.0 };
+    double frameMs{ 16.0 };
+    Level level{ Level::full };
+
+    int depth{ 0 };
+    juce::int64 windowTicks{ 0 };
+    double windowStartMs{ 0.0 };
+    double loadMs{ 0.0 };
+    int calmWindows{ 0 };
+
+    static constexpr double windowMs{ 250.0 };
+    /* Windows under half the budget before stepping up */
+    static constexpr int calmWindowsToStepUp{ 4 };
+};
+
+} // namespace vtdbg
@@ -0,0 +1,313 @@
+#include "SessionStats.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace vtdbg
+{
+HeavyHitters::HeavyHitters() :
+    counters((size_t)(depth * width), 0)
+{
+    top.reserve((size_t)maxTop);
+}
+
+std::vector<HeavyHitters::Entry> HeavyHitters::getTop() const
+{
+    auto sorted = top;
+    std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) { return a.count > b.count; });
+    return sorted;
+}
+
+void HeavyHitters::clear()
+{
+    std::fill(counters.begin(), counters.end(), 0u);
+    top.clear();
+}
+
+juce::uint32 HeavyHitters::increment(juce::uint64 key)
+{
+    // One counter per row, each row hashing the key differently, the smallest is the estimate
+    auto estimate = std::numeric_limits<juce::uint32>::max();
+    for (int row = 0; row < depth; ++row)
+    {
+        auto hash = key + (juce::uint64)(row + 1) * 0x9e3779b97f4a7c15ull;
+        hash = (hash ^ (hash >> 31)) * 0xbf58476d1ce4e5b9ull;
+        hash ^= hash >> 29;
+
+        auto& counter = counters[(size_t)(row * width) + (size_t)(hash % (juce::uint64)width)];
+        if (counter < std::numeric_limits<juce::uint32>::max())
+            ++counter;
+
+        estimate = juce::jmin(estimate, counter);
+    }
+
+    return estimate;
+}
+
+// ============================================================================
+
+void EventTimeline::add(double seconds)
+{
+    auto index = (size_t)juce::jmax(0.0, seconds / bucketSeconds);
+
+    while (index >= maxBuckets)
+    {
+        // Merge neighbours, halving the resolution
+        for (size_t i = 0; i < buckets.size(); i += 2)
+            buckets[i / 2] = buckets[i] + (i + 1 < buckets.size() ? buckets[i + 1] : 0);
+
+        buckets.resize((buckets.size() + 1) / 2);
+        bucketSeconds *= 2.0;
+        index = (size_t)(seconds / bucketSeconds);
+    }
+
+    if (index >= buckets.size())
+        buckets.resize(index + 1, 0);
+
+    ++buckets[index];
+}
+
+void EventTimeline::clear()
+{
+    buckets.clear();
+    bucketSeconds = 1.0;
+}
+
+// ============================================================================
+
+SessionStats::SessionStats()
+{
+    reset();
+}
+
+void SessionStats::reset()
+{
+    startMs = juce::Time::getMillisecondCounterHiRes();
+    numEvents = 0;
+    timeline.clear();
+    properties.clear();
+    nodes.clear();
+    propertiesSet = childrenAdded = childrenRemoved = childrenMoved = 0;
+    largestValues.clear();
+    transactions = undoRedoChanges = 0;
+}
+
+double SessionStats::getSessionSeconds() const
+{
+    return (juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+}
+
+void SessionStats::propertyChanged(const FlatTreeModel& model, int node, const juce::Identifier& property, const juce::var& value)
+{
+    eventArrived();
+    nodeChanged(model, node);
+    ++propertiesSet;
+
+    // Identifiers are pooled for the life of the process, so their addresses make a key which
+    // stays the same when the model is rebuilt
+    const auto& type = model.getType(node);
+    const auto key = (juce::uint64)IdentifierHash{}(type) * 31 + (juce::uint64)IdentifierHash{}(property);
+    properties.add(key, [&]() { return type.toString() + "." + property.toString(); });
+
+    // Values which can't be larger than the smallest kept are skipped without measuring
+    if (largestValues.size() == maxLargeValues && !value.isString() && !value.isBinaryData() && !value.isArray())
+        return;
+
+    const auto bytes = getValueSize(value);
+    if (largestValues.size() == maxLargeValues && bytes <= largestValues.back().bytes)
+        return;
+
+    LargeValue large{ bytes, getNodePath(model, node) + "." + property.toString(), getSessionSeconds() };
+    const auto position = std::upper_bound(largestValues.begin(), largestValues.end(), large,
+                                           [](const LargeValue& a, const LargeValue& b) { return a.bytes > b.bytes; });
+    largestValues.insert(position, std::move(large));
+
+    if (largestValues.size() > maxLargeValues)
+        largestValues.pop_back();
+}
+
+void SessionStats::childAdded(const FlatTreeModel& model, int parentNode)
+{
+    eventArrived();
+    nodeChanged(model, parentNode);
+    ++childrenAdded;
+}
+
+void SessionStats::childRemoved(const FlatTreeModel& model, int parentNode)
+{
+    eventArrived();
+    nodeChanged(model, parentNode);
+    ++childrenRemoved;
+}
+
+void SessionStats::childMoved(const FlatTreeModel& model, int parentNode)
+{
+    eventArrived();
+    nodeChanged(model, parentNode);
+    ++childrenMoved;
+}
+
+void SessionStats::eventArrived()
+{
+    ++numEvents;
+    timeline.add(getSessionSeconds());
+
+    // The listener is called while the undo manager performs the action, before it is added to a
+    // transaction, so none in the current transaction means this change starts a new one
+    if (undoManager == nullptr)
+        return;
+
+    if (undoManager->isPerformingUndoRedo())
+        ++undoRedoChanges;
+    else if (undoManager->getNumActionsInCurrentTransaction() == 0)
+        ++transactions;
+}
+
+void SessionStats::nodeChanged(const FlatTreeModel& model, int node)
+{
+    nodes.add(model.getNodeId(node), [&]() { return getNodePath(model, node); });
+}
+
+juce::String SessionStats::getNodePath(const FlatTreeModel& model, int node)
+{
+    juce::StringArray parts;
+    for (; node != FlatTreeModel::none; node = model.getParent(node))
+    {
+        const auto parent = model.getParent(node);
+        parts.insert(0, model.getType(node).toString() + (parent != FlatTreeModel::none ? "[" + juce::String{ model.getPosition(node) } + "]" : juce::String{}));
+    }
+
+    return "/" + parts.joinIntoString("/");
+}
+
+juce::int64 SessionStats::getValueSize(const juce::var& value)
+{
+    if (value.isString())
+        return (juce::int64)value.toString().getNumBytesAsUTF8();
+
+    if (auto* block = value.getBinaryData())
+        return (juce::int64)block->getSize();
+
+    if (auto* array = value.getArray())
+    {
+        juce::int64 bytes{ 0 };
+        for (const auto& element : *array)
+            bytes += getValueSize(element);
+
+        return bytes;
+    }
+
+    return 8;
+}
+
+juce::var SessionStats::toJson() const
+{
+    auto* root = new juce::DynamicObject();
+    root->setProperty("sessionSeconds", getSessionSeconds());
+    root->setProperty("events", numEvents);
+
+    auto* rate = new juce::DynamicObject();
+    rate->setProperty("bucketSeconds", timeline.getBucketSeconds());
+    juce::Array<juce::var> eventsPerSecond;
+    for (auto count : timeline.getBuckets())
+        eventsPerSecond.add((double)count / timeline.getBucketSeconds());
+    rate->setProperty("eventsPerSecond", eventsPerSecond);
+    root->setProperty("rate", rate);
+
+    const auto toArray = [](const HeavyHitters& hitters)
+    {
+        juce::Array<juce::var> entries;
+        for (const auto& entry : hitters.getTop())
+        {
+            auto* object = new juce::DynamicObject();
+            object->setProperty("name", entry.label);
+            object->setProperty("count", (juce::int64)entry.count);
+            entries.add(object);
+        }
+        return entries;
+    };
+    root->setProperty("topProperties", toArray(properties));
+    root->setProperty("topNodes", toArray(nodes));
+
+    auto* structure = new juce::DynamicObject();
+    structure->setProperty("propertiesSet", propertiesSet);
+    structure->setProperty("childrenAdded", childrenAdded);
+    structure->setProperty("childrenRemoved", childrenRemoved);
+    structure->setProperty("childrenMoved", childrenMoved);
+    root->setProperty("structure", structure);
+
+    juce::Array<juce::var> largest;
+    for (const auto& value : largestValues)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("name", value.label);
+        object->setProperty("bytes", value.bytes);
+        object->setProperty("seconds", value.seconds);
+        largest.add(object);
+    }
+    root->setProperty("largestValues", largest);
+
+    if (undoManager != nullptr)
+    {
+        auto* undo = new juce::DynamicObject();
+        undo->setProperty("transactions", transactions);
+        undo->setProperty("undoRedoChanges", undoRedoChanges);
+        root->setProperty("undo", undo);
+    }
+
+    return root;
+}
+
+juce::String SessionStats::toCsv() const
+{
+    juce::String csv;
+    csv.preallocateBytes(16384);
+
+    // Names are paths and property names, which may hold commas, so they are quoted
+    const auto addRow = [&](const juce::String& section, const juce::String& name, const juce::String& value)
+    {
+        csv << section << ",\"" << name.replace("\"", "\"\"") << "\"," << value << "\n";
+    };
+
+    csv << "section,name,value\n";
+    addRow("session", "seconds", juce::String{ getSessionSeconds(), 3 });
+    addRow("session", "events", juce::String{ numEvents });
+
+    const auto& buckets = timeline.getBuckets();
+    for (size_t i = 0; i < buckets.size(); ++i)
+        addRow("events_per_second", juce::String{ (double)i * timeline.getBucketSeconds(), 1 }, juce::String{ (double)buckets[i] / timeline.getBucketSeconds(), 2 });
+
+    for (const auto& entry : properties.getTop())
+        addRow("top_property", entry.label, juce::String{ (juce::int64)entry.count });
+
+    for (const auto& entry : nodes.getTop())
+        addRow("top_node", entry.label, juce::String{ (juce::int64)entry.count });
+
+    addRow("structure", "properties_set", juce::String{ propertiesSet });
+    addRow("structure", "children_added", juce::String{ childrenAdded });
+    addRow("structure", "children_removed", juce::String{ childrenRemoved });
+    addRow("structure", "children_moved", juce::String{ childrenMoved });
+
+    for (const auto& value : largestValues)
+        addRow("largest_value", value.label, juce::String{ value.bytes });
+
+    if (undoManager != nullptr)
+    {
+        addRow("undo", "transactions", juce::String{ transactions });
+        addRow("undo", "undo_redo_changes", juce::String{ undoRedoChanges });
+    }
+
+    return csv;
+}
+
+juce::Result SessionStats::exportTo(const juce::File& file) const
+{
+    const auto text = file.hasFileExtension("csv") ? toCsv() : juce::JSON::toString(toJson());
+
+    if (!file.replaceWithText(text))
+        return juce::Result::fail("Could not write " + file.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+} // namespace vtdbg
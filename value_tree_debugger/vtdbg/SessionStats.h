@@ -0,0 +1,155 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <vector>
+
+namespace vtdbg
+{
+/* Approximate counts of any number of keys in fixed memory (a count-min sketch), with the keys
+   counted most kept by name. Counts can be over, never under. */
+class HeavyHitters
+{
+public:
+    HeavyHitters();
+
+    struct Entry
+    {
+        juce::uint64 key;
+        juce::uint32 count;
+        juce::String label;
+    };
+
+    /* Count the key once more. makeLabel is only called when the key enters the top list. */
+    template <typename MakeLabel>
+    void add(juce::uint64 key, MakeLabel&& makeLabel)
+    {
+        const auto count = increment(key);
+
+        for (auto& entry : top)
+        {
+            if (entry.key != key) continue;
+
+            entry.count = count;
+            return;
+        }
+
+        if ((int)top.size() < maxTop)
+        {
+            top.push_back({ key, count, makeLabel() });
+            return;
+        }
+
+        auto* lowest = &top.front();
+        for (auto& entry : top)
+            if (entry.count < lowest->count)
+                lowest = &entry;
+
+        if (count > lowest->count)
+            *lowest = { key, count, makeLabel() };
+    }
+
+    /* Highest count first */
+    std::vector<Entry> getTop() const;
+    void clear();
+
+    static constexpr int depth{ 4 };
+    static constexpr int width{ 2048 };
+    static constexpr int maxTop{ 20 };
+
+private:
+    /* Returns the new estimate of the key's count */
+    juce::uint32 increment(juce::uint64 key);
+
+    std::vector<juce::uint32> counters;
+    std::vector<Entry> top;
+};
+
+/* Events over the whole session in a fixed number of buckets. When they are full, neighbours
+   are merged and each bucket covers twice as long. */
+class EventTimeline
+{
+public:
+    void add(double seconds);
+    void clear();
+
+    double getBucketSeconds() const { return bucketSeconds; }
+    const std::vector<juce::uint32>& getBuckets() const { return buckets; }
+
+    static constexpr size_t maxBuckets{ 512 };
+
+private:
+    std::vector<juce::uint32> buckets;
+    double bucketSeconds{ 1.0 };
+};
+
+/* Statistics of the changes seen by the debugger over a session, such as a QA run, in memory
+   which doesn't grow with its length. Exported as JSON or CSV. */
+class SessionStats
+{
+public:
+    SessionStats();
+    void reset();
+
+    /* The undo manager the app changes the tree with, whose transactions and undo or redo are
+       counted. The debugger's own one only sees the debugger's edits. Without one, the stats
+       have no undo section. */
+    void setUndoManager(const juce::UndoManager* appUndoManager) { undoManager = appUndoManager; }
+    const juce::UndoManager* getUndoManager() const { return undoManager; }
+
+    // Called after the model has been updated
+    void propertyChanged(const FlatTreeModel& model, int node, const juce::Identifier& property, const juce::var& value);
+    void childAdded(const FlatTreeModel& model, int parentNode);
+    void childRemoved(const FlatTreeModel& model, int parentNode);
+    void childMoved(const FlatTreeModel& model, int parentNode);
+
+    struct LargeValue
+    {
+        juce::int64 bytes;
+        juce::String label;
+        double seconds;
+    };
+
+    juce::int64 getNumEvents() const { return numEvents; }
+    double getSessionSeconds() const;
+
+    /* JSON with the same sections as the CSV */
+    juce::var toJson() const;
+    /* One row per item: section,name,value */
+    juce::String toCsv() const;
+    /* CSV for a .csv file, JSON otherwise */
+    juce::Result exportTo(const juce::File& file) const;
+
+    static constexpr size_t maxLargeValues{ 10 };
+
+    /* Bytes of text, binary data or array elements, 8 for anything else */
+    static juce::int64 getValueSize(const juce::var& value);
+
+private:
+    void eventArrived();
+    void nodeChanged(const FlatTreeModel& model, int node);
+    static juce::String getNodePath(const FlatTreeModel& model, int node);
+
+    double startMs{ 0.0 };
+    juce::int64 numEvents{ 0 };
+    EventTimeline timeline;
+    HeavyHitters properties;
+    HeavyHitters nodes;
+
+    juce::int64 propertiesSet{ 0 };
+    juce::int64 childrenAdded{ 0 };
+    juce::int64 childrenRemoved{ 0 };
+    juce::int64 childrenMoved{ 0 };
+
+    /* Largest first */
+    std::vector<LargeValue> largestValues;
+
+    /* Transactions started, and changes made by undo or redo, in the app's undo manager */
+    const juce::UndoManager* undoManager{ nullptr };
+    juce::int64 transactions{ 0 };
+    juce::int64 undoRedoChanges{ 0 };
+};
+
+} // namespace vtdbg
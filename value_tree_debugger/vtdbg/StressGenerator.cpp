@@ -0,0 +1,143 @@
+#include "StressGenerator.h"
+
+namespace vtdbg
+{
+const juce::Identifier stressNodeType{ "StressNode" };
+
+StressGenerator::~StressGenerator()
+{
+    stop();
+}
+
+void StressGenerator::start(juce::ValueTree targetTree, const Profile& newProfile, juce::UndoManager* undoManager)
+{
+    stop();
+
+    target = targetTree;
+    profile = newProfile;
+    um = undoManager;
+    stats = {};
+    due = 0.0;
+
+    propertyNames.clearQuick();
+    for (int i = 0; i < profile.numProperties; ++i)
+        propertyNames.add("stress" + juce::String{ i });
+
+    startTime = juce::Time::getMillisecondCounterHiRes();
+    lastTickTime = startTime;
+    startTimer(timerIntervalMs);
+}
+
+void StressGenerator::stop()
+{
+    if (!isTimerRunning()) return;
+
+    stopTimer();
+
+    // Leave the target as it was found, apart from the written properties
+    for (auto& child : burstChildren)
+        target.removeChild(child, um);
+
+    burstChildren.clearQuick();
+    if (um) um->beginNewTransaction();
+}
+
+juce::String StressGenerator::getStatsDescription() const
+{
+    juce::String description;
+    description << juce::String{ stats.throughput, 0 } << " changes/s" << juce::newLine
+                << "stall " << juce::String{ stats.totalStallMs, 1 } << " ms, max " << juce::String{ stats.maxStallMs, 2 } << " ms" << juce::newLine
+                << "timer late by up to " << juce::String{ stats.maxTimerLatenessMs, 1 } << " ms";
+
+    if (um != nullptr)
+        description << juce::newLine << "undo history " << stats.undoUnits << " units";
+
+    return description;
+}
+
+void StressGenerator::timerCallback()
+{
+    if (!target.isValid())
+    {
+        stop();
+        return;
+    }
+
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    stats.maxTimerLatenessMs = juce::jmax(stats.maxTimerLatenessMs, now - lastTickTime - timerIntervalMs);
+    lastTickTime = now;
+
+    // Catch up with the requested rate, whatever the timer resolution turns out to be
+    const auto expected = profile.rate * (now - startTime) / 1000.0;
+    auto count = static_cast<int>(expected - due);
+
+    // Don't build up an ever growing backlog when the listeners can't keep up
+    const auto maxPerTick = juce::jmax(1, static_cast<int>(profile.rate / 10.0));
+    if (count > maxPerTick)
+    {
+        due = expected - maxPerTick;
+        count = maxPerTick;
+    }
+
+    if (count > 0)
+    {
+        const auto batchStart = juce::Time::getHighResolutionTicks();
+
+        if (profile.type == Profile::Type::floatWrites)
+        {
+            applyFloatWrites(count);
+            stats.mutations += count;
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
+                applyChildBurst();
+
+            stats.mutations += (juce::int64)count * profile.burstSize;
+        }
+
+        if (um) um->beginNewTransaction();
+
+        const auto stallMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - batchStart) * 1000.0;
+        stats.totalStallMs += stallMs;
+        stats.maxStallMs = juce::jmax(stats.maxStallMs, stallMs);
+        due += count;
+    }
+
+    stats.elapsedSeconds = (now - startTime) / 1000.0;
+    stats.throughput = stats.elapsedSeconds > 0.0 ? (double)stats.mutations / stats.elapsedSeconds : 0.0;
+    if (um) stats.undoUnits = um->getNumberOfUnitsTakenUpByStoredCommands();
+}
+
+void StressGenerator::applyFloatWrites(int count)
+{
+    if (propertyNames.isEmpty()) return;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const auto& name = propertyNames.getReference(random.nextInt(propertyNames.size()));
+        target.setProperty(name, random.nextDouble(), um);
+    }
+}
+
+void StressGenerator::applyChildBurst()
+{
+    if (burstChildren.isEmpty())
+    {
+        for (int i = 0; i < profile.burstSize; ++i)
+        {
+            juce::ValueTree child{ stressNodeType };
+            target.appendChild(child, um);
+            burstChildren.add(child);
+        }
+    }
+    else
+    {
+        for (auto& child : burstChildren)
+            target.removeChild(child, um);
+
+        burstChildren.clearQuick();
+    }
+}
+
+} // namespace vtdbg
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+namespace vtdbg
+{
+/* Drives synthetic mutations into a subtree and measures what they cost.
+   Value trees and their listeners belong to the message thread, so mutations are
+   applied there in batches, sized each tick to keep up with the requested rate. */
+class StressGenerator : private juce::Timer
+{
+public:
+    struct Profile
+    {
+        enum class Type
+        {
+            floatWrites,  // Random values written to numProperties properties of the target
+            childBursts   // burstSize children added to the target, removed again by the next burst
+        };
+
+        Type type{ Type::floatWrites };
+        /* Mutations per second for floatWrites, bursts per second for childBursts */
+        double rate{ 1000.0 };
+        int numProperties{ 100 };
+        int burstSize{ 100 };
+    };
+
+    struct Stats
+    {
+        juce::int64 mutations{ 0 };
+        double elapsedSeconds{ 0.0 };
+        /* Achieved mutations per second */
+        double throughput{ 0.0 };
+        /* Time spent applying mutations, including every listener they triggered */
+        double totalStallMs{ 0.0 };
+        double maxStallMs{ 0.0 };
+        /* Longest gap between timer callbacks beyond the expected interval */
+        double maxTimerLatenessMs{ 0.0 };
+        int undoUnits{ 0 };
+    };
+
+    ~StressGenerator() override;
+
+    /* Mutations go through the undo manager if one is given, one transaction per batch */
+    void start(juce::ValueTree target, const Profile& profile, juce::UndoManager* undoManager);
+    void stop();
+    bool isRunning() const { return isTimerRunning(); }
+
+    const Stats& getStats() const { return stats; }
+    juce::String getStatsDescription() const;
+
+private:
+    void timerCallback() override;
+    void applyFloatWrites(int count);
+    void applyChildBurst();
+
+    static constexpr int timerIntervalMs{ 1 };
+
+    juce::ValueTree target;
+    Profile profile;
+    juce::UndoManager* um{ nullptr };
+    juce::Array<juce::Identifier> propertyNames;
+    juce::Array<juce::ValueTree> burstChildren;
+    juce::Random random;
+
+    Stats stats;
+    double startTime{ 0.0 };
+    double lastTickTime{ 0.0 };
+    double due{ 0.0 };
+};
+
+} // namespace vtdbg
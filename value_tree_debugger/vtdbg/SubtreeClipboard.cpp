@@ -0,0 +1,84 @@
+#include "SubtreeClipboard.h"
+
+namespace vtdbg
+{
+/* Wraps several subtrees on the system clipboard */
+static const juce::Identifier clipboardTag{ "ValueTreeDebuggerClipboard" };
+
+void SubtreeClipboard::copy(const juce::Array<juce::ValueTree>& trees)
+{
+    juce::Array<juce::ValueTree> roots;
+    for (const auto& tree : trees)
+    {
+        const auto isInside = std::any_of(trees.begin(), trees.end(), [&](const juce::ValueTree& other) { return tree.isAChildOf(other); });
+        if (tree.isValid() && !isInside)
+            roots.add(tree);
+    }
+
+    data.reset();
+    juce::MemoryOutputStream stream{ data, false };
+    stream.writeCompressedInt(roots.size());
+    for (const auto& tree : roots)
+        tree.writeToStream(stream);
+
+    stream.flush();
+
+    if (roots.size() == 1)
+    {
+        systemText = roots.getFirst().toXmlString();
+    }
+    else
+    {
+        juce::XmlElement wrapper{ clipboardTag };
+        for (const auto& tree : roots)
+            wrapper.addChildElement(tree.createXml().release());
+
+        systemText = wrapper.toString();
+    }
+
+    juce::SystemClipboard::copyTextToClipboard(systemText);
+}
+
+juce::Array<juce::ValueTree> SubtreeClipboard::paste() const
+{
+    const auto text = juce::SystemClipboard::getTextFromClipboard();
+    if (text != systemText || data.isEmpty())
+        return fromXmlText(text);
+
+    // Still ours, the binary copy keeps the types of the values which XML loses
+    juce::Array<juce::ValueTree> trees;
+    juce::MemoryInputStream stream{ data, false };
+    const auto count = stream.readCompressedInt();
+
+    for (int i = 0; i < count; ++i)
+    {
+        auto tree = juce::ValueTree::readFromStream(stream);
+        if (!tree.isValid()) break;
+
+        trees.add(tree);
+    }
+
+    return trees;
+}
+
+juce::Array<juce::ValueTree> SubtreeClipboard::fromXmlText(const juce::String& text)
+{
+    juce::Array<juce::ValueTree> trees;
+    auto xml = juce::parseXML(text);
+    if (xml == nullptr) return trees;
+
+    if (xml->hasTagName(clipboardTag.toString()))
+    {
+        for (auto* child : xml->getChildIterator())
+            trees.add(juce::ValueTree::fromXml(*child));
+    }
+    else
+    {
+        trees.add(juce::ValueTree::fromXml(*xml));
+    }
+
+    trees.removeIf([](const juce::ValueTree& tree) { return !tree.isValid(); });
+    return trees;
+}
+
+} // namespace vtdbg
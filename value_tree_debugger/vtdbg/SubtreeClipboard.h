@@ -0,0 +1,30 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+namespace vtdbg
+{
+/* Copied subtrees in the compact binary format of ValueTree::writeToStream, shared by every
+   debugger in the process through a SharedResourcePointer. The system clipboard gets the same
+   subtrees as XML, so they can be pasted into a text editor or from another process. */
+class SubtreeClipboard
+{
+public:
+    /* Subtrees inside others in the array are copied as part of them only */
+    void copy(const juce::Array<juce::ValueTree>& trees);
+
+    /* Detached copies of the copied subtrees, ready to be added in one go. If something else has
+       been put on the system clipboard since, it is read as XML instead. */
+    juce::Array<juce::ValueTree> paste() const;
+
+    int getNumBytes() const { return static_cast<int>(data.getSize()); }
+
+private:
+    static juce::Array<juce::ValueTree> fromXmlText(const juce::String& text);
+
+    juce::MemoryBlock data;
+    /* What was put on the system clipboard, to tell if it has been replaced */
+    juce::String systemText;
+};
+
+} // namespace vtdbg
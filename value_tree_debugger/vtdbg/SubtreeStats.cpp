@@ -0,0 +1,309 @@
+#include "SubtreeStats.h"
+
+namespace vtdbg
+{
+/* Nodes visited between checks for cancellation */
+constexpr int nodesPerCancelCheck{ 1024 };
+/* Batches per thread, so a thread which finishes early can take another */
+constexpr int batchesPerThread{ 4 };
+
+SubtreeStats::ValueType SubtreeStats::getValueType(const juce::var& value)
+{
+    if (value.isVoid())       return voidType;
+    if (value.isUndefined())  return undefinedType;
+    if (value.isInt())        return intType;
+    if (value.isInt64())      return int64Type;
+    if (value.isBool())       return boolType;
+    if (value.isDouble())     return doubleType;
+    if (value.isString())     return stringType;
+    if (value.isArray())      return arrayType;
+    if (value.isBinaryData()) return binaryType;
+    if (value.isMethod())     return methodType;
+    if (value.isObject())     return objectType;
+
+    jassertfalse;
+    return voidType;
+}
+
+const char* SubtreeStats::getValueTypeName(ValueType type)
+{
+    static const char* names[numValueTypes]
+    {
+        "Void", "Undefined", "Int", "Int64", "Bool", "Double", "String", "Object", "Array", "BinaryData", "Method"
+    };
+
+    return names[type];
+}
+
+int SubtreeStats::getFanOutBucket(int numChildren)
+{
+    int bucket = 0;
+    while (numChildren > 0 && bucket < numFanOutBuckets - 1)
+    {
+        numChildren >>= 1;
+        ++bucket;
+    }
+
+    return bucket;
+}
+
+void SubtreeStats::addNode(const FlatTreeModel& model, int node, int rootDepth)
+{
+    addNodeShape(model.getDepth(node) - rootDepth, model.getNumChildren(node));
+
+    for (int i = 0; i < model.getNumProperties(node); ++i)
+        addProperty(model.getNodeId(node), model.getPropertyName(node, i), model.getPropertyValue(node, i));
+}
+
+void SubtreeStats::addNodeShape(int depth, int numChildren)
+{
+    ++numNodes;
+    maxDepth = juce::jmax(maxDepth, depth);
+    ++fanOut[(size_t)getFanOutBucket(numChildren)];
+}
+
+void SubtreeStats::addProperty(FlatTreeModel::NodeId node, const juce::Identifier& name, const juce::var& value)
+{
+    const auto type = getValueType(value);
+    ++propertiesByType[(size_t)type];
+
+    juce::int64 bytes{ 0 };
+    if (type == stringType)
+    {
+        bytes = (juce::int64)value.toString().getNumBytesAsUTF8();
+        stringBytes += bytes;
+    }
+    else if (type == binaryType)
+    {
+        bytes = (juce::int64)value.getBinaryData()->getSize();
+    }
+
+    if (bytes > 0 && ((int)largest.size() < numLargestValues || bytes > largest.back().bytes))
+        addLargeValue({ node, name, bytes, type == stringType ? value.toString().substring(0, 40) : juce::String{ "<binary>" } });
+}
+
+void SubtreeStats::merge(const SubtreeStats& other)
+{
+    numNodes += other.numNodes;
+    maxDepth = juce::jmax(maxDepth, other.maxDepth);
+    stringBytes += other.stringBytes;
+
+    for (size_t i = 0; i < fanOut.size(); ++i)
+        fanOut[i] += other.fanOut[i];
+
+    for (size_t i = 0; i < propertiesByType.size(); ++i)
+        propertiesByType[i] += other.propertiesByType[i];
+
+    for (auto value : other.largest)
+        addLargeValue(std::move(value));
+}
+
+void SubtreeStats::addLargeValue(LargeValue&& value)
+{
+    auto it = std::find_if(largest.begin(), largest.end(), [&](const LargeValue& v) { return v.bytes < value.bytes; });
+    largest.insert(it, std::move(value));
+
+    if ((int)largest.size() > numLargestValues)
+        largest.pop_back();
+}
+
+juce::String SubtreeStats::getDescription() const
+{
+    juce::String description;
+    description << numNodes << " nodes, max depth " << maxDepth << ", computed in " << juce::String{ computeMs, 1 } << " ms" << juce::newLine;
+
+    description << juce::newLine << "Children per node" << juce::newLine;
+    for (int bucket = 0; bucket < numFanOutBuckets; ++bucket)
+    {
+        if (fanOut[(size_t)bucket] == 0) continue;
+
+        const auto low = bucket == 0 ? 0 : 1 << (bucket - 1);
+        const auto range = bucket == 0 ? juce::String{ "0" }
+                         : bucket == numFanOutBuckets - 1 ? juce::String{ low } + "+"
+                         : juce::String{ low } + "-" + juce::String{ (1 << bucket) - 1 };
+        description << "  " << range << ": " << fanOut[(size_t)bucket] << juce::newLine;
+    }
+
+    description << juce::newLine << "Properties by type" << juce::newLine;
+    for (int type = 0; type < numValueTypes; ++type)
+        if (propertiesByType[(size_t)type] > 0)
+            description << "  " << getValueTypeName((ValueType)type) << ": " << propertiesByType[(size_t)type] << juce::newLine;
+
+    description << "  String bytes: " << stringBytes << juce::newLine;
+
+    if (!largest.empty())
+    {
+        description << juce::newLine << "Largest values" << juce::newLine;
+        for (const auto& value : largest)
+            description << "  " << value.bytes << " bytes, node " << (juce::int64)value.node << " " << value.property.toString() << ": " << value.preview << juce::newLine;
+    }
+
+    return description;
+}
+
+// ============================================================================
+
+struct StatsCollector::Computation
+{
+    std::shared_ptr<const FlatTreeModel> snapshot;
+    int rootDepth{ 0 };
+    /* Filled by one job each, no locking needed */
+    std::vector<SubtreeStats> parts;
+    std::atomic<int> remaining{ 0 };
+    std::atomic<bool> cancelled{ false };
+    double startTime{ 0.0 };
+    std::function<void(const SubtreeStats&)> onDone;
+
+    void finish()
+    {
+        for (size_t i = 1; i < parts.size(); ++i)
+            parts[0].merge(parts[i]);
+
+        parts[0].computeMs = juce::Time::getMillisecondCounterHiRes() - startTime;
+    }
+};
+
+class StatsCollector::BatchJob : public juce::ThreadPoolJob
+{
+public:
+    BatchJob(std::shared_ptr<Computation> computationToUse, std::vector<int> subtreeRoots, size_t partIndex) :
+        juce::ThreadPoolJob("vtdbg stats"),
+        computation(std::move(computationToUse)),
+        roots(std::move(subtreeRoots)),
+        part(partIndex)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        const auto& model = *computation->snapshot;
+        auto& stats = computation->parts[part];
+        int sinceCheck{ 0 };
+
+        for (auto root : roots)
+        {
+            if (computation->cancelled) break;
+
+            model.forEachInSubtree(root, [&](int node)
+            {
+                // forEachInSubtree can't be stopped, so just skip the rest once cancelled
+                if (++sinceCheck >= nodesPerCancelCheck)
+                {
+                    sinceCheck = 0;
+                    if (shouldExit()) computation->cancelled = true;
+                }
+
+                if (!computation->cancelled)
+                    stats.addNode(model, node, computation->rootDepth);
+            });
+        }
+
+        // The last job to finish merges the parts and posts the result
+        if (computation->remaining.fetch_sub(1) == 1 && !computation->cancelled)
+        {
+            computation->finish();
+
+            juce::MessageManager::callAsync([c = computation]()
+            {
+                // Cancelling happens on the message thread too, so this check can't race with it
+                if (!c->cancelled && c->onDone)
+                    c->onDone(c->parts[0]);
+            });
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    std::shared_ptr<Computation> computation;
+    std::vector<int> roots;
+    size_t part;
+};
+
+// ============================================================================
+
+juce::ThreadPool& StatsCollector::SharedPool::get()
+{
+    if (pool == nullptr)
+        pool = std::make_unique<juce::ThreadPool>(juce::jmax(1, juce::SystemStats::getNumCpus() - 1));
+
+    return *pool;
+}
+
+StatsCollector::StatsCollector() = default;
+
+StatsCollector::~StatsCollector()
+{
+    // Jobs still running own their snapshot and drop their result once cancelled, the pool
+    // waits for them when the last collector goes
+    cancel();
+}
+
+void StatsCollector::start(const FlatTreeModel& model, int subtreeRoot, std::function<void(const SubtreeStats&)> onDone)
+{
+    cancel();
+    if (subtreeRoot == FlatTreeModel::none) return;
+
+    auto computation = std::make_shared<Computation>();
+    computation->startTime = juce::Time::getMillisecondCounterHiRes();
+    computation->snapshot = model.createSnapshot();
+    computation->rootDepth = model.getDepth(subtreeRoot);
+    computation->onDone = [this, callback = std::move(onDone)](const SubtreeStats& stats)
+    {
+        current.reset();
+        if (callback) callback(stats);
+    };
+
+    // Split off the top levels until there are enough subtrees to go round, counting the
+    // nodes above them here, that's only a few levels
+    auto& pool = sharedPool->get();
+    const auto numBatches = pool.getNumThreads() * batchesPerThread;
+    SubtreeStats top;
+    std::vector<int> frontier{ subtreeRoot };
+
+    while ((int)frontier.size() < numBatches)
+    {
+        std::vector<int> next;
+        for (auto node : frontier)
+        {
+            if (model.getNumChildren(node) == 0)
+            {
+                next.push_back(node);
+                continue;
+            }
+
+            top.addNode(model, node, computation->rootDepth);
+            for (auto child = model.getFirstChild(node); child != FlatTreeModel::none; child = model.getNextSibling(child))
+                next.push_back(child);
+        }
+
+        const bool onlyLeaves = next.size() == frontier.size();
+        frontier = std::move(next);
+        if (onlyLeaves) break;
+    }
+
+    // Contiguous runs of the frontier, neighbouring subtrees tend to be alike
+    const auto batches = juce::jmin(numBatches, (int)frontier.size());
+    computation->parts.resize((size_t)batches + 1);
+    computation->parts[(size_t)batches] = std::move(top);
+    computation->remaining = batches;
+    current = computation;
+
+    for (int b = 0; b < batches; ++b)
+    {
+        const auto begin = frontier.begin() + (ptrdiff_t)((size_t)b * frontier.size() / (size_t)batches);
+        const auto end = frontier.begin() + (ptrdiff_t)((size_t)(b + 1) * frontier.size() / (size_t)batches);
+        pool.addJob(new BatchJob(computation, { begin, end }, (size_t)b), true);
+    }
+}
+
+void StatsCollector::cancel()
+{
+    if (current == nullptr) return;
+
+    // Running jobs see the flag and stop, their results are dropped
+    current->cancelled = true;
+    current.reset();
+}
+
+} // namespace vtdbg
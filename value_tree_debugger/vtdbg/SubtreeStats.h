@@ -0,0 +1,104 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace vtdbg
+{
+/* Statistics of a subtree, computed in parts which are then merged */
+struct SubtreeStats
+{
+    enum ValueType
+    {
+        voidType = 0,
+        undefinedType,
+        intType,
+        int64Type,
+        boolType,
+        doubleType,
+        stringType,
+        objectType,
+        arrayType,
+        binaryType,
+        methodType,
+        numValueTypes
+    };
+
+    static ValueType getValueType(const juce::var& value);
+    static const char* getValueTypeName(ValueType type);
+
+    /* Fan-out bucket b counts nodes with [2^(b-1), 2^b) children, bucket 0 those with none */
+    static constexpr int numFanOutBuckets{ 12 };
+    static int getFanOutBucket(int numChildren);
+
+    struct LargeValue
+    {
+        FlatTreeModel::NodeId node{ 0 };
+        juce::Identifier property;
+        juce::int64 bytes{ 0 };
+        juce::String preview;
+    };
+
+    static constexpr int numLargestValues{ 10 };
+
+    /* Count one node of the model, without its descendants */
+    void addNode(const FlatTreeModel& model, int node, int rootDepth);
+    /* The same in parts, for nodes which aren't in a model, such as ones read from a stream */
+    void addNodeShape(int depth, int numChildren);
+    void addProperty(FlatTreeModel::NodeId node, const juce::Identifier& name, const juce::var& value);
+    void merge(const SubtreeStats& other);
+    juce::String getDescription() const;
+
+    juce::int64 numNodes{ 0 };
+    int maxDepth{ 0 };
+    std::array<juce::int64, numFanOutBuckets> fanOut{};
+    std::array<juce::int64, numValueTypes> propertiesByType{};
+    juce::int64 stringBytes{ 0 };
+    /* Largest string and binary values, largest first */
+    std::vector<LargeValue> largest;
+    double computeMs{ 0.0 };
+
+private:
+    void addLargeValue(LargeValue&& value);
+};
+
+/* Computes SubtreeStats on a thread pool over a snapshot of the model, which shares the
+   model's arrays until it changes them, so the message thread pays little for it and the
+   model can go on changing while the stats are computed. The subtree is split at its top levels into batches of
+   smaller subtrees, several per thread so uneven subtrees still keep every thread busy.
+   Every collector shares one pool, made by the first computation. */
+class StatsCollector
+{
+public:
+    StatsCollector();
+    ~StatsCollector();
+
+    /* Starts over the snapshot, cancelling any computation in progress. The callback is called
+       on the message thread, unless the computation is cancelled first. */
+    void start(const FlatTreeModel& model, int subtreeRoot, std::function<void(const SubtreeStats&)> onDone);
+    void cancel();
+    bool isRunning() const { return current != nullptr; }
+
+private:
+    struct Computation;
+    class BatchJob;
+
+    struct SharedPool
+    {
+        juce::ThreadPool& get();
+
+        std::unique_ptr<juce::ThreadPool> pool;
+    };
+
+    juce::SharedResourcePointer<SharedPool> sharedPool;
+    std::shared_ptr<Computation> current;
+};
+
+} // namespace vtdbg
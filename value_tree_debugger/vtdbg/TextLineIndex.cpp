@@ -0,0 +1,74 @@
+#include "TextLineIndex.h"
+
+namespace vtdbg
+{
+void TextLineIndex::build(const juce::String& textToIndex)
+{
+    text = textToIndex;
+    lineStarts.clear();
+    lineStarts.push_back(0);
+    longestLine = 0;
+
+    const auto* start = text.toRawUTF8();
+    const auto* end = start;
+    for (; *end != 0; ++end)
+    {
+        if (*end != '\n') continue;
+
+        const auto next = static_cast<int>(end - start) + 1;
+        longestLine = juce::jmax(longestLine, next - 1 - lineStarts.back());
+        lineStarts.push_back(next);
+    }
+
+    numBytes = static_cast<int>(end - start);
+    longestLine = juce::jmax(longestLine, numBytes - lineStarts.back());
+}
+
+void TextLineIndex::clear()
+{
+    text = {};
+    lineStarts.clear();
+    numBytes = 0;
+    longestLine = 0;
+}
+
+juce::String TextLineIndex::getLine(int line, int firstCharacter, int maxCharacters) const
+{
+    if (!juce::isPositiveAndBelow(line, getNumLines())) return {};
+
+    const auto* data = text.toRawUTF8();
+    const auto* lineEnd = data + (line + 1 < getNumLines() ? lineStarts[(size_t)line + 1] - 1 : numBytes);
+    juce::CharPointer_UTF8 pos{ data + lineStarts[(size_t)line] };
+
+    for (int i = 0; i < firstCharacter && pos.getAddress() < lineEnd; ++i)
+        ++pos;
+
+    auto last = pos;
+    for (int i = 0; i < maxCharacters && last.getAddress() < lineEnd; ++i)
+        ++last;
+
+    // Windows line breaks
+    if (last.getAddress() == lineEnd && last.getAddress() > pos.getAddress() && *(lineEnd - 1) == '\r')
+        return juce::String{ pos, juce::CharPointer_UTF8{ lineEnd - 1 } };
+
+    return juce::String{ pos, last };
+}
+
+bool TextLineIndex::isLarge(const juce::String& textToTest)
+{
+    const auto* data = textToTest.toRawUTF8();
+    for (int i = 0; i <= largeTextBytes; ++i)
+    {
+        if (data[i] == 0) return false;
+        if (data[i] == '\n') return true;
+    }
+
+    return true;
+}
+
+juce::String TextLineIndex::describe() const
+{
+    return juce::File::descriptionOfSizeInBytes(numBytes) + ", " + juce::String{ getNumLines() } + (getNumLines() == 1 ? " line" : " lines");
+}
+
+} // namespace vtdbg
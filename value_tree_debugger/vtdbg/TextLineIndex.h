@@ -0,0 +1,43 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include <vector>
+
+namespace vtdbg
+{
+/* Where each line of a string starts, built once per value so a viewer only reads the lines it
+   shows. The string is shared with the value, not copied. Offsets are in UTF-8 bytes. */
+class TextLineIndex
+{
+public:
+    void build(const juce::String& textToIndex);
+    void clear();
+
+    /* The same text object, without comparing the contents */
+    bool isIndexOf(const juce::String& other) const { return text.getCharPointer() == other.getCharPointer(); }
+
+    int getNumLines() const { return static_cast<int>(lineStarts.size()); }
+    int getNumBytes() const { return numBytes; }
+    /* In bytes, for the width of a horizontal scroll range */
+    int getLongestLine() const { return longestLine; }
+    const juce::String& getText() const { return text; }
+
+    /* Up to maxCharacters of a line, starting at firstCharacter, without its line break */
+    juce::String getLine(int line, int firstCharacter, int maxCharacters) const;
+
+    /* Strings longer than this or with more than one line are shown by the large text viewer */
+    static constexpr int largeTextBytes{ 256 };
+    /* Reads at most largeTextBytes */
+    static bool isLarge(const juce::String& textToTest);
+    /* Size and line count of the text indexed, such as "12.4 KB, 340 lines", read from the index */
+    juce::String describe() const;
+
+private:
+    juce::String text;
+    std::vector<int> lineStarts;
+    int numBytes{ 0 };
+    int longestLine{ 0 };
+};
+
+} // namespace vtdbg
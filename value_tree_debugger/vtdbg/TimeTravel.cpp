@@ -0,0 +1,318 @@
+#include "TimeTravel.h"
+
+#include "SessionStats.h"
+
+#include <algorithm>
+
+namespace vtdbg
+{
+TimeTravel::TimeTravel()
+{
+    reset();
+}
+
+void TimeTravel::reset()
+{
+    startMs = juce::Time::getMillisecondCounterHiRes();
+    rootType = {};
+    keyframes.clear();
+    deltas.clear();
+    firstDelta = 0;
+    deltasSinceKeyframe = 0;
+    bytesSinceKeyframe = 0;
+    numBytes = 0;
+    needsKeyframe = true;
+    seekTarget = {};
+    cursor = -1;
+    nodes.clear();
+}
+
+void TimeTravel::setRetention(double maxSeconds, juce::int64 maxBytes)
+{
+    retentionSeconds = juce::jmax(0.0, maxSeconds);
+    retentionBytes = juce::jmax((juce::int64)0, maxBytes);
+
+    if (isEnabled())
+        applyRetention();
+    else
+        reset();
+}
+
+double TimeTravel::now() const
+{
+    return (juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+}
+
+double TimeTravel::getStartSeconds() const
+{
+    return keyframes.empty() ? 0.0 : keyframes.front().seconds;
+}
+
+double TimeTravel::getEndSeconds() const
+{
+    return keyframes.empty() ? 0.0 : juce::jmax(keyframes.back().seconds, deltas.empty() ? 0.0 : deltas.back().seconds);
+}
+
+void TimeTravel::treeRebuilt(const FlatTreeModel& model)
+{
+    needsKeyframe = true;
+
+    if (isEnabled() && model.getRoot() != FlatTreeModel::none && !model.isBuilding())
+        addKeyframe(model);
+}
+
+void TimeTravel::propertyChanged(const FlatTreeModel& model, int node, const juce::Identifier& property)
+{
+    if (!prepare(model)) return;
+
+    Delta delta{ now(), DeltaType::setProperty, model.getNodeId(node) };
+    delta.name = property;
+
+    if (const auto* value = model.getTree(node).getPropertyPointer(property))
+        delta.value = *value;
+    else
+        delta.type = DeltaType::removeProperty;
+
+    addDelta(std::move(delta));
+}
+
+void TimeTravel::childAdded(const FlatTreeModel& model, int child, int index)
+{
+    if (!prepare(model)) return;
+
+    Delta delta{ now(), DeltaType::addChild, model.getNodeId(model.getParent(child)) };
+    delta.index = index;
+    delta.subtree = model.getTree(child).createCopy();
+    collectIds(model, child, delta.ids);
+    addDelta(std::move(delta));
+}
+
+void TimeTravel::childRemoved(const FlatTreeModel& model, int parentNode, int index)
+{
+    if (!prepare(model)) return;
+
+    Delta delta{ now(), DeltaType::removeChild, model.getNodeId(parentNode) };
+    delta.index = index;
+    addDelta(std::move(delta));
+}
+
+void TimeTravel::childMoved(const FlatTreeModel& model, int parentNode, int oldIndex, int newIndex)
+{
+    if (!prepare(model)) return;
+
+    Delta delta{ now(), DeltaType::moveChild, model.getNodeId(parentNode) };
+    delta.index = newIndex;
+    delta.oldIndex = oldIndex;
+    addDelta(std::move(delta));
+}
+
+bool TimeTravel::prepare(const FlatTreeModel& model)
+{
+    if (!isEnabled() || model.getRoot() == FlatTreeModel::none) return false;
+
+    // Deltas can only refer to nodes a keyframe has ids for
+    if (model.isBuilding())
+    {
+        needsKeyframe = true;
+        return false;
+    }
+
+    // The change has been made, so a keyframe taken now already holds it
+    if (needsKeyframe || deltasSinceKeyframe >= juce::jmax(minDeltasPerKeyframe, model.getNumNodes())
+        || (retentionBytes > 0 && bytesSinceKeyframe >= retentionBytes / keyframesPerRetentionBytes))
+    {
+        addKeyframe(model);
+        return false;
+    }
+
+    return true;
+}
+
+void TimeTravel::addKeyframe(const FlatTreeModel& model)
+{
+    const auto& root = model.getTree(model.getRoot());
+
+    // A tree of a new type can't be shown in a target made for the old one, so its history starts again
+    if (rootType.isValid() && root.getType() != rootType)
+    {
+        firstDelta += (juce::int64)deltas.size();
+        keyframes.clear();
+        deltas.clear();
+        numBytes = 0;
+        cursor = -1;
+    }
+
+    rootType = root.getType();
+
+    Keyframe keyframe{ now(), firstDelta + (juce::int64)deltas.size() };
+    {
+        juce::MemoryOutputStream stream{ keyframe.data, false };
+        root.writeToStream(stream);
+    }
+    collectIds(model, model.getRoot(), keyframe.ids);
+
+    numBytes += (juce::int64)keyframe.data.getSize() + (juce::int64)(keyframe.ids.size() * sizeof(MirroredNode));
+    keyframes.push_back(std::move(keyframe));
+    deltasSinceKeyframe = 0;
+    bytesSinceKeyframe = 0;
+    needsKeyframe = false;
+
+    applyRetention();
+}
+
+void TimeTravel::addDelta(Delta&& delta)
+{
+    const auto bytes = estimateBytes(delta);
+    numBytes += bytes;
+    bytesSinceKeyframe += bytes;
+    deltas.push_back(std::move(delta));
+    ++deltasSinceKeyframe;
+}
+
+void TimeTravel::applyRetention()
+{
+    // The oldest keyframe goes once the next one alone covers the retention time, or the size is over
+    while (keyframes.size() > 1)
+    {
+        const auto& next = keyframes[1];
+        const auto coveredWithout = now() - next.seconds;
+        if (coveredWithout < retentionSeconds && numBytes <= retentionBytes) break;
+
+        const auto& oldest = keyframes.front();
+        numBytes -= (juce::int64)oldest.data.getSize() + (juce::int64)(oldest.ids.size() * sizeof(MirroredNode));
+
+        for (; firstDelta < next.firstDelta; ++firstDelta)
+        {
+            numBytes -= estimateBytes(deltas.front());
+            deltas.pop_front();
+        }
+
+        keyframes.pop_front();
+    }
+}
+
+juce::int64 TimeTravel::estimateBytes(const Delta& delta)
+{
+    auto bytes = (juce::int64)sizeof(Delta) + (juce::int64)(delta.ids.size() * sizeof(MirroredNode));
+
+    if (delta.type == DeltaType::setProperty)
+        bytes += SessionStats::getValueSize(delta.value);
+
+    // Nodes and properties of an added subtree, roughly
+    if (delta.subtree.isValid())
+        bytes += (juce::int64)delta.ids.size() * 64;
+
+    return bytes;
+}
+
+void TimeTravel::collectIds(const FlatTreeModel& model, int node, std::vector<MirroredNode>& ids)
+{
+    ids.clear();
+    model.forEachInSubtree(node, [&](int n) { ids.push_back({ model.getNodeId(n), model.getNumChildren(n) }); });
+}
+
+void TimeTravel::seek(juce::ValueTree& target, double seconds)
+{
+    if (keyframes.empty() || target.getType() != rootType) return;
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    // The last keyframe at or before the time, the first one for earlier times
+    auto keyframe = std::upper_bound(keyframes.begin(), keyframes.end(), seconds,
+                                     [](double time, const Keyframe& k) { return time < k.seconds; });
+    if (keyframe != keyframes.begin())
+        --keyframe;
+
+    // Carry on from the last seek if it is on the way, else start from the keyframe
+    const auto canContinue = target == seekTarget && cursor >= firstDelta && seconds >= cursorSeconds && cursor >= keyframe->firstDelta;
+    if (!canContinue)
+    {
+        restore(target, *keyframe);
+        cursor = keyframe->firstDelta;
+    }
+
+    const auto end = firstDelta + (juce::int64)deltas.size();
+    for (; cursor < end; ++cursor)
+    {
+        const auto& delta = deltas[(size_t)(cursor - firstDelta)];
+        if (delta.seconds > seconds) break;
+
+        apply(delta);
+    }
+
+    cursorSeconds = seconds;
+    lastSeekMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+}
+
+void TimeTravel::restore(juce::ValueTree& target, const Keyframe& keyframe)
+{
+    const auto tree = juce::ValueTree::readFromData(keyframe.data.getData(), keyframe.data.getSize());
+
+    // The target keeps its identity, so the listeners attached to it stay
+    target.copyPropertiesAndChildrenFrom(tree, nullptr);
+    seekTarget = target;
+
+    nodes.clear();
+    mapSubtree(target, keyframe.ids);
+}
+
+void TimeTravel::apply(const Delta& delta)
+{
+    auto node = findNode(delta.node);
+    if (!node.isValid()) return;
+
+    switch (delta.type)
+    {
+    case DeltaType::setProperty:
+        node.setProperty(delta.name, delta.value, nullptr);
+        break;
+
+    case DeltaType::removeProperty:
+        node.removeProperty(delta.name, nullptr);
+        break;
+
+    case DeltaType::addChild:
+    {
+        auto child = delta.subtree.createCopy();
+        mapSubtree(child, delta.ids);
+        node.addChild(child, delta.index, nullptr);
+        break;
+    }
+
+    case DeltaType::removeChild:
+        if (juce::isPositiveAndBelow(delta.index, node.getNumChildren()))
+            node.removeChild(delta.index, nullptr);
+        break;
+
+    case DeltaType::moveChild:
+        if (juce::isPositiveAndBelow(delta.oldIndex, node.getNumChildren()))
+            node.moveChild(delta.oldIndex, delta.index, nullptr);
+        break;
+    }
+}
+
+void TimeTravel::mapSubtree(const juce::ValueTree& tree, const std::vector<MirroredNode>& ids)
+{
+    // Ids are in tree order, walk the mirrored part of the subtree in the same order without recursion
+    size_t next = 0;
+    std::vector<juce::ValueTree> stack{ tree };
+
+    while (!stack.empty() && next < ids.size())
+    {
+        const auto node = stack.back();
+        stack.pop_back();
+        const auto& mirrored = ids[next++];
+        nodes[mirrored.id] = node;
+
+        for (int i = juce::jmin(mirrored.numChildren, node.getNumChildren()); --i >= 0;)
+            stack.push_back(node.getChild(i));
+    }
+}
+
+juce::ValueTree TimeTravel::findNode(FlatTreeModel::NodeId id) const
+{
+    const auto it = nodes.find(id);
+    return it != nodes.end() ? it->second : juce::ValueTree{};
+}
+
+} // namespace vtdbg
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace vtdbg
+{
+/* The history of a tree over a session, to see it as it was at any earlier time.
+   Keyframes are binary copies of the whole tree, with the node ids of the copy in tree order.
+   Between them every change is kept as a delta naming nodes by id. A past state is the nearest
+   keyframe before it with the deltas up to it applied. A keyframe is taken after as many deltas
+   as the tree has nodes, with a minimum, so keyframes cost O(1) per change and a seek applies
+   at most that many deltas. One is also taken once the deltas since the last one reach a
+   fraction of the retention size, so there is always an older keyframe to drop with its deltas:
+   the history stays within the size, plus the latest keyframe when that alone is larger.
+   Nothing is kept until a retention is set. */
+class TimeTravel
+{
+public:
+    TimeTravel();
+
+    /* Forget the history, for a new tree whose node ids are all new */
+    void reset();
+
+    /* Zero seconds, the default, stops recording and forgets the history */
+    void setRetention(double maxSeconds, juce::int64 maxBytes);
+    bool isEnabled() const { return retentionSeconds > 0.0; }
+
+    /* Called once a rebuilt model is complete. Its node ids are all new, so the history goes on
+       from a keyframe of it. */
+    void treeRebuilt(const FlatTreeModel& model);
+
+    // Called after the model has been updated
+    void propertyChanged(const FlatTreeModel& model, int node, const juce::Identifier& property);
+    void childAdded(const FlatTreeModel& model, int child, int index);
+    void childRemoved(const FlatTreeModel& model, int parentNode, int index);
+    void childMoved(const FlatTreeModel& model, int parentNode, int oldIndex, int newIndex);
+
+    bool hasHistory() const { return !keyframes.empty(); }
+    /* Seconds since the history started, the earliest and latest which can be shown */
+    double getStartSeconds() const;
+    double getEndSeconds() const;
+    /* Type of the root, the target of seek must have it */
+    juce::Identifier getRootType() const { return rootType; }
+
+    /* Make the target the tree as it was at the time, changing it in place so listeners of the
+       target see the changes. Going forward from the last seek only applies the deltas between,
+       going back starts from the nearest keyframe. */
+    void seek(juce::ValueTree& target, double seconds);
+
+    int getNumKeyframes() const { return static_cast<int>(keyframes.size()); }
+    int getNumDeltas() const { return static_cast<int>(deltas.size()); }
+    juce::int64 getNumBytes() const { return numBytes; }
+    double getLastSeekMs() const { return lastSeekMs; }
+
+    static constexpr int minDeltasPerKeyframe{ 1000 };
+    /* A keyframe is taken at the latest when the deltas since the last one reach this part of the retention size */
+    static constexpr int keyframesPerRetentionBytes{ 4 };
+    /* What the debugger keeps once time travel is first opened */
+    static constexpr double defaultRetentionSeconds{ 300.0 };
+    static constexpr juce::int64 defaultRetentionBytes{ 64 * 1024 * 1024 };
+
+private:
+    enum class DeltaType : juce::uint8
+    {
+        setProperty,
+        removeProperty,
+        addChild,
+        removeChild,
+        moveChild,
+    };
+
+    /* A node of a keyframe or added subtree, in tree order. Only the first numChildren children of
+       the copy are mirrored, the rest are in subtrees the model leaves out, see ExclusionFilter. */
+    struct MirroredNode
+    {
+        FlatTreeModel::NodeId id;
+        int numChildren;
+    };
+
+    struct Delta
+    {
+        double seconds;
+        DeltaType type;
+        /* The changed node, or the parent of a structural change */
+        FlatTreeModel::NodeId node;
+        int index{ 0 };
+        int oldIndex{ 0 };
+        juce::Identifier name;
+        juce::var value;
+        /* Copy of an added child, with its node ids in tree order */
+        juce::ValueTree subtree;
+        std::vector<MirroredNode> ids;
+    };
+
+    struct Keyframe
+    {
+        double seconds;
+        /* Number of the first delta after it */
+        juce::int64 firstDelta;
+        juce::MemoryBlock data;
+        std::vector<MirroredNode> ids;
+    };
+
+    double now() const;
+    /* Returns false if the change needs no delta: while the model is still being built, after which
+       the history goes on from a keyframe, or when a keyframe holding the change was just taken */
+    bool prepare(const FlatTreeModel& model);
+    void addKeyframe(const FlatTreeModel& model);
+    void addDelta(Delta&& delta);
+    void applyRetention();
+    static juce::int64 estimateBytes(const Delta& delta);
+    static void collectIds(const FlatTreeModel& model, int node, std::vector<MirroredNode>& ids);
+
+    void restore(juce::ValueTree& target, const Keyframe& keyframe);
+    void apply(const Delta& delta);
+    void mapSubtree(const juce::ValueTree& tree, const std::vector<MirroredNode>& ids);
+    juce::ValueTree findNode(FlatTreeModel::NodeId id) const;
+
+    double retentionSeconds{ 0.0 };
+    juce::int64 retentionBytes{ 0 };
+
+    double startMs{ 0.0 };
+    juce::Identifier rootType;
+    std::deque<Keyframe> keyframes;
+    std::deque<Delta> deltas;
+    /* Number of the delta at the front */
+    juce::int64 firstDelta{ 0 };
+    juce::int64 deltasSinceKeyframe{ 0 };
+    juce::int64 bytesSinceKeyframe{ 0 };
+    juce::int64 numBytes{ 0 };
+    bool needsKeyframe{ true };
+
+    // Where the last seek left its target
+    juce::ValueTree seekTarget;
+    /* Number of the next delta to apply, or -1 if the target must be restored from a keyframe */
+    juce::int64 cursor{ -1 };
+    double cursorSeconds{ 0.0 };
+    std::unordered_map<FlatTreeModel::NodeId, juce::ValueTree> nodes;
+    double lastSeekMs{ 0.0 };
+};
+
+} // namespace vtdbg
@@ -0,0 +1,131 @@
+#include "TraceExporter.h"
+
+#if JUCE_WINDOWS
+ #include <process.h>
+#else
+ #include <unistd.h>
+#endif
+
+namespace vtdbg
+{
+/* Longest value written into an event, longer values are cut */
+constexpr int maxTracedValueLength{ 128 };
+
+TraceExporter::~TraceExporter()
+{
+    stop();
+}
+
+juce::Result TraceExporter::start(const juce::File& file, bool includeCallbackDurations, std::function<double()> clockMicroseconds)
+{
+    stop();
+
+    file.deleteFile();
+    auto newStream = std::make_unique<juce::FileOutputStream>(file);
+    if (newStream->failedToOpen())
+        return newStream->getStatus();
+
+    stream = std::move(newStream);
+    clock = std::move(clockMicroseconds);
+    callbackDurations = includeCallbackDurations;
+    numEvents = 0;
+
+    // The JSON array format may be left unterminated, so a trace that was never stopped still loads
+    buffer << "[";
+    return juce::Result::ok();
+}
+
+void TraceExporter::stop()
+{
+    if (stream == nullptr) return;
+
+    buffer << "\n]\n";
+    stream->write(buffer.getData(), buffer.getDataSize());
+    stream->flush();
+    buffer.reset();
+    stream.reset();
+}
+
+void TraceExporter::propertyChanged(juce::uint32 nodeId, const juce::Identifier& type, const juce::Identifier& property, const juce::var& value)
+{
+    if (stream == nullptr) return;
+
+    beginEvent("setProperty", "i", now());
+    buffer << ",\"s\":\"t\",\"args\":{\"node\":" << (juce::int64)nodeId
+           << ",\"type\":" << juce::JSON::toString(type.toString(), true)
+           << ",\"property\":" << juce::JSON::toString(property.toString(), true)
+           << ",\"value\":" << juce::JSON::toString(value.toString().substring(0, maxTracedValueLength), true)
+           << "}";
+    endEvent();
+}
+
+void TraceExporter::structureChanged(const char* name, juce::uint32 parentNodeId, const juce::Identifier& parentType, int index)
+{
+    if (stream == nullptr) return;
+
+    beginEvent(name, "i", now());
+    buffer << ",\"s\":\"t\",\"args\":{\"parent\":" << (juce::int64)parentNodeId
+           << ",\"type\":" << juce::JSON::toString(parentType.toString(), true)
+           << ",\"index\":" << index
+           << "}";
+    endEvent();
+}
+
+double TraceExporter::now() const
+{
+    return clock ? clock() : juce::Time::getMillisecondCounterHiRes() * 1000.0;
+}
+
+void TraceExporter::beginEvent(const char* name, const char* phase, double microseconds)
+{
+    static const auto processId = getProcessId();
+    const auto threadId = (juce::int64)(juce::pointer_sized_int)juce::Thread::getCurrentThreadId();
+
+    buffer << (numEvents == 0 ? "\n" : ",\n")
+           << "{\"name\":\"" << name << "\",\"cat\":\"valuetree\",\"ph\":\"" << phase
+           << "\",\"ts\":" << juce::String{ microseconds, 3 }
+           << ",\"pid\":" << processId << ",\"tid\":" << threadId;
+}
+
+void TraceExporter::endEvent()
+{
+    buffer << "}";
+    ++numEvents;
+
+    if (buffer.getDataSize() >= bufferSize)
+    {
+        stream->write(buffer.getData(), buffer.getDataSize());
+        buffer.reset();
+    }
+}
+
+juce::int64 TraceExporter::getProcessId()
+{
+   #if JUCE_WINDOWS
+    return (juce::int64)_getpid();
+   #else
+    return (juce::int64)getpid();
+   #endif
+}
+
+// ============================================================================
+
+TraceExporter::ScopedCallback::ScopedCallback(TraceExporter& exporter, const char* callbackName) :
+    owner(exporter),
+    name(callbackName)
+{
+    if (owner.isRunning() && owner.callbackDurations)
+        startMicroseconds = owner.now();
+}
+
+TraceExporter::ScopedCallback::~ScopedCallback()
+{
+    if (startMicroseconds < 0.0 || !owner.isRunning()) return;
+
+    const auto endMicroseconds = owner.now();
+    owner.beginEvent(name, "X", startMicroseconds);
+    owner.buffer << ",\"dur\":" << juce::String{ endMicroseconds - startMicroseconds, 3 };
+    owner.endEvent();
+}
+
+} // namespace vtdbg
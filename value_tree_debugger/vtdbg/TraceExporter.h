@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include <functional>
+
+namespace vtdbg
+{
+/* Streams tree changes, and optionally the debugger's own callback durations,
+   to a file in Chrome Trace Event JSON format, which Perfetto and chrome://tracing open.
+   Events are buffered in memory and appended to the file whenever the buffer fills.
+   They carry the id of the process and times from a clock other traces can share, so the
+   trace lines up with the app's own when both are opened together. */
+class TraceExporter
+{
+public:
+    ~TraceExporter();
+
+    /* Events are timed in microseconds by the clock, Time::getMillisecondCounterHiRes if there is
+       none. Pass the clock of the app's own tracing to share its time base. */
+    juce::Result start(const juce::File& file, bool includeCallbackDurations, std::function<double()> clockMicroseconds = {});
+    void stop();
+    bool isRunning() const { return stream != nullptr; }
+    juce::File getFile() const { return stream != nullptr ? stream->getFile() : juce::File{}; }
+    juce::int64 getNumEvents() const { return numEvents; }
+
+    /* Events are attributed to the mirror node id so nodes can be followed across the trace */
+    void propertyChanged(juce::uint32 nodeId, const juce::Identifier& type, const juce::Identifier& property, const juce::var& value);
+    void structureChanged(const char* name, juce::uint32 parentNodeId, const juce::Identifier& parentType, int index);
+
+    /* Times a debugger callback as a complete event */
+    class ScopedCallback
+    {
+    public:
+        ScopedCallback(TraceExporter& exporter, const char* callbackName);
+        ~ScopedCallback();
+
+    private:
+        TraceExporter& owner;
+        const char* name;
+        double startMicroseconds{ -1.0 };
+    };
+
+    /* Bytes kept in memory before they are written to the file */
+    size_t bufferSize{ 64 * 1024 };
+
+private:
+    double now() const;
+    void beginEvent(const char* name, const char* phase, double microseconds);
+    void endEvent();
+
+    static juce::int64 getProcessId();
+
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::MemoryOutputStream buffer;
+    std::function<double()> clock;
+    bool callbackDurations{ false };
+    juce::int64 numEvents{ 0 };
+};
+
+} // namespace vtdbg
@@ -0,0 +1,325 @@
+#include "TreeDiff.h"
+
+#include <limits>
+
+namespace vtdbg
+{
+/* A baseline read from XML has only strings and ints for bools, so values which read the same are equal */
+static bool valuesMatch(const juce::var& a, const juce::var& b)
+{
+    return a.equalsWithSameType(b) || (!a.isObject() && !b.isObject() && a.toString() == b.toString());
+}
+
+/* The number a string was written from, or the string, only when the number writes it back the same */
+static juce::var readNumber(const juce::var& value)
+{
+    const auto text = value.toString();
+    if (text.isEmpty()) return value;
+
+    if (text.containsOnly("-0123456789"))
+    {
+        const auto number = text.getLargeIntValue();
+        const auto fitsInt = number >= std::numeric_limits<int>::min() && number <= std::numeric_limits<int>::max();
+        const juce::var typed = fitsInt ? juce::var{ (int)number } : juce::var{ number };
+        return typed.toString() == text ? typed : value;
+    }
+
+    if (text.containsOnly("-+.0123456789eE"))
+    {
+        const juce::var typed{ text.getDoubleValue() };
+        return typed.toString() == text ? typed : value;
+    }
+
+    return value;
+}
+
+bool TreeDiff::Difference::operator==(const Difference& other) const
+{
+    return added == other.added
+        && contentChanged == other.contentChanged
+        && childrenRemoved == other.childrenRemoved
+        && descendantsDiffer == other.descendantsDiffer
+        && baselineNode == other.baselineNode
+        && properties == other.properties;
+}
+
+TreeDiff::TreeDiff(const FlatTreeModel& liveModel) :
+    live(liveModel)
+{
+}
+
+TreeDiff::~TreeDiff()
+{
+    cancelPendingUpdate();
+}
+
+void TreeDiff::setBaseline(const juce::ValueTree& baselineTree)
+{
+    baseline.rebuild(withTypedValues(baselineTree));
+    update();
+}
+
+juce::ValueTree TreeDiff::withTypedValues(const juce::ValueTree& tree)
+{
+    std::function<bool(const juce::ValueTree&)> hasOnlyStrings = [&](const juce::ValueTree& node)
+    {
+        for (int i = 0; i < node.getNumProperties(); ++i)
+            if (!node[node.getPropertyName(i)].isString())
+                return false;
+
+        for (const auto& child : node)
+            if (!hasOnlyStrings(child))
+                return false;
+
+        return true;
+    };
+
+    if (!tree.isValid() || !hasOnlyStrings(tree)) return tree;
+
+    std::function<void(juce::ValueTree&)> readNumbers = [&](juce::ValueTree& node)
+    {
+        for (int i = 0; i < node.getNumProperties(); ++i)
+        {
+            const auto name = node.getPropertyName(i);
+            node.setProperty(name, readNumber(node[name]), nullptr);
+        }
+
+        for (auto child : node)
+            readNumbers(child);
+    };
+
+    auto copy = tree.createCopy();
+    readNumbers(copy);
+    return copy;
+}
+
+void TreeDiff::clearBaseline()
+{
+    baseline.clear();
+    update();
+}
+
+void TreeDiff::liveChanged()
+{
+    if (hasBaseline())
+        triggerAsyncUpdate();
+}
+
+void TreeDiff::handleAsyncUpdate()
+{
+    update();
+}
+
+void TreeDiff::update()
+{
+    cancelPendingUpdate();
+
+    // A partly mirrored tree would differ everywhere, the comparison waits for the build
+    if (live.isBuilding()) return;
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    Differences newDifferences;
+    if (hasBaseline())
+        compare(newDifferences);
+
+    lastUpdateMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+    // Only the nodes whose highlighting changes need to be told
+    std::vector<FlatTreeModel::NodeId> changed;
+    for (const auto& [id, difference] : newDifferences)
+    {
+        const auto it = differences.find(id);
+        if (it == differences.end() || it->second != difference)
+            changed.push_back(id);
+    }
+
+    for (const auto& entry : differences)
+        if (newDifferences.find(entry.first) == newDifferences.end())
+            changed.push_back(entry.first);
+
+    differences = std::move(newDifferences);
+
+    if (!changed.empty() && onChanged)
+        onChanged(changed);
+}
+
+const TreeDiff::Difference* TreeDiff::find(FlatTreeModel::NodeId liveNode) const
+{
+    const auto it = differences.find(liveNode);
+    return it != differences.end() ? &it->second : nullptr;
+}
+
+const juce::var* TreeDiff::findBaselineValue(FlatTreeModel::NodeId liveNode, const juce::Identifier& property) const
+{
+    const auto* difference = find(liveNode);
+    if (difference == nullptr || difference->baselineNode == FlatTreeModel::none) return nullptr;
+
+    const auto base = difference->baselineNode;
+    for (int i = 0; i < baseline.getNumProperties(base); ++i)
+        if (baseline.getPropertyName(base, i) == property)
+            return &baseline.getPropertyValue(base, i);
+
+    return nullptr;
+}
+
+void TreeDiff::compare(Differences& result) const
+{
+    if (live.getRoot() == FlatTreeModel::none) return;
+
+    // Pairs of matched nodes with the index of their parent's entry, walked without recursion
+    struct Pending { int liveNode; int baseNode; int parent; };
+    struct Visited { int liveNode; int parent; Difference difference; };
+    std::vector<Pending> stack{ { live.getRoot(), baseline.getRoot(), -1 } };
+    std::vector<Visited> visited;
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<int> addedChildren;
+
+    while (!stack.empty())
+    {
+        const auto pending = stack.back();
+        stack.pop_back();
+
+        if (live.getSubtreeHash(pending.liveNode) == baseline.getSubtreeHash(pending.baseNode))
+            continue;
+
+        Difference difference;
+        difference.baselineNode = pending.baseNode;
+        compareContent(pending.liveNode, pending.baseNode, difference);
+
+        pairs.clear();
+        addedChildren.clear();
+        difference.childrenRemoved = matchChildren(pending.liveNode, pending.baseNode, pairs, addedChildren);
+
+        for (const auto& [liveChild, baseChild] : pairs)
+            stack.push_back({ liveChild, baseChild, (int)visited.size() });
+
+        for (auto child : addedChildren)
+        {
+            difference.descendantsDiffer = true;
+            markAdded(child, result);
+        }
+
+        visited.push_back({ pending.liveNode, pending.parent, std::move(difference) });
+    }
+
+    // Hashes also differ where only the types do, such as a bool against the 1 it was saved as,
+    // so whether a node differs is passed up from its descendants once they are all compared
+    for (auto it = visited.rbegin(); it != visited.rend(); ++it)
+    {
+        auto& difference = it->difference;
+        if (!difference.contentChanged && difference.childrenRemoved == 0 && !difference.descendantsDiffer)
+            continue;
+
+        if (it->parent >= 0)
+            visited[(size_t)it->parent].difference.descendantsDiffer = true;
+
+        result.emplace(live.getNodeId(it->liveNode), std::move(difference));
+    }
+}
+
+void TreeDiff::compareContent(int liveNode, int baseNode, Difference& difference) const
+{
+    if (live.getContentHash(liveNode) == baseline.getContentHash(baseNode)) return;
+
+    difference.contentChanged = live.getType(liveNode) != baseline.getType(baseNode);
+
+    // Property names come from different intern tables, so compare them as identifiers
+    const auto numLive = live.getNumProperties(liveNode);
+    const auto numBase = baseline.getNumProperties(baseNode);
+
+    for (int i = 0; i < numLive; ++i)
+    {
+        const auto& name = live.getPropertyName(liveNode, i);
+        bool matches{ false };
+
+        for (int j = 0; j < numBase; ++j)
+        {
+            if (baseline.getPropertyName(baseNode, j) == name)
+            {
+                matches = valuesMatch(live.getPropertyValue(liveNode, i), baseline.getPropertyValue(baseNode, j));
+                break;
+            }
+        }
+
+        if (!matches)
+            difference.properties.add(name);
+    }
+
+    for (int j = 0; j < numBase; ++j)
+    {
+        const auto& name = baseline.getPropertyName(baseNode, j);
+        bool found{ false };
+
+        for (int i = 0; i < numLive && !found; ++i)
+            found = live.getPropertyName(liveNode, i) == name;
+
+        if (!found)
+            difference.properties.add(name);
+    }
+
+    difference.contentChanged = difference.contentChanged || !difference.properties.isEmpty();
+}
+
+int TreeDiff::matchChildren(int liveNode, int baseNode, std::vector<std::pair<int, int>>& pairs, std::vector<int>& addedChildren) const
+{
+    // Baseline children by subtree hash, latest first so the earliest is taken from the back
+    std::unordered_map<juce::uint64, std::vector<int>> unmatchedByHash;
+    std::vector<int> baseChildren;
+    for (auto child = baseline.getFirstChild(baseNode); child != FlatTreeModel::none; child = baseline.getNextSibling(child))
+        baseChildren.push_back(child);
+
+    for (auto it = baseChildren.rbegin(); it != baseChildren.rend(); ++it)
+        unmatchedByHash[baseline.getSubtreeHash(*it)].push_back(*it);
+
+    // Equal subtrees match wherever they are
+    std::unordered_set<int> matchedBase;
+    std::vector<int> liveLeft;
+    for (auto child = live.getFirstChild(liveNode); child != FlatTreeModel::none; child = live.getNextSibling(child))
+    {
+        const auto it = unmatchedByHash.find(live.getSubtreeHash(child));
+        if (it == unmatchedByHash.end() || it->second.empty())
+        {
+            liveLeft.push_back(child);
+            continue;
+        }
+
+        matchedBase.insert(it->second.back());
+        it->second.pop_back();
+    }
+
+    // The rest match in order among children of the same type, and differ below
+    std::unordered_map<juce::Identifier, std::vector<int>, IdentifierHash> unmatchedByType;
+    for (auto it = baseChildren.rbegin(); it != baseChildren.rend(); ++it)
+        if (matchedBase.count(*it) == 0)
+            unmatchedByType[baseline.getType(*it)].push_back(*it);
+
+    int numUnmatched = (int)(baseChildren.size() - matchedBase.size());
+    for (auto child : liveLeft)
+    {
+        const auto it = unmatchedByType.find(live.getType(child));
+        if (it == unmatchedByType.end() || it->second.empty())
+        {
+            addedChildren.push_back(child);
+            continue;
+        }
+
+        pairs.emplace_back(child, it->second.back());
+        it->second.pop_back();
+        --numUnmatched;
+    }
+
+    return numUnmatched;
+}
+
+void TreeDiff::markAdded(int liveNode, Differences& result) const
+{
+    live.forEachInSubtree(liveNode, [&](int node)
+    {
+        Difference difference;
+        difference.added = true;
+        difference.descendantsDiffer = live.getNumChildren(node) > 0;
+        result.emplace(live.getNodeId(node), std::move(difference));
+    });
+}
+
+} // namespace vtdbg
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace vtdbg
+{
+/* Differences between the live tree and a baseline, such as a default preset.
+   Children are matched by subtree hash first, so a child inserted or removed doesn't make its
+   later siblings differ, then in order among children of the same type. Subtrees with equal
+   hashes are skipped without being visited, so redoing the comparison costs in proportion to
+   what differs. A baseline read from XML has only strings, its numbers are read back as numbers
+   by withTypedValues, and values which still differ in type are compared as text. */
+class TreeDiff : private juce::AsyncUpdater
+{
+public:
+    struct Difference
+    {
+        /* No baseline node was matched to this one */
+        bool added{ false };
+        /* The type or the properties differ */
+        bool contentChanged{ false };
+        /* Children of the baseline node matched to no live child */
+        int childrenRemoved{ 0 };
+        /* Something below this node differs */
+        bool descendantsDiffer{ false };
+        int baselineNode{ FlatTreeModel::none };
+        /* Properties whose values differ, or which are only in one of the two */
+        juce::Array<juce::Identifier> properties;
+
+        bool operator==(const Difference& other) const;
+        bool operator!=(const Difference& other) const { return !operator==(other); }
+    };
+
+    explicit TreeDiff(const FlatTreeModel& liveModel);
+    ~TreeDiff() override;
+
+    /* Kept with typed values, see withTypedValues */
+    void setBaseline(const juce::ValueTree& baselineTree);
+    void clearBaseline();
+    bool hasBaseline() const { return baseline.getRoot() != FlatTreeModel::none; }
+    const FlatTreeModel& getBaseline() const { return baseline; }
+
+    /* Call after every change to the live model, the comparison is redone once per message loop */
+    void liveChanged();
+    /* Compare now, unless the live model is still being built */
+    void update();
+
+    /* The difference at a live node, or nullptr where it matches the baseline */
+    const Difference* find(FlatTreeModel::NodeId liveNode) const;
+    /* The baseline value of a property of a differing live node, nullptr if the baseline node has no such property */
+    const juce::var* findBaselineValue(FlatTreeModel::NodeId liveNode, const juce::Identifier& property) const;
+    int getNumDifferences() const { return static_cast<int>(differences.size()); }
+    double getLastUpdateMs() const { return lastUpdateMs; }
+
+    /* For a tree whose values are all strings, as read from XML, a copy with the strings written
+       by ints, int64s and doubles turned back into them, so it hashes like the tree it was saved
+       from. Bools are written as 1 and 0 and come back as ints. Other trees are returned as they are. */
+    static juce::ValueTree withTypedValues(const juce::ValueTree& tree);
+
+    /* Called with the ids of live nodes whose differences changed */
+    std::function<void(const std::vector<FlatTreeModel::NodeId>&)> onChanged;
+
+private:
+    using Differences = std::unordered_map<FlatTreeModel::NodeId, Difference>;
+
+    void handleAsyncUpdate() override;
+    void compare(Differences& result) const;
+    void compareContent(int liveNode, int baseNode, Difference& difference) const;
+    void markAdded(int liveNode, Differences& result) const;
+    /* Pair the children of two differing nodes, returns the number of baseline children left unmatched */
+    int matchChildren(int liveNode, int baseNode, std::vector<std::pair<int, int>>& pairs, std::vector<int>& addedChildren) const;
+
+    const FlatTreeModel& live;
+    FlatTreeModel baseline;
+    Differences differences;
+    double lastUpdateMs{ 0.0 };
+};
+
+} // namespace vtdbg
@@ -0,0 +1,633 @@
+#include "TreeQuery.h"
+#include "ValueComparison.h"
+
+namespace vtdbg
+{
+/* Recursive descent parser emitting the steps of a TreeQuery */
+class TreeQueryParser
+{
+public:
+    TreeQueryParser(const juce::String& text, TreeQuery& queryToBuild) :
+        p(text.getCharPointer()),
+        query(queryToBuild)
+    {
+    }
+
+    juce::Result parse()
+    {
+        skipWhitespace();
+        if (p.isEmpty()) return fail("Empty query");
+
+        while (!p.isEmpty())
+        {
+            auto result = parseStep();
+            if (result.failed()) return result;
+
+            skipWhitespace();
+        }
+
+        return juce::Result::ok();
+    }
+
+private:
+    using Op = TreeQuery::Op;
+
+    juce::Result parseStep()
+    {
+        TreeQuery::Step step;
+
+        if (match("//"))
+            step.descendants = true;
+        else if (!match("/"))
+            return fail("Expected / or // before \"" + juce::String(p) + "\"");
+
+        if (!match("*"))
+        {
+            const auto name = readName();
+            if (name.isEmpty()) return fail(p.isEmpty() ? "Expected a type or * at the end" : "Expected a type or * before \"" + juce::String(p) + "\"");
+            if (!juce::Identifier::isValidIdentifier(name)) return fail("Invalid type " + name);
+
+            step.type = name;
+        }
+
+        program = &step.predicate;
+        depth = 0;
+        maxDepth = 0;
+
+        for (int numPredicates = 0; match("["); ++numPredicates)
+        {
+            auto result = parseOr();
+            if (result.failed()) return result;
+            if (!match("]")) return fail("Expected ]");
+
+            // Successive predicates must all be true
+            if (numPredicates > 0)
+                emit(Op::logicalAnd);
+        }
+
+        if (maxDepth > TreeQuery::maxStackDepth) return fail("Predicate is too complex");
+
+        step.requiredProperties = findRequiredProperties(step.predicate);
+        query.steps.push_back(std::move(step));
+        return juce::Result::ok();
+    }
+
+    juce::Result parseOr()
+    {
+        auto result = parseAnd();
+
+        while (result.wasOk() && matchWord("or"))
+        {
+            result = parseAnd();
+            emit(Op::logicalOr);
+        }
+
+        return result;
+    }
+
+    juce::Result parseAnd()
+    {
+        auto result = parseUnary();
+
+        while (result.wasOk() && matchWord("and"))
+        {
+            result = parseUnary();
+            emit(Op::logicalAnd);
+        }
+
+        return result;
+    }
+
+    juce::Result parseUnary()
+    {
+        if (matchWord("not"))
+        {
+            if (!match("(")) return fail("Expected ( after not");
+
+            auto result = parseOr();
+            if (result.failed()) return result;
+            if (!match(")")) return fail("Expected )");
+
+            emit(Op::logicalNot);
+            return juce::Result::ok();
+        }
+
+        if (match("("))
+        {
+            auto result = parseOr();
+            if (result.failed()) return result;
+            return match(")") ? juce::Result::ok() : fail("Expected )");
+        }
+
+        bool isProperty = false;
+        auto result = parseOperand(isProperty);
+        if (result.failed()) return result;
+
+        Op comparison;
+
+        if (match("==") || match("=")) comparison = Op::equal;
+        else if (match("!=")) comparison = Op::notEqual;
+        else if (match("<=")) comparison = Op::lessOrEqual;
+        else if (match(">=")) comparison = Op::greaterOrEqual;
+        else if (match("<")) comparison = Op::less;
+        else if (match(">")) comparison = Op::greater;
+        else
+        {
+            // A lone property tests that it exists
+            if (!isProperty) return fail("Expected a comparison");
+
+            program->back().op = Op::hasProperty;
+            return juce::Result::ok();
+        }
+
+        result = parseOperand(isProperty);
+        if (result.failed()) return result;
+
+        emit(comparison);
+        return juce::Result::ok();
+    }
+
+    juce::Result parseOperand(bool& isProperty)
+    {
+        skipWhitespace();
+        isProperty = false;
+
+        const auto c = *p;
+
+        if (c == '"' || c == '\'')
+        {
+            ++p;
+            juce::String text;
+            while (!p.isEmpty() && *p != c)
+                text += p.getAndAdvance();
+
+            if (p.isEmpty()) return fail("Unterminated string");
+            ++p;
+
+            emit(Op::pushConstant, addConstant(text));
+            return juce::Result::ok();
+        }
+
+        if (juce::CharacterFunctions::isDigit(c) || c == '-' || c == '.')
+        {
+            double number;
+            if (!ValueComparison::readNumber(p, number)) return fail("Invalid number");
+
+            emit(Op::pushConstant, addConstant(number));
+            return juce::Result::ok();
+        }
+
+        if (c == '@')
+        {
+            ++p;
+            const auto name = readName();
+            if (!juce::Identifier::isValidIdentifier(name)) return fail("Invalid property name \"" + name + "\"");
+
+            isProperty = true;
+            emit(Op::pushProperty, addIdentifier(name));
+            return juce::Result::ok();
+        }
+
+        const auto word = readName();
+        if (word == "true" || word == "false")
+        {
+            emit(Op::pushConstant, addConstant(word == "true"));
+            return juce::Result::ok();
+        }
+
+        if (word.isEmpty()) return fail(p.isEmpty() ? "Unexpected end of query" : "Unexpected \"" + juce::String(p) + "\"");
+        return fail("Unexpected \"" + word + "\", property names start with @");
+    }
+
+    /* Properties which must exist for the program to be true, found by running it on sets of properties */
+    static std::vector<int> findRequiredProperties(const std::vector<TreeQuery::Instruction>& predicate)
+    {
+        std::vector<std::vector<int>> stack;
+
+        for (const auto& instruction : predicate)
+        {
+            switch (instruction.op)
+            {
+            case Op::pushProperty:
+            case Op::hasProperty:
+                stack.push_back({ instruction.operand });
+                break;
+
+            case Op::pushConstant:
+                stack.emplace_back();
+                break;
+
+            case Op::logicalNot:
+                stack.back().clear();
+                break;
+
+            case Op::logicalOr:
+            {
+                // Only what both sides require
+                auto b = std::move(stack.back());
+                stack.pop_back();
+                auto& a = stack.back();
+                a.erase(std::remove_if(a.begin(), a.end(), [&](int id) { return std::find(b.begin(), b.end(), id) == b.end(); }), a.end());
+                break;
+            }
+
+            default:
+            {
+                // And, and comparisons, which are false for a missing property
+                auto b = std::move(stack.back());
+                stack.pop_back();
+                auto& a = stack.back();
+                for (auto id : b)
+                    if (std::find(a.begin(), a.end(), id) == a.end())
+                        a.push_back(id);
+                break;
+            }
+            }
+        }
+
+        return stack.empty() ? std::vector<int>{} : stack.back();
+    }
+
+    juce::String readName()
+    {
+        skipWhitespace();
+        juce::String name;
+        while (juce::CharacterFunctions::isLetterOrDigit(*p) || *p == '_' || *p == '-' || *p == ':' || *p == '#' || *p == '$' || *p == '%')
+            name += p.getAndAdvance();
+
+        return name;
+    }
+
+    bool matchWord(const char* word)
+    {
+        const auto start = p;
+        if (readName() == word) return true;
+
+        p = start;
+        return false;
+    }
+
+    bool match(const char* token)
+    {
+        skipWhitespace();
+        auto start = p;
+
+        for (auto* t = token; *t != 0; ++t, ++p)
+        {
+            if (*p != (juce::juce_wchar)*t)
+            {
+                p = start;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void skipWhitespace()
+    {
+        p = p.findEndOfWhitespace();
+    }
+
+    void emit(Op op, int operand = 0)
+    {
+        switch (op)
+        {
+        case Op::pushProperty:
+        case Op::hasProperty:
+        case Op::pushConstant:
+            maxDepth = juce::jmax(maxDepth, ++depth);
+            break;
+
+        case Op::logicalNot:
+            break;
+
+        default:
+            --depth;
+            break;
+        }
+
+        program->push_back({ op, operand });
+    }
+
+    int addConstant(const juce::var& value)
+    {
+        query.constants.push_back(value);
+        return static_cast<int>(query.constants.size()) - 1;
+    }
+
+    int addIdentifier(const juce::Identifier& id)
+    {
+        const auto it = std::find(query.identifiers.begin(), query.identifiers.end(), id);
+        if (it != query.identifiers.end())
+            return static_cast<int>(std::distance(query.identifiers.begin(), it));
+
+        query.identifiers.push_back(id);
+        return static_cast<int>(query.identifiers.size()) - 1;
+    }
+
+    juce::Result fail(const juce::String& message) const
+    {
+        return juce::Result::fail(message);
+    }
+
+    juce::String::CharPointerType p;
+    TreeQuery& query;
+    std::vector<TreeQuery::Instruction>* program{ nullptr };
+
+    int depth{ 0 };
+    int maxDepth{ 0 };
+};
+
+// ============================================================================
+
+TreeQuery TreeQuery::compile(const juce::String& text, juce::Result& result)
+{
+    TreeQuery query;
+    result = TreeQueryParser{ text, query }.parse();
+
+    if (result.failed())
+        return {};
+
+    return query;
+}
+
+TreeQuery::Matches TreeQuery::evaluate(const FlatTreeModel& model) const
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    Matches matches;
+
+    // The query's names as indices into the model, none for names no node has ever used
+    std::vector<int> modelIdentifiers;
+    for (const auto& id : identifiers)
+        modelIdentifiers.push_back(model.findIdentifier(id));
+
+    std::vector<int> context;
+    std::vector<char> marks;
+    bool aboveRoot = true;
+
+    const auto markContext = [&]()
+    {
+        marks.assign((size_t)model.getCapacity(), 0);
+        for (auto node : context)
+            marks[(size_t)node] = 1;
+    };
+
+    for (const auto& step : steps)
+    {
+        std::vector<int> next;
+
+        const auto type = step.type.isNull() ? FlatTreeModel::none : model.findIdentifier(step.type);
+        const auto matchesStep = [&](int node)
+        {
+            ++matches.nodesTested;
+            return (step.type.isNull() || model.getTypeIndex(node) == type) && test(step, model, node, modelIdentifiers);
+        };
+
+        // Start from the shortest index list which every match must be in
+        const std::vector<int>* candidates = nullptr;
+        bool impossible = !step.type.isNull() && type == FlatTreeModel::none;
+
+        if (type != FlatTreeModel::none)
+            candidates = &model.getNodesOfType(type);
+
+        for (auto property : step.requiredProperties)
+        {
+            const auto id = modelIdentifiers[(size_t)property];
+            if (id == FlatTreeModel::none)
+            {
+                impossible = true;
+                break;
+            }
+
+            const auto& nodes = model.getNodesWithProperty(id);
+            if (candidates == nullptr || nodes.size() < candidates->size())
+                candidates = &nodes;
+        }
+
+        if (impossible || model.getRoot() == FlatTreeModel::none)
+        {
+            context.clear();
+            break;
+        }
+
+        if (aboveRoot && !step.descendants)
+        {
+            if (matchesStep(model.getRoot()))
+                next.push_back(model.getRoot());
+        }
+        else if (aboveRoot)
+        {
+            // Every node is a descendant
+            if (candidates != nullptr)
+            {
+                ++matches.indexedSteps;
+                for (auto node : *candidates)
+                    if (matchesStep(node))
+                        next.push_back(node);
+            }
+            else
+            {
+                model.forEachInSubtree(model.getRoot(), [&](int node)
+                {
+                    if (matchesStep(node))
+                        next.push_back(node);
+                });
+            }
+        }
+        else if (step.descendants)
+        {
+            markContext();
+
+            if (candidates != nullptr)
+            {
+                // Keep the candidates below a context node, O(depth) each
+                ++matches.indexedSteps;
+                for (auto node : *candidates)
+                {
+                    for (auto ancestor = model.getParent(node); ancestor != FlatTreeModel::none; ancestor = model.getParent(ancestor))
+                    {
+                        if (marks[(size_t)ancestor] != 0)
+                        {
+                            if (matchesStep(node))
+                                next.push_back(node);
+                            break;
+                        }
+                    }
+                }
+            }
+            else
+            {
+                for (auto start : context)
+                {
+                    // Nested context nodes are walked as part of the outer one
+                    bool nested = false;
+                    for (auto ancestor = model.getParent(start); ancestor != FlatTreeModel::none && !nested; ancestor = model.getParent(ancestor))
+                        nested = marks[(size_t)ancestor] != 0;
+
+                    if (nested) continue;
+
+                    model.forEachInSubtree(start, [&](int node)
+                    {
+                        if (node != start && matchesStep(node))
+                            next.push_back(node);
+                    });
+                }
+            }
+        }
+        else
+        {
+            size_t numChildren{ 0 };
+            for (auto node : context)
+                numChildren += (size_t)model.getNumChildren(node);
+
+            if (candidates != nullptr && candidates->size() < numChildren)
+            {
+                // Fewer candidates than children to scan, keep those whose parent is a context node
+                ++matches.indexedSteps;
+                markContext();
+                for (auto node : *candidates)
+                {
+                    const auto parent = model.getParent(node);
+                    if (parent != FlatTreeModel::none && marks[(size_t)parent] != 0 && matchesStep(node))
+                        next.push_back(node);
+                }
+            }
+            else
+            {
+                for (auto node : context)
+                    for (auto child = model.getFirstChild(node); child != FlatTreeModel::none; child = model.getNextSibling(child))
+                        if (matchesStep(child))
+                            next.push_back(child);
+            }
+        }
+
+        context = std::move(next);
+        aboveRoot = false;
+
+        if (context.empty()) break;
+    }
+
+    sortInTreeOrder(model, context);
+    matches.nodes = std::move(context);
+    matches.evaluationMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+    return matches;
+}
+
+bool TreeQuery::test(const Step& step, const FlatTreeModel& model, int node, const std::vector<int>& modelIdentifiers) const
+{
+    if (step.predicate.empty()) return true;
+
+    static const juce::var trueValue{ true };
+    static const juce::var falseValue{ false };
+
+    // Values are pointed to rather than copied, a missing property is nullptr
+    const juce::var* stack[maxStackDepth];
+    int top = 0;
+
+    const auto findProperty = [&](int operand) -> const juce::var*
+    {
+        const auto nameIndex = modelIdentifiers[(size_t)operand];
+        for (int i = 0; i < model.getNumProperties(node); ++i)
+            if (model.getPropertyNameIndex(node, i) == nameIndex)
+                return &model.getPropertyValue(node, i);
+
+        return nullptr;
+    };
+
+    const auto isTrue = [](const juce::var* value) { return value != nullptr && static_cast<bool>(*value); };
+    const auto fromBool = [&](bool b) { return b ? &trueValue : &falseValue; };
+
+    for (const auto& instruction : step.predicate)
+    {
+        switch (instruction.op)
+        {
+        case Op::pushProperty:
+            stack[top++] = findProperty(instruction.operand);
+            break;
+
+        case Op::hasProperty:
+            stack[top++] = fromBool(findProperty(instruction.operand) != nullptr);
+            break;
+
+        case Op::pushConstant:
+            stack[top++] = &constants[(size_t)instruction.operand];
+            break;
+
+        case Op::logicalNot:
+            stack[top - 1] = fromBool(!isTrue(stack[top - 1]));
+            break;
+
+        case Op::logicalAnd:
+            --top;
+            stack[top - 1] = fromBool(isTrue(stack[top - 1]) && isTrue(stack[top]));
+            break;
+
+        case Op::logicalOr:
+            --top;
+            stack[top - 1] = fromBool(isTrue(stack[top - 1]) || isTrue(stack[top]));
+            break;
+
+        case Op::equal:
+        case Op::notEqual:
+        case Op::less:
+        case Op::lessOrEqual:
+        case Op::greater:
+        case Op::greaterOrEqual:
+        {
+            --top;
+            const auto* a = stack[top - 1];
+            const auto* b = stack[top];
+
+            if (a == nullptr || b == nullptr)
+            {
+                stack[top - 1] = &falseValue;
+                break;
+            }
+
+            const auto comparison = ValueComparison::compare(*a, *b);
+            bool result = false;
+
+            switch (instruction.op)
+            {
+            case Op::equal:          result = comparison == 0; break;
+            case Op::notEqual:       result = comparison != 0; break;
+            case Op::less:           result = comparison < 0; break;
+            case Op::lessOrEqual:    result = comparison <= 0; break;
+            case Op::greater:        result = comparison > 0; break;
+            case Op::greaterOrEqual: result = comparison >= 0; break;
+            default: break;
+            }
+
+            stack[top - 1] = fromBool(result);
+            break;
+        }
+        }
+    }
+
+    jassert(top == 1);
+    return isTrue(stack[0]);
+}
+
+void TreeQuery::sortInTreeOrder(const FlatTreeModel& model, std::vector<int>& nodes)
+{
+    // Sort by the positions on the path from the root, O(depth) per node to collect
+    std::vector<std::pair<std::vector<int>, int>> keyed;
+    keyed.reserve(nodes.size());
+
+    for (auto node : nodes)
+    {
+        std::vector<int> path((size_t)model.getDepth(node) + 1);
+        for (auto n = node; n != FlatTreeModel::none; n = model.getParent(n))
+            path[(size_t)model.getDepth(n)] = model.getPosition(n);
+
+        keyed.emplace_back(std::move(path), node);
+    }
+
+    std::sort(keyed.begin(), keyed.end());
+
+    for (size_t i = 0; i < keyed.size(); ++i)
+        nodes[i] = keyed[i].second;
+}
+
+} // namespace vtdbg
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <vector>
+
+namespace vtdbg
+{
+/* A path query compiled once into a plan of steps, evaluated against a FlatTreeModel.
+   Grammar:
+       query      := step+
+       step       := ( "/" | "//" ) test predicate*
+       test       := type | "*"
+       predicate  := "[" or "]"
+       or         := and ( "or" and )*
+       and        := unary ( "and" unary )*
+       unary      := "not" "(" or ")" | "(" or ")" | operand ( op operand )?
+       operand    := "@" name | number | "string" | true | false
+       op         := = != < <= > >=
+   "/" steps to children and "//" to descendants, both start above the root, so "/Session" matches
+   a root of type Session. "@name" alone tests that the property exists, a comparison with a
+   missing property is false. Values compare as ValueComparison::compare does, so [@volume > 9]
+   matches a volume of "10" read from XML. Example: /Session/Track[@muted=true]/Plugin[@type="EQ"]//Band */
+class TreeQuery
+{
+public:
+    static TreeQuery compile(const juce::String& text, juce::Result& result);
+
+    struct Matches
+    {
+        /* Matching nodes in tree order */
+        std::vector<int> nodes;
+        double evaluationMs{ 0.0 };
+        /* Nodes whose type and predicates were tested */
+        juce::int64 nodesTested{ 0 };
+        /* Steps which started from a type or property index rather than a walk */
+        int indexedSteps{ 0 };
+    };
+
+    Matches evaluate(const FlatTreeModel& model) const;
+    bool isEmpty() const { return steps.empty(); }
+
+    enum class Op : juce::uint8
+    {
+        pushProperty,
+        hasProperty,
+        pushConstant,
+        equal,
+        notEqual,
+        less,
+        lessOrEqual,
+        greater,
+        greaterOrEqual,
+        logicalAnd,
+        logicalOr,
+        logicalNot,
+    };
+
+    struct Instruction
+    {
+        Op op;
+        int operand;
+    };
+
+    static constexpr int maxStackDepth{ 16 };
+
+private:
+    friend class TreeQueryParser;
+
+    struct Step
+    {
+        bool descendants{ false };
+        /* Null for any type */
+        juce::Identifier type;
+        /* The predicates of the step and-ed into one postfix program, empty if there are none */
+        std::vector<Instruction> predicate;
+        /* Properties every match must have, as indices into identifiers. Their index lists are
+           candidates for where the step starts. */
+        std::vector<int> requiredProperties;
+    };
+
+    bool test(const Step& step, const FlatTreeModel& model, int node, const std::vector<int>& modelIdentifiers) const;
+    static void sortInTreeOrder(const FlatTreeModel& model, std::vector<int>& nodes);
+
+    std::vector<Step> steps;
+    std::vector<juce::Identifier> identifiers;
+    std::vector<juce::var> constants;
+};
+
+} // namespace vtdbg
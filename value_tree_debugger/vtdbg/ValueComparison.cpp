@@ -0,0 +1,71 @@
+#include "ValueComparison.h"
+
+namespace vtdbg
+{
+namespace ValueComparison
+{
+static bool isNumeric(const juce::var& v)
+{
+    return v.isInt() || v.isInt64() || v.isDouble() || v.isBool();
+}
+
+/* The value as a number, if it is one or is a string holding one */
+static bool toNumber(const juce::var& v, double& number)
+{
+    if (isNumeric(v))
+    {
+        number = static_cast<double>(v);
+        return true;
+    }
+
+    return v.isString() && parseNumber(v.toString(), number);
+}
+
+int compare(const juce::var& a, const juce::var& b)
+{
+    if (isNumeric(a) || isNumeric(b))
+    {
+        double da, db;
+        if (toNumber(a, da) && toNumber(b, db))
+            return da < db ? -1 : (db < da ? 1 : 0);
+    }
+
+    return a.toString().compare(b.toString());
+}
+
+bool readNumber(juce::String::CharPointerType& p, double& number)
+{
+    const auto start = p;
+    bool hasDigits{ false };
+
+    if (*p == '-') ++p;
+
+    while (juce::CharacterFunctions::isDigit(*p) || *p == '.' || *p == 'e' || *p == 'E')
+    {
+        const auto isExponent = *p == 'e' || *p == 'E';
+        hasDigits = hasDigits || juce::CharacterFunctions::isDigit(*p);
+        ++p;
+
+        // The sign of an exponent, as in 1e-3
+        if (isExponent && (*p == '-' || *p == '+'))
+            ++p;
+    }
+
+    if (!hasDigits)
+    {
+        p = start;
+        return false;
+    }
+
+    number = juce::String{ start, p }.getDoubleValue();
+    return true;
+}
+
+bool parseNumber(const juce::String& text, double& number)
+{
+    auto p = text.getCharPointer();
+    return readNumber(p, number) && p.isEmpty();
+}
+} // namespace ValueComparison
+
+} // namespace vtdbg
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace vtdbg
+{
+/* How the conditions of watchpoints and the predicates of queries read and compare values */
+namespace ValueComparison
+{
+/* Numbers and bools compare as numbers. So does a string holding a number when the other side is
+   a number, as every value of a tree read from XML is a string. Anything else compares as strings. */
+int compare(const juce::var& a, const juce::var& b);
+
+/* Read a number such as 3, -2.5, .5 or 1e-3 at p, advancing p past it. Returns false, leaving p
+   where it was, if there is none. */
+bool readNumber(juce::String::CharPointerType& p, double& number);
+
+/* Whether the whole text is a number, as readNumber reads it */
+bool parseNumber(const juce::String& text, double& number);
+} // namespace ValueComparison
+
+} // namespace vtdbg
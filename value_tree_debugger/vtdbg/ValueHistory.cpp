@@ -0,0 +1,169 @@
+#include "ValueHistory.h"
+
+namespace vtdbg
+{
+ValueHistory::Buffer::Buffer(int capacity)
+{
+    // Whole blocks only, so no block straddles the end of the ring
+    const auto numBlocks = juce::jmax(1, (capacity + blockSize - 1) / blockSize);
+    samples.resize((size_t)(numBlocks * blockSize));
+    blockMins.resize((size_t)numBlocks);
+    blockMaxs.resize((size_t)numBlocks);
+}
+
+void ValueHistory::Buffer::push(float sample)
+{
+    const auto block = (size_t)(writePos / blockSize);
+
+    if (writePos % blockSize == 0)
+    {
+        blockMins[block] = sample;
+        blockMaxs[block] = sample;
+    }
+    else
+    {
+        blockMins[block] = juce::jmin(blockMins[block], sample);
+        blockMaxs[block] = juce::jmax(blockMaxs[block], sample);
+    }
+
+    samples[(size_t)writePos] = sample;
+    writePos = (writePos + 1) % getCapacity();
+    numSamples = juce::jmin(numSamples + 1, getCapacity());
+}
+
+float ValueHistory::Buffer::getLatest() const
+{
+    if (numSamples == 0) return 0.f;
+    return samples[(size_t)((writePos + getCapacity() - 1) % getCapacity())];
+}
+
+juce::Range<float> ValueHistory::Buffer::getRange(int start, int end) const
+{
+    start = juce::jlimit(0, numSamples, start);
+    end = juce::jlimit(start, numSamples, end);
+    if (start == end) return {};
+
+    // Chronological index 0 is the oldest sample
+    const auto oldest = numSamples < getCapacity() ? 0 : writePos;
+    const auto physicalStart = (oldest + start) % getCapacity();
+    const auto physicalEnd = physicalStart + (end - start);
+
+    if (physicalEnd <= getCapacity())
+        return getPhysicalRange(physicalStart, physicalEnd);
+
+    return getPhysicalRange(physicalStart, getCapacity()).getUnionWith(getPhysicalRange(0, physicalEnd - getCapacity()));
+}
+
+void ValueHistory::Buffer::decimate(int numColumns, float* mins, float* maxs) const
+{
+    for (int column = 0; column < numColumns; ++column)
+    {
+        const auto start = (int)((juce::int64)numSamples * column / numColumns);
+        const auto end = juce::jmax(start + 1, (int)((juce::int64)numSamples * (column + 1) / numColumns));
+        const auto range = getRange(start, end);
+        mins[column] = range.getStart();
+        maxs[column] = range.getEnd();
+    }
+}
+
+juce::Range<float> ValueHistory::Buffer::getPhysicalRange(int start, int end) const
+{
+    // The block being written holds samples from two laps of the ring, so its summary can't be used
+    const auto headBlock = writePos / blockSize;
+    const auto firstWholeBlock = (start + blockSize - 1) / blockSize;
+    const auto endWholeBlock = end / blockSize;
+
+    if (firstWholeBlock >= endWholeBlock)
+        return scan(samples.data() + start, end - start);
+
+    auto range = scan(samples.data() + start, firstWholeBlock * blockSize - start);
+    bool hasRange = firstWholeBlock * blockSize > start;
+
+    for (int block = firstWholeBlock; block < endWholeBlock; ++block)
+    {
+        const auto blockRange = block == headBlock
+            ? scan(samples.data() + block * blockSize, blockSize)
+            : juce::Range<float>{ blockMins[(size_t)block], blockMaxs[(size_t)block] };
+
+        range = hasRange ? range.getUnionWith(blockRange) : blockRange;
+        hasRange = true;
+    }
+
+    if (end > endWholeBlock * blockSize)
+        range = range.getUnionWith(scan(samples.data() + endWholeBlock * blockSize, end - endWholeBlock * blockSize));
+
+    return range;
+}
+
+juce::Range<float> ValueHistory::Buffer::scan(const float* data, int num)
+{
+    if (num <= 0) return {};
+
+    // Branch free so the compiler can vectorise it
+    auto low = data[0];
+    auto high = data[0];
+    for (int i = 1; i < num; ++i)
+    {
+        low = data[i] < low ? data[i] : low;
+        high = data[i] > high ? data[i] : high;
+    }
+
+    return { low, high };
+}
+
+// ============================================================================
+
+void ValueHistory::watch(FlatTreeModel::NodeId node, const juce::Identifier& property)
+{
+    auto& buffer = buffers[{ node, property }];
+    if (buffer == nullptr)
+        buffer = std::make_unique<Buffer>(capacity);
+}
+
+void ValueHistory::unwatch(FlatTreeModel::NodeId node, const juce::Identifier& property)
+{
+    buffers.erase({ node, property });
+}
+
+const ValueHistory::Buffer* ValueHistory::find(FlatTreeModel::NodeId node, const juce::Identifier& property) const
+{
+    if (buffers.empty()) return nullptr;
+
+    const auto it = buffers.find({ node, property });
+    return it != buffers.end() ? it->second.get() : nullptr;
+}
+
+void ValueHistory::propertyChanged(FlatTreeModel::NodeId node, const juce::Identifier& property, const juce::var& value)
+{
+    if (buffers.empty()) return;
+
+    const auto it = buffers.find({ node, property });
+    if (it == buffers.end()) return;
+
+    if (value.isInt() || value.isInt64() || value.isDouble() || value.isBool())
+        it->second->push(static_cast<float>(static_cast<double>(value)));
+}
+
+void ValueHistory::subtreeRemoved(const FlatTreeModel& model, int node, juce::Array<FlatTreeModel::NodeId>& freedNodes)
+{
+    for (auto it = buffers.begin(); it != buffers.end();)
+    {
+        // A node the model no longer has can't be watched either
+        const auto watched = model.findNode(it->first.node);
+        auto ancestor = watched;
+        while (ancestor != FlatTreeModel::none && ancestor != node)
+            ancestor = model.getParent(ancestor);
+
+        if (watched == FlatTreeModel::none || ancestor == node)
+        {
+            freedNodes.addIfNotAlreadyThere(it->first.node);
+            it = buffers.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+} // namespace vtdbg
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace vtdbg
+{
+/* Recent values of watched numeric properties, in fixed size ring buffers which are
+   only allocated for the properties being watched */
+class ValueHistory
+{
+public:
+    /* Ring buffer of samples, with the min and max of every block kept up to date on
+       each push, so decimating any number of samples costs O(blocks + columns) */
+    class Buffer
+    {
+    public:
+        explicit Buffer(int capacity);
+
+        void push(float sample);
+        int size() const { return numSamples; }
+        int getCapacity() const { return static_cast<int>(samples.size()); }
+
+        /* Min and max of the chronological samples [start, end), 0 being the oldest */
+        juce::Range<float> getRange(int start, int end) const;
+        /* Min and max of the most recent samples, spread over numColumns columns */
+        void decimate(int numColumns, float* mins, float* maxs) const;
+        float getLatest() const;
+
+        static constexpr int blockSize{ 64 };
+
+    private:
+        juce::Range<float> getPhysicalRange(int start, int end) const;
+        static juce::Range<float> scan(const float* data, int num);
+
+        std::vector<float> samples;
+        std::vector<float> blockMins;
+        std::vector<float> blockMaxs;
+        int writePos{ 0 };
+        int numSamples{ 0 };
+    };
+
+    void watch(FlatTreeModel::NodeId node, const juce::Identifier& property);
+    void unwatch(FlatTreeModel::NodeId node, const juce::Identifier& property);
+    bool isWatched(FlatTreeModel::NodeId node, const juce::Identifier& property) const { return find(node, property) != nullptr; }
+    const Buffer* find(FlatTreeModel::NodeId node, const juce::Identifier& property) const;
+    bool isEmpty() const { return buffers.empty(); }
+
+    /* Change path, costs one hash lookup when nothing is watched on the node */
+    void propertyChanged(FlatTreeModel::NodeId node, const juce::Identifier& property, const juce::var& value);
+    /* Call before the model removes a node, to free the buffers of it and its descendants, adding
+       the nodes whose buffers were freed to freedNodes. Walks up from the watched nodes, not down
+       the removed subtree. */
+    void subtreeRemoved(const FlatTreeModel& model, int node, juce::Array<FlatTreeModel::NodeId>& freedNodes);
+
+    /* Samples kept for properties watched from now on, 4 bytes each */
+    void setCapacity(int numSamples) { capacity = juce::jmax(Buffer::blockSize, numSamples); }
+    int getCapacity() const { return capacity; }
+
+    static constexpr int defaultCapacity{ 131072 };
+
+private:
+    struct Key
+    {
+        FlatTreeModel::NodeId node;
+        juce::Identifier property;
+
+        bool operator==(const Key& other) const { return node == other.node && property == other.property; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const noexcept
+        {
+            return std::hash<FlatTreeModel::NodeId>{}(key.node) * 31u + IdentifierHash{}(key.property);
+        }
+    };
+
+    std::unordered_map<Key, std::unique_ptr<Buffer>, KeyHash> buffers;
+    int capacity{ defaultCapacity };
+};
+
+} // namespace vtdbg
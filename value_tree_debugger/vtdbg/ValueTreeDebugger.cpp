@@ -11,6 +11,14 @@ constexpr float toolbarHeightF{ 30.f };
 constexpr int toolbarWidth{ 130 };
 constexpr float toolbarWidthF{ 130.f };
 constexpr int buttonWidth{ 20 };
+constexpr int propertyBlockThreshold{ 32 };
+constexpr int propertyPageSize{ 50 };
+constexpr int scrubPixelsPerStep{ 4 };
+constexpr int maxSparklineColumns{ 256 };
+constexpr double stepGestureMs{ 500.0 };
+/* The model's share of each build tick, creating the items for its nodes takes about as long again */
+constexpr double buildSliceMs{ 1.0 };
+constexpr int buildIntervalMs{ 4 };
 
 static juce::Font theFontLarge() { return juce::FontOptions{}.withPointHeight(20.f); }
 static juce::Font theFontSmall() { return juce::FontOptions{}.withPointHeight(11.f); }
@@ -28,6 +36,8 @@ const juce::Colour selectedBgColour{ juce::Colour::fromHSL(240.f / 256.f, 0.05f,
 const juce::Colour selectedBgColourProp{ selectedBgColour.brighter(0.2f) };
 const juce::Colour hoverBgColour{ selectedBgColour.brighter(0.2f) };
 const juce::Colour hoverBgColourProp{ selectedBgColourProp.brighter(0.2f) };
+const juce::Colour addedColour{ juce::Colour::fromHSL(100.f / 256.f, 0.45f, 0.45f, 1.f) };
+const juce::Colour changedColour{ juce::Colour::fromHSL(30.f / 256.f, 0.60f, 0.50f, 1.f) };
 
 const juce::var dragAndDropId{ "ValueTreeDebugger_dragndrop_id" };
 
@@ -46,36 +56,38 @@ static bool getBoolValue(const juce::String& string)
     return false;
 }
 
-static juce::String getTypeOfVar(const juce::var theVar)
+static const juce::String& getTypeOfVar(const juce::var& theVar)
 {
-    if (theVar.isVoid()) return "Void";
-    if (theVar.isUndefined()) return "Undefined";
-    if (theVar.isInt()) return "Int";
-    if (theVar.isInt64()) return "Int64";
-    if (theVar.isBool()) return "Bool";
-    if (theVar.isDouble()) return "Double";
-    if (theVar.isString()) return "String";
-    if (theVar.isObject()) return "Object";
-    if (theVar.isArray()) return "Array";
-    if (theVar.isBinaryData()) return "BinaryData";
-    if (theVar.isMethod()) return "Method";
+    // Made once, as every row bound from the pool sets its type label from here
+    static const juce::String names[]{ "Void", "Undefined", "Int", "Int64", "Bool", "Double", "String",
+                                       "Object", "Array", "BinaryData", "Method", "Error" };
+
+    if (theVar.isVoid()) return names[0];
+    if (theVar.isUndefined()) return names[1];
+    if (theVar.isInt()) return names[2];
+    if (theVar.isInt64()) return names[3];
+    if (theVar.isBool()) return names[4];
+    if (theVar.isDouble()) return names[5];
+    if (theVar.isString()) return names[6];
+    if (theVar.isObject()) return names[7];
+    if (theVar.isArray()) return names[8];
+    if (theVar.isBinaryData()) return names[9];
+    if (theVar.isMethod()) return names[10];
 
     jassertfalse;
-    return "Error";
+    return names[11];
 }
 
 static void moveItems(
-    TreeView& treeView,
     const OwnedArray<ValueTree>& items,
     ValueTree newParent,
     int insertIndex,
     UndoManager* undoManager
 )
 {
+    // Openness is kept by node id, which a moved subtree keeps
     if (items.size() > 0)
     {
-        std::unique_ptr<XmlElement> oldOpenness(treeView.getOpennessState(false));
-
         for (auto* v : items)
         {
             if (v->getParent().isValid() && newParent != *v && !newParent.isAChildOf(*v))
@@ -87,9 +99,6 @@ static void moveItems(
                 newParent.addChild(*v, insertIndex, undoManager);
             }
         }
-
-        if (oldOpenness != nullptr)
-            treeView.restoreOpennessState(*oldOpenness, false);
     }
 }
 
@@ -122,8 +131,38 @@ namespace ButtonText
 {
 const String addProp{ "Set property" };
 const String delProp{ "Delete property" };
+const String renameProp{ "Rename property" };
 const String addNode{ "Add child" };
 const String delNode{ "Delete node" };
+const String copy{ "Copy" };
+const String paste{ "Paste" };
+const String addWatch{ "Add watch" };
+const String clearWatches{ "Clear watches" };
+const String freeze{ "Freeze" };
+const String unfreeze{ "Unfreeze" };
+const String adaptiveSampling{ "Sample when fast" };
+const String startTrace{ "Record trace" };
+const String stopTrace{ "Stop trace" };
+const String startRecording{ "Record changes" };
+const String stopRecording{ "Stop recording" };
+const String exportSession{ "Export session stats" };
+const String timeTravel{ "Time travel" };
+const String excludeSubtree{ "Exclude subtree" };
+const String excludeType{ "Exclude type" };
+const String excludeProperty{ "Exclude property" };
+const String clearExclusions{ "Clear exclusions" };
+const String loadReplay{ "Load replay" };
+const String play{ "Play" };
+const String pause{ "Pause" };
+const String step{ "Step" };
+const String startStress{ "Start stress" };
+const String stopStress{ "Stop stress" };
+const String trackHistory{ "Track history" };
+const String showStats{ "Subtree stats" };
+const String hideStats{ "Hide stats" };
+const String loadBaseline{ "Load baseline" };
+const String clearBaseline{ "Clear baseline" };
+const String find{ "Find" };
 const String undo{ juce::CharPointer_UTF8("\xe2\xa4\xba") };
 const String redo{ juce::CharPointer_UTF8("\xe2\xa4\xbb") };
 }
@@ -332,12 +371,38 @@ MiniToolbar::MiniToolbar()
 {
     butAddProp.setButtonText(ButtonText::addProp);
     butDelProp.setButtonText(ButtonText::delProp);
+    butDelProp.setTooltip("Delete the selected property from every selected node");
+    butRenameProp.setButtonText(ButtonText::renameProp);
+    butRenameProp.setTooltip("Rename the selected property of every selected node to the ID entered above");
     butAddNode.setButtonText(ButtonText::addNode);
     butDelNode.setButtonText(ButtonText::delNode);
+    butCopy.setButtonText(ButtonText::copy);
+    butCopy.setTooltip("Copy the selected subtrees");
+    butPaste.setButtonText(ButtonText::paste);
+    butPaste.setTooltip("Add the copied subtrees to the selected node");
+    butCopy.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnBottom);
+    butPaste.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnTop);
+    butTrackHistory.setButtonText(ButtonText::trackHistory);
+    butTrackHistory.setTooltip("Show recent values of the selected property, click again to stop");
+    butStats.setButtonText(ButtonText::showStats);
+    butStats.setTooltip("Statistics of the selected subtree, or the whole tree");
+    butLoadBaseline.setButtonText(ButtonText::loadBaseline);
+    butLoadBaseline.setTooltip("Highlight differences from a tree saved as XML or binary");
+    butClearBaseline.setButtonText(ButtonText::clearBaseline);
+    butLoadBaseline.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnBottom);
+    butClearBaseline.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnTop);
+    entryQuery.setJustification(Justification::centred);
+    entryQuery.setTextToShowWhenEmpty("//Track[@muted=true]", hintTextColour);
+    entryQuery.setColour(TextEditor::ColourIds::highlightedTextColourId, highlightedTextColour);
+    entryQuery.setColour(TextEditor::ColourIds::highlightColourId, highlightedTextColourBg);
+    entryQuery.setFont(theFontSmall());
+    butFind.setButtonText(ButtonText::find);
+    butFind.setTooltip("Select the nodes matching a path query: / for children, // for descendants, [@name op value] to filter");
+    butFind.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnTop);
     butUndo.setButtonText(ButtonText::undo);
     butRedo.setButtonText(ButtonText::redo);
-    butUndo.setLookAndFeel(&largeTextLnf);
-    butRedo.setLookAndFeel(&largeTextLnf);
+    butUndo.setLookAndFeel(largeTextLnf);
+    butRedo.setLookAndFeel(largeTextLnf);
 
     butAddNode.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnBottom);
     butAddProp.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnTop);
@@ -355,6 +420,51 @@ MiniToolbar::MiniToolbar()
     entryNewValue.setColour(TextEditor::ColourIds::highlightedTextColourId, highlightedTextColour);
     entryNewValue.setColour(TextEditor::ColourIds::highlightColourId, highlightedTextColourBg);
     entryNewValue.setFont(theFontSmall());
+    butAddWatch.setButtonText(ButtonText::addWatch);
+    butClearWatches.setButtonText(ButtonText::clearWatches);
+    butFreeze.setButtonText(ButtonText::freeze);
+    butFreeze.setTooltip("Keep showing the tree as it is now, to read and click on values which change too fast");
+    butAdaptiveSampling.setButtonText(ButtonText::adaptiveSampling);
+    comboBudget.addItemList({ "No overhead budget", "Budget 0.25 ms/frame", "Budget 0.5 ms/frame", "Budget 1 ms/frame", "Budget 2 ms/frame" }, 1);
+    comboBudget.setSelectedId(1, NotificationType::dontSendNotification);
+    comboBudget.setTooltip("Step down to cheaper updates while the debugger takes more than this per 16 ms frame");
+    butAdaptiveSampling.setTooltip("Poll the selected subtrees instead of following every change while they change faster than the threshold, click again to stop");
+    butTrace.setButtonText(ButtonText::startTrace);
+    butRecord.setButtonText(ButtonText::startRecording);
+    butExportSession.setButtonText(ButtonText::exportSession);
+    butExportSession.setTooltip("Save the change rate, most changed properties and nodes, structural churn, largest values since the tree was set, and the undo counts of the app's undo manager if one was given, as JSON or CSV");
+    butTimeTravel.setButtonText(ButtonText::timeTravel);
+    butTimeTravel.setTooltip("Keep the history of the tree from now on and browse it, read only");
+    butExcludeSubtree.setButtonText(ButtonText::excludeSubtree);
+    butExcludeSubtree.setTooltip("Stop following the selected subtrees, they are shown collapsed");
+    butExcludeType.setButtonText(ButtonText::excludeType);
+    butExcludeType.setTooltip("Stop following every subtree of the selected nodes' types, such as meters");
+    butExcludeProperty.setButtonText(ButtonText::excludeProperty);
+    butExcludeProperty.setTooltip("Stop following the selected property in every node");
+    butClearExclusions.setButtonText(ButtonText::clearExclusions);
+    butLoadReplay.setButtonText(ButtonText::loadReplay);
+    butPlayReplay.setButtonText(ButtonText::play);
+    butStepReplay.setButtonText(ButtonText::step);
+    butLoadReplay.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnBottom);
+    butPlayReplay.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnTop | Button::ConnectedEdgeFlags::ConnectedOnBottom);
+    butStepReplay.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnTop);
+    comboReplaySpeed.addItemList({ "1x", "2x", "10x", "Fastest" }, 1);
+    comboReplaySpeed.setSelectedId(1, NotificationType::dontSendNotification);
+    comboStressProfile.addItemList({ "Writes 1 kHz x 100", "Writes 10 kHz x 500", "Child bursts 100 x 10/s" }, 1);
+    comboStressProfile.setSelectedId(1, NotificationType::dontSendNotification);
+    toggleStressUndo.setButtonText("With undo");
+    butStress.setButtonText(ButtonText::startStress);
+    lblStatus.setFont(theFontMini());
+    lblStatus.setJustificationType(Justification::topLeft);
+    lblStatus.setColour(Label::ColourIds::textColourId, hintTextColour);
+    butAddWatch.setConnectedEdges(Button::ConnectedEdgeFlags::ConnectedOnTop);
+    entryWatch.setJustification(Justification::centred);
+    entryWatch.setTextToShowWhenEmpty("gain > 1.0", hintTextColour);
+    entryWatch.setColour(TextEditor::ColourIds::highlightedTextColourId, highlightedTextColour);
+    entryWatch.setColour(TextEditor::ColourIds::highlightColourId, highlightedTextColourBg);
+    entryWatch.setFont(theFontSmall());
+    comboWatchAction.addItemList({ "Log", "Break", "Pause" }, 1);
+    comboWatchAction.setSelectedId(1, NotificationType::dontSendNotification);
 
     fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
     addButtonToToolbar(butAddNode);
@@ -363,8 +473,49 @@ MiniToolbar::MiniToolbar()
     addButtonToToolbar(entryNewValue);
     addButtonToToolbar(butAddProp);
     fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
+    addButtonToToolbar(butCopy);
+    addButtonToToolbar(butPaste);
+    fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
     addButtonToToolbar(butDelNode);
     addButtonToToolbar(butDelProp);
+    addButtonToToolbar(butRenameProp);
+    addButtonToToolbar(butTrackHistory);
+    addButtonToToolbar(butStats);
+    fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
+    addButtonToToolbar(butLoadBaseline);
+    addButtonToToolbar(butClearBaseline);
+    fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
+    addButtonToToolbar(entryQuery);
+    addButtonToToolbar(butFind);
+    fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
+    addButtonToToolbar(entryWatch);
+    addButtonToToolbar(comboWatchAction);
+    addButtonToToolbar(butAddWatch);
+    addButtonToToolbar(butClearWatches);
+    addButtonToToolbar(butFreeze);
+    addButtonToToolbar(butAdaptiveSampling);
+    addButtonToToolbar(comboBudget);
+    addButtonToToolbar(butTrace);
+    addButtonToToolbar(butRecord);
+    addButtonToToolbar(butExportSession);
+    addButtonToToolbar(butTimeTravel);
+    fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
+    addButtonToToolbar(butExcludeSubtree);
+    addButtonToToolbar(butExcludeType);
+    addButtonToToolbar(butExcludeProperty);
+    addButtonToToolbar(butClearExclusions);
+    fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
+    addButtonToToolbar(butLoadReplay);
+    addButtonToToolbar(comboReplaySpeed);
+    addButtonToToolbar(butPlayReplay);
+    addButtonToToolbar(butStepReplay);
+    fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
+    addButtonToToolbar(comboStressProfile);
+    addButtonToToolbar(toggleStressUndo);
+    addButtonToToolbar(butStress);
+    fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
+    addAndMakeVisible(lblStatus);
+    fb.items.add(FlexItem{ lblStatus }.withFlex(1.f, 1.f, toolbarWidthF).withHeight(4.f * rowHeightF));
     fb.items.add(FlexItem{ paddingF, paddingF }.withWidth(toolbarWidthF));
 
     // Undo + redo can share a row
@@ -392,6 +543,17 @@ void MiniToolbar::resized()
     fb.performLayout(bounds);
 }
 
+int MiniToolbar::getIdealHeight(int width)
+{
+    fb.performLayout(Rectangle<float>{ 0.f, 0.f, (float)width, 10000.f });
+
+    float bottom{ 0.f };
+    for (const auto& item : fb.items)
+        bottom = jmax(bottom, item.currentBounds.getBottom());
+
+    return (int)std::ceil(bottom) + padding;
+}
+
 void MiniToolbar::textEditorTextChanged(juce::TextEditor& textEditor)
 {
     const auto newName = textEditor.getText();
@@ -416,34 +578,249 @@ void MiniToolbar::addButtonToToolbar(juce::Component& but)
 
 // ============================================================================
 
-DynamicValueView::DynamicValueView(const juce::ValueTree parentOfValue, const juce::Identifier nameOfProperty, juce::UndoManager* undoManager) :
+LargeTextView::LargeTextView() :
+    font(juce::FontOptions{ Font::getDefaultMonospacedFontName(), 12.f, Font::plain })
+{
+    lineHeight = font.getHeight() + 2.f;
+    characterWidth = GlyphArrangement::getStringWidth(font, "M");
+
+    verticalBar.setAutoHide(false);
+    verticalBar.addListener(this);
+    horizontalBar.addListener(this);
+    addAndMakeVisible(verticalBar);
+    addAndMakeVisible(horizontalBar);
+}
+
+LargeTextView::~LargeTextView()
+{
+    verticalBar.removeListener(this);
+    horizontalBar.removeListener(this);
+}
+
+void LargeTextView::setIndex(const TextLineIndex* indexToShow)
+{
+    index = indexToShow;
+    updateScrollBars();
+    repaint();
+}
+
+void LargeTextView::paint(juce::Graphics& g)
+{
+    g.fillAll(widgetBackgroundColour);
+    if (index == nullptr) return;
+
+    g.setFont(font);
+    const auto gutterWidth = characterWidth * (float)(String{ index->getNumLines() }.length() + 1);
+    const auto textLeft = gutterWidth + (float)padding;
+    const auto textWidth = (float)verticalBar.getX() - textLeft;
+    const auto firstLine = (int)verticalBar.getCurrentRangeStart();
+    const auto firstColumn = (int)horizontalBar.getCurrentRangeStart();
+    const auto numColumns = (int)(textWidth / characterWidth) + 1;
+
+    // Only the lines in view are read from the text
+    auto y = 0.f;
+    for (int line = firstLine; line < index->getNumLines() && y < (float)horizontalBar.getY(); ++line, y += lineHeight)
+    {
+        g.setColour(hintTextColour);
+        g.drawText(String{ line + 1 }, Rectangle<float>{ 0.f, y, gutterWidth, lineHeight }, Justification::centredRight, false);
+        g.setColour(propTextColour);
+        g.drawText(index->getLine(line, firstColumn, numColumns), Rectangle<float>{ textLeft, y, textWidth, lineHeight }, Justification::centredLeft, false);
+    }
+}
+
+void LargeTextView::resized()
+{
+    auto bounds = getLocalBounds();
+    const auto thickness = verticalBar.getLookAndFeel().getDefaultScrollbarWidth();
+    horizontalBar.setBounds(bounds.removeFromBottom(thickness).withTrimmedRight(thickness));
+    verticalBar.setBounds(bounds.removeFromRight(thickness));
+    updateScrollBars();
+}
+
+void LargeTextView::mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails& wheel)
+{
+    verticalBar.setCurrentRangeStart(verticalBar.getCurrentRangeStart() - wheel.deltaY * 10.0);
+    horizontalBar.setCurrentRangeStart(horizontalBar.getCurrentRangeStart() - wheel.deltaX * 10.0);
+}
+
+void LargeTextView::scrollBarMoved(juce::ScrollBar*, double)
+{
+    repaint();
+}
+
+void LargeTextView::updateScrollBars()
+{
+    const auto numLines = index != nullptr ? index->getNumLines() : 0;
+    const auto longestLine = index != nullptr ? index->getLongestLine() : 0;
+
+    verticalBar.setRangeLimits(0.0, (double)numLines + 1.0, dontSendNotification);
+    verticalBar.setCurrentRange(verticalBar.getCurrentRangeStart(), (double)horizontalBar.getY() / lineHeight, dontSendNotification);
+    horizontalBar.setRangeLimits(0.0, (double)longestLine + 1.0, dontSendNotification);
+    horizontalBar.setCurrentRange(horizontalBar.getCurrentRangeStart(), (double)verticalBar.getX() / characterWidth, dontSendNotification);
+}
+
+// ============================================================================
+
+LargeTextPanel::LargeTextPanel(const juce::ValueTree& treeToShow, const juce::Identifier& nameOfProperty, juce::UndoManager* undoManager, bool isReadOnly) :
+    tree(treeToShow),
+    propertyName(nameOfProperty),
+    um(undoManager),
+    readOnly(isReadOnly)
+{
+    lblSummary.setFont(theFontSmall());
+    lblSummary.setColour(Label::ColourIds::textColourId, hintTextColour);
+    lblSummary.setMinimumHorizontalScale(1.f);
+
+    butEdit.onClick = [&]() { setEditing(true); };
+    butApply.onClick = [&]() { apply(); };
+    butCancel.onClick = [&]() { setEditing(false); };
+
+    editor.setMultiLine(true, false);
+    editor.setReturnKeyStartsNewLine(true);
+    editor.setTabKeyUsedAsCharacter(true);
+    editor.setScrollbarsShown(true);
+    editor.setFont(juce::FontOptions{ Font::getDefaultMonospacedFontName(), 12.f, Font::plain });
+
+    addAndMakeVisible(lblSummary);
+    addChildComponent(butEdit);
+    butEdit.setVisible(!readOnly);
+    addChildComponent(butApply);
+    addChildComponent(butCancel);
+    addAndMakeVisible(view);
+    addChildComponent(editor);
+
+    reindex();
+    setSize(640, 420);
+    startTimerHz(4);
+}
+
+LargeTextPanel::~LargeTextPanel()
+{
+    stopTimer();
+    view.setIndex(nullptr);
+}
+
+void LargeTextPanel::show(const juce::ValueTree& treeToShow, const juce::Identifier& nameOfProperty, juce::UndoManager* undoManager, bool isReadOnly, juce::Component& pointAt)
+{
+    CallOutBox::launchAsynchronously(std::make_unique<LargeTextPanel>(treeToShow, nameOfProperty, undoManager, isReadOnly), pointAt.getScreenBounds(), nullptr);
+}
+
+void LargeTextPanel::resized()
+{
+    auto bounds = getLocalBounds();
+    auto header = bounds.removeFromTop(rowHeight);
+    butCancel.setBounds(header.removeFromRight(buttonWidth * 3));
+    butApply.setBounds(header.removeFromRight(buttonWidth * 3));
+    butEdit.setBounds(header.removeFromRight(buttonWidth * 3));
+    lblSummary.setBounds(header);
+
+    bounds.removeFromTop(padding);
+    view.setBounds(bounds);
+    editor.setBounds(bounds);
+}
+
+void LargeTextPanel::timerCallback()
+{
+    if (index.isIndexOf(tree[propertyName].toString())) return;
+
+    // An edit in progress isn't overwritten, the summary tells the value has moved on
+    if (editing)
+    {
+        changedWhileEditing = true;
+        updateSummary();
+        return;
+    }
+
+    reindex();
+}
+
+void LargeTextPanel::reindex()
+{
+    index.build(tree[propertyName].toString());
+    view.setIndex(&index);
+    updateSummary();
+}
+
+void LargeTextPanel::setEditing(bool shouldEdit)
+{
+    editing = shouldEdit;
+    changedWhileEditing = false;
+
+    // The only copy of the text is made here
+    if (editing)
+        editor.setText(index.getText(), false);
+    else
+        editor.clear();
+
+    editor.setVisible(editing);
+    view.setVisible(!editing);
+    butEdit.setVisible(!editing && !readOnly);
+    butApply.setVisible(editing);
+    butCancel.setVisible(editing);
+
+    if (!editing)
+        reindex();
+    else
+        updateSummary();
+}
+
+void LargeTextPanel::apply()
+{
+    tree.setProperty(propertyName, editor.getText(), um);
+    if (um) um->beginNewTransaction();
+
+    setEditing(false);
+}
+
+void LargeTextPanel::updateSummary()
+{
+    String summary;
+    summary << tree.getType().toString() << "." << propertyName.toString() << ": "
+            << index.describe();
+
+    if (changedWhileEditing)
+        summary << ", changed in the tree since editing started";
+
+    lblSummary.setText(summary, NotificationType::dontSendNotification);
+}
+
+// ============================================================================
+
+DynamicValueView::DynamicValueView(const juce::ValueTree parentOfValue, const juce::Identifier nameOfProperty, juce::UndoManager* undoManager, int scrubWritesPerSecond) :
     tree(parentOfValue),
     propertyName(nameOfProperty),
-    um(undoManager)
+    um(undoManager),
+    scrubRateHz(jmax(1, scrubWritesPerSecond))
 {
     lbl.setText(value().toString(), NotificationType::dontSendNotification);
     lbl.setEditable(false, true, false);
 
     butPlus.setLookAndFeel(textButtonLnf);
     butMinus.setLookAndFeel(textButtonLnf);
+    butOpenText.setLookAndFeel(textButtonLnf);
 
     addChildComponent(lbl);
     addChildComponent(butPlus);
     addChildComponent(butMinus);
     addChildComponent(butToggle);
+    addChildComponent(butOpenText);
 
     setVisibility();
     setCallbacks();
 
-    tree.addListener(this);
     lbl.addListener(this);
-    tree.sendPropertyChangeMessage(propertyName);
+    lbl.addMouseListener(this, false);
+    refresh();
 }
 
 DynamicValueView::~DynamicValueView()
 {
+    stopTimer();
+    if (gestureOpen && um) um->beginNewTransaction();
+
     butPlus.setLookAndFeel(nullptr);
     butMinus.setLookAndFeel(nullptr);
+    butOpenText.setLookAndFeel(nullptr);
 }
 
 void DynamicValueView::resized()
@@ -464,13 +841,126 @@ void DynamicValueView::resized()
     }
 }
 
-void DynamicValueView::valueTreePropertyChanged(juce::ValueTree& changedTree, const juce::Identifier& prop)
+void DynamicValueView::refresh()
 {
-    if (tree == changedTree && prop == propertyName)
+    setVisibility();
+
+    // A large string would be laid out in full by the label, and copied by each edit. Its summary
+    // is read from an index built once per value, not from the text on every refresh.
+    if (largeText)
+    {
+        const auto text = value().toString();
+        if (!largeTextIndex.isIndexOf(text))
+            largeTextIndex.build(text);
+
+        lbl.setText(largeTextIndex.describe(), NotificationType::dontSendNotification);
+    }
+    else
     {
-        setVisibility();
+        largeTextIndex.clear();
         lbl.setText(value().toString(), NotificationType::dontSendNotification);
-        butToggle.setToggleState(bool(value()), NotificationType::dontSendNotification);
+    }
+    butToggle.setToggleState(bool(value()), NotificationType::dontSendNotification);
+    resized();
+}
+
+void DynamicValueView::bind(const juce::ValueTree& parentOfValue, const juce::Identifier& nameOfProperty, juce::UndoManager* undoManager, int scrubWritesPerSecond)
+{
+    // A gesture belongs to the property it started on
+    endGesture();
+    scrubbing = false;
+
+    tree = parentOfValue;
+    propertyName = nameOfProperty;
+    um = undoManager;
+    scrubRateHz = jmax(1, scrubWritesPerSecond);
+    frozen = false;
+    frozenValue = juce::var{};
+
+    // Lays the view out as well
+    refresh();
+}
+
+void DynamicValueView::unbind()
+{
+    endGesture();
+    scrubbing = false;
+
+    // The label keeps its text until the next bind, clearing it would only be set again
+    tree = {};
+    largeTextIndex.clear();
+    um = nullptr;
+    frozen = false;
+    frozenValue = juce::var{};
+}
+
+void DynamicValueView::setEditable(bool shouldBeEditable)
+{
+    if (editable == shouldBeEditable) return;
+
+    editable = shouldBeEditable;
+    setVisibility();
+}
+
+void DynamicValueView::setFrozenValue(const juce::var* frozenValueToShow)
+{
+    if (!frozen && frozenValueToShow == nullptr) return;
+
+    frozen = frozenValueToShow != nullptr;
+    frozenValue = frozen ? *frozenValueToShow : juce::var{};
+    refresh();
+}
+
+void DynamicValueView::mouseDown(const juce::MouseEvent& evt)
+{
+    if (evt.eventComponent != &lbl || !editable || !isNumeric()) return;
+
+    scrubStartValue = value();
+}
+
+void DynamicValueView::mouseDrag(const juce::MouseEvent& evt)
+{
+    if (evt.eventComponent != &lbl || scrubStartValue.isVoid() || !evt.mouseWasDraggedSinceMouseDown()) return;
+
+    if (!scrubbing)
+    {
+        scrubbing = true;
+        beginGesture();
+    }
+
+    const auto pixels = evt.getDistanceFromDragStartX() - evt.getDistanceFromDragStartY();
+    const auto sensitivity = evt.mods.isShiftDown() ? 0.1 : 1.0;
+    juce::var newValue;
+
+    if (scrubStartValue.isDouble())
+    {
+        const double start = scrubStartValue;
+        const auto step = jmax(0.001, std::abs(start) * 0.01);
+        newValue = start + pixels * sensitivity * step;
+    }
+    else
+    {
+        const auto steps = (juce::int64)(pixels * sensitivity / scrubPixelsPerStep);
+        if (scrubStartValue.isInt64())
+            newValue = (juce::int64)scrubStartValue + steps;
+        else
+            newValue = (int)scrubStartValue + (int)steps;
+    }
+
+    lbl.setText(newValue.toString(), NotificationType::dontSendNotification);
+    writeDuringGesture(newValue);
+}
+
+void DynamicValueView::mouseUp(const juce::MouseEvent& evt)
+{
+    if (evt.eventComponent != &lbl) return;
+
+    scrubStartValue = var{};
+
+    if (scrubbing)
+    {
+        scrubbing = false;
+        endGesture();
     }
 }
 
@@ -481,7 +971,7 @@ void DynamicValueView::labelTextChanged(juce::Label* labelThatHasChanged)
     var newVal;
 
     if (oldVal.isInt()) newVal = text.getIntValue();
-    if (oldVal.isInt64()) newVal = text.getIntValue();
+    if (oldVal.isInt64()) newVal = text.getLargeIntValue();
     if (oldVal.isBool()) newVal = getBoolValue(text);
     if (oldVal.isDouble()) newVal = text.getDoubleValue();
     if (oldVal.isString()) newVal = text;
@@ -503,6 +993,17 @@ void DynamicValueView::setVisibility()
     butPlus.setVisible(false);
     butMinus.setVisible(false);
     butToggle.setVisible(false);
+    butOpenText.setVisible(false);
+    largeText = val.isString() && TextLineIndex::isLarge(val.toString());
+    lbl.setEditable(false, editable && !largeText, false);
+    if (largeText)
+        lbl.setColour(Label::ColourIds::textColourId, hintTextColour);
+    else
+        lbl.removeColour(Label::ColourIds::textColourId);
+    lbl.setMouseCursor(editable && isNumeric() ? MouseCursor::LeftRightResizeCursor : MouseCursor::NormalCursor);
+    butPlus.setEnabled(editable);
+    butMinus.setEnabled(editable);
+    butToggle.setEnabled(editable);
 
     if (val.isInt() || val.isInt64())
     {
@@ -517,19 +1018,24 @@ void DynamicValueView::setVisibility()
     else
     {
         lbl.setVisible(true);
+        butOpenText.setVisible(largeText);
     }
 }
 
 void DynamicValueView::setCallbacks()
 {
     const auto val = value();
+    // A run of clicks on the steppers is one undo transaction
     butPlus.onClick = [&]()
     {
         jassert(
             value().isInt() ||
             value().isInt64()
         );
-        setValue(int(value()) + 1);
+        beginGesture();
+        lastStepTime = Time::getMillisecondCounterHiRes();
+        writeDuringGesture(value().isInt64() ? var{ (juce::int64)value() + 1 } : var{ int(value()) + 1 });
+        flushGesture();
     };
     butMinus.onClick = [&]()
     {
@@ -537,13 +1043,20 @@ void DynamicValueView::setCallbacks()
             value().isInt() ||
             value().isInt64()
         );
-        setValue(int(value()) - 1);
+        beginGesture();
+        lastStepTime = Time::getMillisecondCounterHiRes();
+        writeDuringGesture(value().isInt64() ? var{ (juce::int64)value() - 1 } : var{ int(value()) - 1 });
+        flushGesture();
     };
     butToggle.onClick = [&]()
     {
         jassert(value().isBool());
         setValue(butToggle.getToggleState());
     };
+    butOpenText.onClick = [&]()
+    {
+        LargeTextPanel::show(tree, propertyName, um, !editable, butOpenText);
+    };
 }
 
 void DynamicValueView::resizedInt()
@@ -567,30 +1080,91 @@ void DynamicValueView::resizedBool()
 void DynamicValueView::resizedDefault()
 {
     auto bounds = getLocalBounds();
+    if (largeText)
+        butOpenText.setBounds(bounds.removeFromRight(buttonWidth * 3));
+
     lbl.setBounds(bounds);
 }
 
 juce::var DynamicValueView::value()
 {
-    return tree.getProperty(propertyName);
+    return frozen ? frozenValue : tree.getProperty(propertyName);
 }
 
 void DynamicValueView::setValue(const juce::var newValue)
 {
+    if (gestureOpen) endGesture();
+
     tree.setProperty(propertyName, newValue, um);
     if (um) um->beginNewTransaction();
 }
 
+bool DynamicValueView::isNumeric()
+{
+    const auto val = value();
+    return val.isInt() || val.isInt64() || val.isDouble();
+}
+
+void DynamicValueView::timerCallback()
+{
+    if (writePending)
+    {
+        flushGesture();
+    }
+    else if (!scrubbing && Time::getMillisecondCounterHiRes() - lastStepTime > stepGestureMs)
+    {
+        endGesture();
+    }
+}
+
+void DynamicValueView::beginGesture()
+{
+    if (gestureOpen) return;
+
+    gestureOpen = true;
+    if (um) um->beginNewTransaction();
+}
+
+void DynamicValueView::writeDuringGesture(const juce::var newValue)
+{
+    pendingValue = newValue;
+    writePending = true;
+
+    // The first write goes straight through, later ones wait for the timer
+    if (!isTimerRunning())
+    {
+        flushGesture();
+        startTimerHz(scrubRateHz);
+    }
+}
+
+void DynamicValueView::flushGesture()
+{
+    if (!writePending) return;
+
+    writePending = false;
+    // Writes in one transaction coalesce into a single undoable action
+    tree.setProperty(propertyName, pendingValue, um);
+}
+
+void DynamicValueView::endGesture()
+{
+    stopTimer();
+    flushGesture();
+
+    if (gestureOpen && um) um->beginNewTransaction();
+    gestureOpen = false;
+}
+
 // ============================================================================
 
-ValueTreePropertyView::ValueTreePropertyView(const juce::ValueTree parentOfProperty, const juce::Identifier nameOfProperty, juce::UndoManager* undoManager, ValueTreePropertySelection& treeviewPropertySelection) :
-    valView(parentOfProperty, nameOfProperty, undoManager),
+ValueTreePropertyView::ValueTreePropertyView(const juce::ValueTree parentOfProperty, const juce::Identifier nameOfProperty, juce::UndoManager* undoManager, ValueTreePropertySelection& treeviewPropertySelection, int scrubWritesPerSecond) :
+    valView(parentOfProperty, nameOfProperty, undoManager, scrubWritesPerSecond),
     tree(parentOfProperty),
     propertyName(nameOfProperty),
-    propertySelection(treeviewPropertySelection)
+    propertySelection(&treeviewPropertySelection)
 {
-    tree.addListener(this);
-    propertySelection.addChangeListener(this);
+    propertySelection->addChangeListener(this);
 
     propNameLbl.setText(nameOfProperty.toString(), NotificationType::dontSendNotification);
     propNameLbl.setMinimumHorizontalScale(1.f);
@@ -606,7 +1180,8 @@ ValueTreePropertyView::ValueTreePropertyView(const juce::ValueTree parentOfPrope
 
 ValueTreePropertyView::~ValueTreePropertyView()
 {
-    propertySelection.removeChangeListener(this);
+    if (propertySelection != nullptr)
+        propertySelection->removeChangeListener(this);
 }
 
 void ValueTreePropertyView::resized()
@@ -617,6 +1192,13 @@ void ValueTreePropertyView::resized()
     const auto propTypeRect = bounds.removeFromLeft(propTypeLabelWidth);
     bounds.removeFromLeft(padding);
 
+    sparklineArea = {};
+    if (history != nullptr)
+    {
+        sparklineArea = bounds.removeFromRight(sparklineWidth).reduced(0, 2);
+        bounds.removeFromRight(padding);
+    }
+
     propNameLbl.setBounds(propLblRect);
     propTypeLbl.setBounds(propTypeRect);
     valView.setBounds(bounds);
@@ -632,48 +1214,177 @@ void ValueTreePropertyView::paint(juce::Graphics& g)
     {
         g.fillAll(hoverBgColourProp);
     }
+
+    if (differs)
+    {
+        g.setColour(changedColour.withAlpha(0.25f));
+        g.fillRect(propNameLbl.getBounds());
+    }
+
+    if (history != nullptr)
+        paintSparkline(g);
+}
+
+void ValueTreePropertyView::refresh()
+{
+    propTypeLbl.setText(getTypeOfVar(valView.value()), NotificationType::dontSendNotification);
+    valView.refresh();
+
+    if (history != nullptr)
+        repaint(sparklineArea);
+}
+
+void ValueTreePropertyView::bind(const juce::ValueTree& parentOfProperty, const juce::Identifier& nameOfProperty, juce::UndoManager* undoManager,
+                                 ValueTreePropertySelection* treeviewPropertySelection, int scrubWritesPerSecond)
+{
+    // Pooled rows serve every debugger of the window, each with its own selection
+    if (propertySelection != treeviewPropertySelection)
+    {
+        if (propertySelection != nullptr) propertySelection->removeChangeListener(this);
+        propertySelection = treeviewPropertySelection;
+        if (propertySelection != nullptr) propertySelection->addChangeListener(this);
+    }
+
+    tree = parentOfProperty;
+    propertyName = nameOfProperty;
+    selected = propertySelection != nullptr && propertySelection->matchesAndIsSelected(tree, propertyName);
+    differs = false;
+    history = nullptr;
+
+    propNameLbl.setText(nameOfProperty.toString(), NotificationType::dontSendNotification);
+    propNameLbl.setTooltip({});
+    propTypeLbl.setText(getTypeOfVar(parentOfProperty[nameOfProperty]), NotificationType::dontSendNotification);
+    valView.bind(parentOfProperty, nameOfProperty, undoManager, scrubWritesPerSecond);
+
+    resized();
+    repaint();
+}
+
+void ValueTreePropertyView::unbind()
+{
+    if (propertySelection != nullptr) propertySelection->removeChangeListener(this);
+    propertySelection = nullptr;
+
+    // The labels keep their text until the next bind sets it
+    tree = {};
+    propertyName = {};
+    selected = false;
+    differs = false;
+    history = nullptr;
+    valView.unbind();
+}
+
+void ValueTreePropertyView::setHistory(const ValueHistory::Buffer* historyToShow)
+{
+    history = historyToShow;
+    resized();
+    repaint();
+}
+
+void ValueTreePropertyView::setDiffers(bool shouldBeMarked, const juce::String& baselineDescription)
+{
+    propNameLbl.setTooltip(baselineDescription);
+    if (differs == shouldBeMarked) return;
+
+    differs = shouldBeMarked;
+    repaint();
 }
 
-void ValueTreePropertyView::valueTreePropertyChanged(juce::ValueTree& changedTree, const juce::Identifier& prop)
+void ValueTreePropertyView::setFrozenValue(const juce::var* frozenValueToShow)
 {
-    if (tree == changedTree && prop == propertyName)
+    valView.setFrozenValue(frozenValueToShow);
+    propTypeLbl.setText(getTypeOfVar(valView.value()), NotificationType::dontSendNotification);
+}
+
+void ValueTreePropertyView::paintSparkline(juce::Graphics& g)
+{
+    g.setColour(widgetBackgroundColour);
+    g.fillRect(sparklineArea);
+
+    const auto numColumns = jmin(sparklineArea.getWidth(), maxSparklineColumns, history->size());
+    if (numColumns <= 0) return;
+
+    // One min/max pair per pixel column, however many samples are kept
+    float mins[maxSparklineColumns];
+    float maxs[maxSparklineColumns];
+    history->decimate(numColumns, mins, maxs);
+
+    const auto range = history->getRange(0, history->size());
+    const auto scale = range.getLength() > 0.f ? (float)(sparklineArea.getHeight() - 1) / range.getLength() : 0.f;
+    const auto bottom = (float)sparklineArea.getBottom() - (range.getLength() > 0.f ? 1.f : sparklineArea.getHeight() * 0.5f);
+    const auto left = sparklineArea.getRight() - numColumns;
+
+    g.setColour(propTextColour);
+    for (int column = 0; column < numColumns; ++column)
     {
-        propTypeLbl.setText(getTypeOfVar(tree[prop]), NotificationType::dontSendNotification);
+        const auto top = bottom - (maxs[column] - range.getStart()) * scale;
+        const auto low = bottom - (mins[column] - range.getStart()) * scale;
+        g.fillRect((float)(left + column), top, 1.f, jmax(1.f, low - top + 1.f));
     }
 }
 
 void ValueTreePropertyView::changeListenerCallback(ChangeBroadcaster*)
 {
-    selected = propertySelection.matchesAndIsSelected(tree, propertyName);
-    getParentComponent()->repaint();
+    selected = propertySelection->matchesAndIsSelected(tree, propertyName);
+
+    // Rows waiting in the pool have no parent
+    if (auto* parentComp = getParentComponent())
+        parentComp->repaint();
 }
 
 // ============================================================================
 
-ValueTreeView::ValueTreeView(juce::String componentName, juce::ValueTree tree, Item& parentItem, juce::UndoManager* undoManager, ValueTreePropertySelection& treeviewPropertySelection) :
-    juce::Component(componentName),
-    parent(parentItem),
-    um(undoManager),
-    propertySelection(treeviewPropertySelection)
+ValueTreeView::ValueTreeView(ItemContext& itemContext) :
+    context(&itemContext)
 {
     setLookAndFeel(lnf);
     addMouseListener(this, true);
 
-    lblType.setText(tree.getType().toString(), NotificationType::dontSendNotification);
     lblType.setMinimumHorizontalScale(1.f);
     lblType.setColour(Label::ColourIds::textColourId, typeTextColour);
     addAndMakeVisible(lblType);
 
-    createPropertyComponents();
+    setupPropertyBlock();
 }
 
 ValueTreeView::~ValueTreeView()
 {
+    unbind();
     setLookAndFeel(nullptr);
 }
 
+void ValueTreeView::bind(Item& item)
+{
+    // Pooled views serve every debugger of the window
+    parent = &item;
+    context = &item.getContext();
+    const auto type = item.tree.getType().toString();
+    lblType.setText(item.excluded ? type + " (excluded)" : type, NotificationType::dontSendNotification);
+    lblType.setColour(Label::ColourIds::textColourId, item.excluded ? hintTextColour : typeTextColour);
+    createPropertyComponents();
+}
+
+void ValueTreeView::unbind()
+{
+    if (parent != nullptr && parent->comp == this)
+        parent->comp = nullptr;
+
+    parent = nullptr;
+    difference = {};
+
+    for (auto* prop : props)
+    {
+        removeChildComponent(prop);
+        context->viewPool->releaseRow(std::unique_ptr<ValueTreePropertyView>(prop));
+    }
+    // Keeps the storage of the array for the next item shown
+    props.clearQuick(false);
+}
+
 void ValueTreeView::resized()
 {
+    if (parent == nullptr) return;
+
     auto bounds = getLocalBounds();
     bounds.removeFromRight(padding);
     const auto rectType = bounds.removeFromLeft(treeTypeLabelWidth).removeFromTop(rowHeight);
@@ -681,6 +1392,15 @@ void ValueTreeView::resized()
     bounds.removeFromLeft(padding);
     propsArea = bounds;
 
+    if (parent->usesPropertyBlock())
+    {
+        auto headerRect = bounds.removeFromTop(rowHeight);
+        butNextPage.setBounds(headerRect.removeFromRight(buttonWidth));
+        butPrevPage.setBounds(headerRect.removeFromRight(buttonWidth));
+        lblPage.setBounds(headerRect.removeFromRight(treeTypeLabelWidth));
+        butPropertyBlock.setBounds(headerRect);
+    }
+
     for (auto* prop : props)
     {
         const auto propRect = bounds.removeFromTop(rowHeight);
@@ -690,7 +1410,12 @@ void ValueTreeView::resized()
 
 void ValueTreeView::paint(juce::Graphics& g)
 {
-    if (parent.isSelected())
+    if (parent == nullptr) return;
+
+    if (context->governor != nullptr && context->governor->isEnabled())
+        paintStartTicks = Time::getHighResolutionTicks();
+
+    if (parent->isSelected())
     {
         g.fillAll(selectedBgColour);
     }
@@ -698,21 +1423,47 @@ void ValueTreeView::paint(juce::Graphics& g)
     {
         g.fillAll(hoverBgColour);
     }
-}
 
-void ValueTreeView::mouseUp(const juce::MouseEvent& evt)
-{
-    if (auto* propView = propertyMoused(evt))
+    if (difference.added)
     {
-        propertySelection.select(propView->tree, propView->propertyName);
+        g.setColour(addedColour.withAlpha(0.2f));
+        g.fillRect(lblType.getBounds());
     }
-    else
+    else if (difference.contentChanged)
     {
-        propertySelection.deselect();
+        g.setColour(changedColour.withAlpha(0.2f));
+        g.fillRect(lblType.getBounds());
     }
-}
 
-void ValueTreeView::mouseEnter(const juce::MouseEvent&)
+    // A bar at the edge leads down to differences further in
+    if (difference.descendantsDiffer || difference.childrenRemoved)
+    {
+        g.setColour(difference.added ? addedColour : changedColour);
+        g.fillRect(0, 0, 2, getHeight());
+    }
+}
+
+void ValueTreeView::paintOverChildren(juce::Graphics&)
+{
+    if (paintStartTicks == 0) return;
+
+    context->governor->addTime(Time::getHighResolutionTicks() - paintStartTicks);
+    paintStartTicks = 0;
+}
+
+void ValueTreeView::mouseUp(const juce::MouseEvent& evt)
+{
+    if (auto* propView = propertyMoused(evt))
+    {
+        context->propertySelection.select(propView->tree, propView->propertyName);
+    }
+    else
+    {
+        context->propertySelection.deselect();
+    }
+}
+
+void ValueTreeView::mouseEnter(const juce::MouseEvent&)
 {
     repaint();
 }
@@ -724,16 +1475,139 @@ void ValueTreeView::mouseExit(const juce::MouseEvent&)
 
 void ValueTreeView::createPropertyComponents()
 {
-    props.clear(true);
-    for (int i = 0; i < parent.tree.getNumProperties(); ++i)
+    jassert(parent != nullptr);
+    updatePropertyBlock();
+
+    // The rows already here are rebound first, then rows come from or go back to the pool
+    const auto range = parent->getVisiblePropertyRange();
+    for (int i = range.getStart(); i < range.getEnd(); ++i)
+    {
+        const auto row = i - range.getStart();
+        const auto name = parent->getShownPropertyName(i);
+
+        ValueTreePropertyView* prop;
+        if (row < props.size())
+        {
+            prop = props[row];
+            prop->bind(parent->tree, name, context->um, &context->propertySelection, context->scrubRateHz);
+        }
+        else
+        {
+            prop = props.add(context->viewPool->takeRow(*context, parent->tree, name));
+            addAndMakeVisible(*prop);
+        }
+
+        if (context->history != nullptr)
+            prop->setHistory(context->history->find(parent->nodeId, name));
+
+        if (context->freeze != nullptr && context->freeze->isFrozen())
+            prop->setFrozenValue(context->freeze->findValue(parent->nodeId, name));
+    }
+
+    while (props.size() > range.getLength())
     {
-        const juce::Identifier name = parent.tree.getPropertyName(i);
-        auto latest = props.add(std::make_unique<ValueTreePropertyView>(parent.tree, name, um, propertySelection));
-        addAndMakeVisible(*latest);
+        auto* prop = props.getLast();
+        removeChildComponent(prop);
+        props.removeLast(1, false);
+        context->viewPool->releaseRow(std::unique_ptr<ValueTreePropertyView>(prop));
     }
+
+    updateDiff();
     resized();
 }
 
+void ValueTreeView::propertyChanged(const juce::Identifier& property)
+{
+    for (auto* prop : props)
+    {
+        if (prop->propertyName == property)
+        {
+            prop->refresh();
+            return;
+        }
+    }
+}
+
+void ValueTreeView::updateDiff()
+{
+    const auto* diff = context->diff;
+    const auto* found = diff != nullptr ? diff->find(parent->nodeId) : nullptr;
+    difference = found != nullptr ? *found : TreeDiff::Difference{};
+
+    String typeTooltip;
+    if (difference.added)
+    {
+        typeTooltip = "Not in the baseline";
+    }
+    else if (difference.baselineNode != FlatTreeModel::none)
+    {
+        const auto& baselineType = diff->getBaseline().getType(difference.baselineNode);
+        if (baselineType != parent->tree.getType())
+            typeTooltip << "Baseline type: " << baselineType.toString() << newLine;
+
+        if (difference.childrenRemoved)
+            typeTooltip << difference.childrenRemoved << " children of the baseline are missing";
+    }
+    lblType.setTooltip(typeTooltip.trim());
+
+    for (auto* prop : props)
+    {
+        if (difference.added)
+        {
+            prop->setDiffers(true, "Not in the baseline");
+        }
+        else if (difference.properties.contains(prop->propertyName))
+        {
+            const auto* baselineValue = diff->findBaselineValue(parent->nodeId, prop->propertyName);
+            prop->setDiffers(true, baselineValue != nullptr ? "Baseline: " + baselineValue->toString() + " (" + getTypeOfVar(*baselineValue) + ")"
+                                                            : String{ "Not in the baseline" });
+        }
+        else
+        {
+            prop->setDiffers(false, {});
+        }
+    }
+
+    repaint();
+}
+
+void ValueTreeView::setupPropertyBlock()
+{
+    butPropertyBlock.onClick = [&]() { parent->setPropertyBlockOpen(!parent->propertyBlockOpen); };
+    butPrevPage.onClick = [&]() { parent->setPropertyPage(parent->propertyPage - 1); };
+    butNextPage.onClick = [&]() { parent->setPropertyPage(parent->propertyPage + 1); };
+
+    lblPage.setJustificationType(Justification::centred);
+    lblPage.setMinimumHorizontalScale(1.f);
+    lblPage.setColour(Label::ColourIds::textColourId, hintTextColour);
+
+    addChildComponent(butPropertyBlock);
+    addChildComponent(butPrevPage);
+    addChildComponent(butNextPage);
+    addChildComponent(lblPage);
+}
+
+void ValueTreeView::updatePropertyBlock()
+{
+    const bool isBlock = parent->usesPropertyBlock();
+    const bool showPager = isBlock && parent->propertyBlockOpen && parent->getNumPropertyPages() > 1;
+
+    butPropertyBlock.setVisible(isBlock);
+    butPrevPage.setVisible(showPager);
+    butNextPage.setVisible(showPager);
+    lblPage.setVisible(showPager);
+
+    if (!isBlock) return;
+
+    const auto numProperties = parent->getNumShownProperties();
+    butPropertyBlock.setButtonText((parent->propertyBlockOpen ? "- " : "+ ") + String{ numProperties } + " properties");
+
+    const auto range = parent->getVisiblePropertyRange();
+    lblPage.setText(String{ range.getStart() + 1 } + "-" + String{ range.getEnd() } + " of " + String{ numProperties }, NotificationType::dontSendNotification);
+    butPrevPage.setEnabled(parent->propertyPage > 0);
+    butNextPage.setEnabled(parent->propertyPage < parent->getNumPropertyPages() - 1);
+}
+
 ValueTreePropertyView* ValueTreeView::propertyMoused(const juce::MouseEvent& evt)
 {
     for (auto* prop : props)
@@ -749,21 +1623,173 @@ ValueTreePropertyView* ValueTreeView::propertyMoused(const juce::MouseEvent& evt
 
 // ============================================================================
 
-Item::Item(juce::ValueTree treeToUse, juce::UndoManager* undoManager, ValueTreePropertySelection& treeviewPropertySelection) :
-    tree(treeToUse),
-    um(undoManager),
+ViewPool::~ViewPool()
+{
+    // Views let go of their rows first
+    freeViews.clear();
+    freeRows.clear();
+}
+
+std::unique_ptr<ValueTreeView> ViewPool::takeView(Item& item)
+{
+    std::unique_ptr<ValueTreeView> view;
+    if (freeViews.empty())
+    {
+        view = std::make_unique<ValueTreeView>(item.getContext());
+    }
+    else
+    {
+        view = std::move(freeViews.back());
+        freeViews.pop_back();
+    }
+
+    view->bind(item);
+    return view;
+}
+
+void ViewPool::releaseView(std::unique_ptr<ValueTreeView> view)
+{
+    view->unbind();
+    freeViews.push_back(std::move(view));
+}
+
+std::unique_ptr<ValueTreePropertyView> ViewPool::takeRow(ItemContext& context, const juce::ValueTree& tree, const juce::Identifier& name)
+{
+    std::unique_ptr<ValueTreePropertyView> row;
+
+    if (freeRows.empty())
+    {
+        row = std::make_unique<ValueTreePropertyView>(tree, name, context.um, context.propertySelection, context.scrubRateHz);
+    }
+    else
+    {
+        row = std::move(freeRows.back());
+        freeRows.pop_back();
+        row->bind(tree, name, context.um, &context.propertySelection, context.scrubRateHz);
+    }
+
+    row->valView.setEditable(!context.readOnly);
+    return row;
+}
+
+void ViewPool::releaseRow(std::unique_ptr<ValueTreePropertyView> row)
+{
+    row->unbind();
+    freeRows.push_back(std::move(row));
+}
+
+// ============================================================================
+
+PooledItemComponent::PooledItemComponent(std::unique_ptr<ValueTreeView> viewToShow, ViewPool& viewPool) :
+    view(std::move(viewToShow)),
+    pool(viewPool)
+{
+    addAndMakeVisible(*view);
+}
+
+PooledItemComponent::~PooledItemComponent()
+{
+    removeChildComponent(view.get());
+    pool.releaseView(std::move(view));
+}
+
+void PooledItemComponent::resized()
+{
+    view->setBounds(getLocalBounds());
+}
+
+// ============================================================================
+
+ItemContext::ItemContext(FlatTreeModel& treeModel, ValueTreePropertySelection& treeviewPropertySelection) :
+    model(treeModel),
     propertySelection(treeviewPropertySelection)
 {
-    tree.addListener(this);
+}
+
+Item* ItemContext::findItem(FlatTreeModel::NodeId id) const
+{
+    const auto it = items.find(id);
+    return it != items.end() ? it->second : nullptr;
+}
+
+bool ItemContext::isClosed(const Item& item)
+{
+    if (closedNodes.count(item.nodeId) > 0) return true;
+    if (closedPaths.empty()) return false;
+
+    // Carried over a redirect, the node has a new id
+    const auto it = closedPaths.find(getOpennessPath(item.tree));
+    if (it == closedPaths.end()) return false;
+
+    closedPaths.erase(it);
+    closedNodes.insert(item.nodeId);
+    return true;
+}
+
+void ItemContext::keepOpennessByPath()
+{
+    closedPaths.clear();
+    for (auto id : closedNodes)
+    {
+        const auto node = model.findNode(id);
+        if (node != FlatTreeModel::none)
+            closedPaths.insert(getOpennessPath(model.getTree(node)));
+    }
+
+    closedNodes.clear();
+    selectedNodes.clear();
+}
+
+void ItemContext::clearOpenness()
+{
+    closedNodes.clear();
+    closedPaths.clear();
+    selectedNodes.clear();
+}
+
+juce::String ItemContext::getOpennessPath(const juce::ValueTree& tree)
+{
+    return getItemIdString(tree) + ":" + tree.getType().toString();
+}
+
+// ============================================================================
+
+Item::Item(juce::ValueTree treeToUse, FlatTreeModel::NodeId id, ItemContext& itemContext) :
+    tree(treeToUse),
+    nodeId(id),
+    excluded(itemContext.exclusions != nullptr && itemContext.exclusions->isExcludedRoot(treeToUse)),
+    context(itemContext),
+    um(itemContext.um),
+    propertySelection(itemContext.propertySelection)
+{
+    numProperties = getNumShownProperties();
+    context.items[nodeId] = this;
 }
 
 Item::~Item()
 {
     clearSubItems();
+
+    // The tree view may delete the component of this item later
+    if (comp != nullptr)
+        comp->unbind();
+
+    // A re-created item for the same node may already have replaced this one
+    const auto it = context.items.find(nodeId);
+    if (it != context.items.end() && it->second == this)
+        context.items.erase(it);
 }
 
 bool Item::mightContainSubItems()
 {
+    if (excluded) return false;
+
+    if (context.freeze != nullptr && context.freeze->isFrozen())
+    {
+        const auto* lists = findFrozenLists();
+        return lists != nullptr && lists->childrenKept && !lists->children.empty();
+    }
+
     return tree.getNumChildren() > 0;
 }
 
@@ -776,19 +1802,45 @@ juce::String Item::getUniqueName() const
 
 void Item::itemOpennessChanged(bool isNowOpen)
 {
-    if (isNowOpen) updateSubItems();
+    // Items are open by default, so only the closed ones are kept
+    if (isNowOpen)
+    {
+        context.closedNodes.erase(nodeId);
+        updateSubItems();
+    }
+    else
+    {
+        context.closedNodes.insert(nodeId);
+    }
+}
+
+void Item::itemSelectionChanged(bool isNowSelected)
+{
+    if (isNowSelected)
+        context.selectedNodes.insert(nodeId);
+    else
+        context.selectedNodes.erase(nodeId);
 }
 
 int Item::getItemHeight() const
 {
-    return jmax(rowHeight, rowHeight * tree.getNumProperties());
+    if (excluded)
+        return rowHeight;
+
+    if (usesPropertyBlock())
+    {
+        // Summary row, then only the rows of the current page
+        return rowHeight + rowHeight * getVisiblePropertyRange().getLength();
+    }
+
+    return jmax(rowHeight, rowHeight * getNumShownProperties());
 }
 
 std::unique_ptr<juce::Component> Item::createItemComponent()
 {
-    auto ret = std::make_unique<ValueTreeView>(getUniqueName(), tree, *this, um, propertySelection);
-    comp = ret.get();
-    return ret;
+    auto view = context.viewPool->takeView(*this);
+    comp = view.get();
+    return std::make_unique<PooledItemComponent>(std::move(view), *context.viewPool);
 }
 
 bool Item::customComponentUsesTreeViewMouseHandler() const
@@ -798,12 +1850,12 @@ bool Item::customComponentUsesTreeViewMouseHandler() const
 
 juce::var Item::getDragSourceDescription()
 {
-    return dragAndDropId;
+    return context.readOnly ? juce::var{} : dragAndDropId;
 }
 
 bool Item::isInterestedInDragSource(const juce::DragAndDropTarget::SourceDetails& dragSourceDetails)
 {
-    return dragSourceDetails.description == dragAndDropId;
+    return !context.readOnly && dragSourceDetails.description == dragAndDropId;
 }
 
 inline void Item::itemDropped(const juce::DragAndDropTarget::SourceDetails&, int insertIndex)
@@ -811,255 +1863,2069 @@ inline void Item::itemDropped(const juce::DragAndDropTarget::SourceDetails&, int
     OwnedArray<ValueTree> selectedTrees;
     getSelectedTreeViewItems(*getOwnerView(), selectedTrees);
 
-    moveItems(*getOwnerView(), selectedTrees, tree, insertIndex, um);
+    moveItems(selectedTrees, tree, insertIndex, um);
     if (um) um->beginNewTransaction();
 }
 
-void Item::valueTreeChildAdded(juce::ValueTree& parentTree, juce::ValueTree&)
+void Item::propertyChanged(const juce::Identifier& property)
 {
-    if (parentTree == tree)
-        updateSubItems();
+    const auto newNumProperties = getNumShownProperties();
 
-    treeHasChanged();
+    if (newNumProperties != numProperties)
+    {
+        // A property was added or removed, so the rows and the item height change
+        numProperties = newNumProperties;
+        if (comp != nullptr)
+            comp->createPropertyComponents();
+
+        treeHasChanged();
+    }
+    else if (comp != nullptr)
+    {
+        comp->propertyChanged(property);
+    }
 }
 
-void Item::valueTreeChildRemoved(juce::ValueTree& parentTree, juce::ValueTree&, int)
+void Item::childrenChanged()
 {
-    if (parentTree == tree)
+    // Children of closed items are built when they are opened
+    if (isOpen() || getNumSubItems() > 0)
         updateSubItems();
+}
 
-    treeHasChanged();
+void Item::childrenAppended()
+{
+    if (!isOpen() && getNumSubItems() == 0) return;
+
+    const auto& model = context.model;
+    const auto node = model.findNode(nodeId);
+    if (node == FlatTreeModel::none) return;
+
+    // The existing sub-items match the first children of the node, only the new ones are added
+    for (auto child = model.getChild(node, getNumSubItems()); child != FlatTreeModel::none; child = model.getNextSibling(child))
+        addSubItemFor(model.getTree(child), model.getNodeId(child));
 }
 
-void Item::valueTreeChildOrderChanged(juce::ValueTree& parentTreeWhoseChildrenHaveMoved, int, int)
+void Item::diffChanged()
 {
-    if (parentTreeWhoseChildrenHaveMoved == tree)
-        updateSubItems();
+    if (comp != nullptr)
+        comp->updateDiff();
+}
 
-    treeHasChanged();
+void Item::updateSubItems()
+{
+    clearSubItems();
+
+    // The view shows the children as they were, which are only kept for the nodes shown when frozen
+    if (context.freeze != nullptr && context.freeze->isFrozen())
+    {
+        const auto* lists = findFrozenLists();
+        if (lists == nullptr || !lists->childrenKept)
+        {
+            context.withheldSubItems.push_back(nodeId);
+            return;
+        }
+
+        for (const auto& child : lists->children)
+            addSubItemFor(child.first, child.second);
+
+        return;
+    }
+
+    const auto& model = context.model;
+    const auto node = model.findNode(nodeId);
+
+    if (node != FlatTreeModel::none)
+        for (auto child = model.getFirstChild(node); child != FlatTreeModel::none; child = model.getNextSibling(child))
+            addSubItemFor(model.getTree(child), model.getNodeId(child));
 }
 
-void Item::valueTreeParentChanged(juce::ValueTree&)
+void Item::addSubItemFor(const juce::ValueTree& child, FlatTreeModel::NodeId childId)
 {
-    treeHasChanged();
+    auto* item = new Item(child, childId, context);
+
+    // Closed before it is added, so the sub-items of a closed item are never built
+    if (context.isClosed(*item))
+        item->setOpenness(Openness::opennessClosed);
+
+    addSubItem(item);
+
+    if (context.selectedNodes.count(item->nodeId) > 0)
+        item->setSelected(true, false, dontSendNotification);
 }
 
-void Item::valueTreeRedirected(juce::ValueTree&)
+void Item::refreshProperties()
 {
-    // This should be handled by the ValueTreeDebuggerMain
-    jassertfalse;
-    
-    updateSubItems();
+    syncProperties();
     treeHasChanged();
 }
 
-void Item::updateSubItems()
+bool Item::syncProperties()
 {
-    std::unique_ptr<XmlElement> opennessXml = getOpennessState();
-    clearSubItems();
-    int children = tree.getNumChildren();
-
-    for (int i = 0; i < children; ++i)
-        addSubItem(new Item(tree.getChild(i), um, propertySelection));
+    const auto heightChanged = numProperties != getNumShownProperties();
+    numProperties = getNumShownProperties();
+    if (comp != nullptr)
+        comp->createPropertyComponents();
 
-    if (opennessXml.get())
-        restoreOpennessState(*opennessXml.get());
+    return heightChanged;
 }
 
 void Item::deselectAll()
 {
+    if (comp == nullptr) return;
+
     for (auto* prop : comp->props)
     {
         prop->selected = false;
     }
 }
 
-// ============================================================================
+bool Item::usesPropertyBlock() const
+{
+    return !excluded && getNumShownProperties() > propertyBlockThreshold;
+}
 
-ValueTreeDebuggerMain::ValueTreeDebuggerMain(juce::UndoManager* undoManager) :
-    um(undoManager)
+int Item::getNumPropertyPages() const
 {
-    treeView.setDefaultOpenness(true);
-    treeView.setColour(TreeView::ColourIds::backgroundColourId, widgetBackgroundColour);
+    return jmax(1, (getNumShownProperties() + propertyPageSize - 1) / propertyPageSize);
+}
 
-    setSize(800, 600);
+juce::Range<int> Item::getVisiblePropertyRange() const
+{
+    const auto numProperties = getNumShownProperties();
 
-    addAndMakeVisible(toolbar);
-    addAndMakeVisible(treeView);
+    if (excluded)
+        return {};
 
-    setupToolbar();
+    if (!usesPropertyBlock())
+        return { 0, numProperties };
+
+    if (!propertyBlockOpen)
+        return {};
+
+    const auto page = jlimit(0, getNumPropertyPages() - 1, propertyPage);
+    const auto start = page * propertyPageSize;
+    return { start, jmin(start + propertyPageSize, numProperties) };
 }
 
-ValueTreeDebuggerMain::~ValueTreeDebuggerMain()
+void Item::setPropertyBlockOpen(bool shouldBeOpen)
 {
-    treeView.setRootItem(nullptr);
+    if (propertyBlockOpen == shouldBeOpen) return;
+
+    propertyBlockOpen = shouldBeOpen;
+    propertyBlockChanged();
 }
 
-void ValueTreeDebuggerMain::resized()
+void Item::setPropertyPage(int newPage)
 {
-    auto bounds = getLocalBounds();
-    auto toolbarRect = bounds.removeFromLeft(toolbarWidth);
-    toolbar.setBounds(toolbarRect);
-    treeView.setBounds(bounds);
+    newPage = jlimit(0, getNumPropertyPages() - 1, newPage);
+    if (propertyPage == newPage) return;
+
+    propertyPage = newPage;
+    propertyBlockChanged();
 }
 
-void ValueTreeDebuggerMain::valueTreeRedirected(juce::ValueTree& treeWhichHasBeenChanged)
+int Item::getNumShownProperties() const
 {
-    // The address of the value tree does not change, just the shared object the value tree is referencing
-    jassert(tree == &treeWhichHasBeenChanged);
-    setTree(&treeWhichHasBeenChanged);
+    if (const auto* lists = findFrozenLists())
+        return lists->properties.size();
+
+    return tree.getNumProperties();
 }
 
-void ValueTreeDebuggerMain::setTree(juce::ValueTree* newTree)
+juce::Identifier Item::getShownPropertyName(int index) const
 {
-    treeView.setRootItem(nullptr);
-    if (newTree == nullptr) return;
-    
-    tree = newTree;
-    tree->addListener(this);
-    
-    rootItem = std::make_unique<Item>(*tree, um, selectedProperty);
-    treeView.setRootItem(rootItem.get());
-    rootItem->updateSubItems();
-    rootItem->treeHasChanged();
+    if (const auto* lists = findFrozenLists())
+        return lists->properties[index];
+
+    return tree.getPropertyName(index);
 }
 
-void ValueTreeDebuggerMain::setupToolbar()
+const FreezeSnapshot::Lists* Item::findFrozenLists() const
 {
-    toolbar.butUndo.onClick = [&]()
+    if (context.freeze == nullptr || !context.freeze->isFrozen()) return nullptr;
+
+    return context.freeze->findLists(nodeId);
+}
+
+void Item::propertyBlockChanged()
+{
+    if (comp != nullptr)
+        comp->createPropertyComponents();
+
+    // The item height depends on the open page
+    treeHasChanged();
+}
+
+// ============================================================================
+
+SourceTabs::SourceTabs() :
+    TabbedButtonBar(TabbedButtonBar::TabsAtTop)
+{
+}
+
+void SourceTabs::currentTabChanged(int newCurrentTabIndex, const juce::String&)
+{
+    if (onTabChanged)
+        onTabChanged(newCurrentTabIndex);
+}
+
+// ============================================================================
+
+DebuggerHub::DebuggerHub()
+{
+    governor.onLevelChanged = [&](OverheadGovernor::Level previous)
     {
-        if (um) um->undo();
-        rootItem->updateSubItems();
+        for (auto* main : debuggers)
+            main->governorLevelChanged(previous);
     };
-    toolbar.butRedo.onClick = [&]()
+    governor.onFlush = [&]()
     {
-        if (um) um->redo();
-        rootItem->updateSubItems();
+        for (auto* main : debuggers)
+            main->governorFlushed();
     };
-    toolbar.butAddProp.onClick = [&]()
-    {
-        if (auto* selectedItem = dynamic_cast<Item*>(treeView.getSelectedItem(0)))
-        {
+}
+
+DebuggerHub::~DebuggerHub()
+{
+    // Each debugger takes itself off before the hub goes
+    jassert(debuggers.empty() && routes.empty());
+    stopTimer();
+}
+
+void DebuggerHub::addDebugger(ValueTreeDebuggerMain& main)
+{
+    debuggers.push_back(&main);
+}
+
+void DebuggerHub::removeDebugger(ValueTreeDebuggerMain& main)
+{
+    setTickInterval(main, 0);
+    debuggers.erase(std::remove(debuggers.begin(), debuggers.end(), &main), debuggers.end());
+}
+
+void DebuggerHub::listenTo(juce::ValueTree& tree, ValueTreeDebuggerMain& main)
+{
+    // A redirected tree comes back with another object, so its old route goes by debugger
+    for (auto it = routes.begin(); it != routes.end();)
+        it = it->second == &main ? routes.erase(it) : std::next(it);
+
+    jassert(routes.find(tree) == routes.end());
+    routes[tree] = &main;
+    tree.addListener(this);
+}
+
+void DebuggerHub::stopListening(juce::ValueTree& tree, ValueTreeDebuggerMain& main)
+{
+    tree.removeListener(this);
+
+    for (auto it = routes.begin(); it != routes.end();)
+        it = it->second == &main ? routes.erase(it) : std::next(it);
+}
+
+ValueTreeDebuggerMain* DebuggerHub::findDebugger(const juce::ValueTree& changedTree) const
+{
+    // Every change comes from a tree listened to, so with one there is nothing to look up
+    if (routes.size() == 1)
+        return routes.begin()->second;
+
+    for (auto node = changedTree; node.isValid(); node = node.getParent())
+        if (const auto it = routes.find(node); it != routes.end())
+            return it->second;
+
+    return nullptr;
+}
+
+void DebuggerHub::valueTreePropertyChanged(juce::ValueTree& changedTree, const juce::Identifier& property)
+{
+    if (auto* main = findDebugger(changedTree))
+        main->valueTreePropertyChanged(changedTree, property);
+}
+
+void DebuggerHub::valueTreeChildAdded(juce::ValueTree& parentTree, juce::ValueTree& childWhichHasBeenAdded)
+{
+    if (auto* main = findDebugger(parentTree))
+        main->valueTreeChildAdded(parentTree, childWhichHasBeenAdded);
+}
+
+void DebuggerHub::valueTreeChildRemoved(juce::ValueTree& parentTree, juce::ValueTree& childWhichHasBeenRemoved, int indexFromWhichChildWasRemoved)
+{
+    if (auto* main = findDebugger(parentTree))
+        main->valueTreeChildRemoved(parentTree, childWhichHasBeenRemoved, indexFromWhichChildWasRemoved);
+}
+
+void DebuggerHub::valueTreeChildOrderChanged(juce::ValueTree& parentTreeWhoseChildrenHaveMoved, int oldIndex, int newIndex)
+{
+    if (auto* main = findDebugger(parentTreeWhoseChildrenHaveMoved))
+        main->valueTreeChildOrderChanged(parentTreeWhoseChildrenHaveMoved, oldIndex, newIndex);
+}
+
+void DebuggerHub::valueTreeRedirected(juce::ValueTree& treeWhichHasBeenChanged)
+{
+    // The handle is the one a debugger was given, its object is already the new one
+    for (auto* main : debuggers)
+    {
+        if (main->tree == &treeWhichHasBeenChanged)
+        {
+            main->valueTreeRedirected(treeWhichHasBeenChanged);
+            return;
+        }
+    }
+}
+
+void DebuggerHub::setTickInterval(ValueTreeDebuggerMain& main, int intervalMs)
+{
+    const auto it = std::find_if(ticking.begin(), ticking.end(), [&](const Ticking& t) { return t.main == &main; });
+
+    if (intervalMs <= 0)
+    {
+        if (it == ticking.end()) return;
+        ticking.erase(it);
+    }
+    else if (it == ticking.end())
+    {
+        ticking.push_back({ &main, intervalMs, Time::getMillisecondCounterHiRes() + intervalMs });
+    }
+    else
+    {
+        if (it->intervalMs == intervalMs) return;
+        *it = { &main, intervalMs, Time::getMillisecondCounterHiRes() + intervalMs };
+    }
+
+    updateTimer();
+}
+
+void DebuggerHub::setOverheadBudget(double msPerFrame, double frameMs)
+{
+    governor.setBudget(msPerFrame, frameMs);
+
+    for (auto* main : debuggers)
+        main->updateStatus();
+}
+
+void DebuggerHub::timerCallback()
+{
+    // A tick may change what is ticking, so the debuggers due are picked first
+    const auto nowMs = Time::getMillisecondCounterHiRes();
+    std::vector<ValueTreeDebuggerMain*> due;
+    for (auto& t : ticking)
+    {
+        if (t.dueMs <= nowMs)
+        {
+            t.dueMs = nowMs + t.intervalMs;
+            due.push_back(t.main);
+        }
+    }
+
+    for (auto* main : due)
+        main->tick();
+}
+
+void DebuggerHub::updateTimer()
+{
+    // At the shortest interval asked for, the others are ticked when they are due
+    int intervalMs{ 0 };
+    for (const auto& t : ticking)
+        intervalMs = intervalMs == 0 ? t.intervalMs : jmin(intervalMs, t.intervalMs);
+
+    if (intervalMs == 0)
+        stopTimer();
+    else if (getTimerInterval() != intervalMs)
+        startTimer(intervalMs);
+}
+
+// ============================================================================
+
+ValueTreeDebuggerMain::ValueTreeDebuggerMain(juce::UndoManager* undoManager, DebuggerHub* sharedHub) :
+    ownHub(sharedHub == nullptr ? std::make_unique<DebuggerHub>() : nullptr),
+    hub(sharedHub != nullptr ? *sharedHub : *ownHub),
+    governor(hub.getGovernor()),
+    um(undoManager)
+{
+    hub.addDebugger(*this);
+    itemContext.um = um;
+    itemContext.viewPool = &hub.getViewPool();
+    itemContext.history = &history;
+    itemContext.diff = &diff;
+    itemContext.freeze = &freeze;
+    itemContext.exclusions = &exclusions;
+    model.isSubtreeExcluded = [&](const juce::ValueTree& subtree) { return exclusions.isExcludedRoot(subtree); };
+    diff.onChanged = [&](const std::vector<FlatTreeModel::NodeId>& nodes)
+    {
+        updateStatus();
+
+        for (auto id : nodes)
+        {
+            // While frozen the views pick up the differences when they are unfrozen
+            if (updatesPaused)
+                freeze.nodeChanged(id);
+            else if (auto* item = itemContext.findItem(id))
+                item->diffChanged();
+        }
+    };
+    watchpoints.onPauseRequested = [&](const juce::String&) { setUpdatesPaused(true); };
+    sampler.onSampledChange = [&](juce::ValueTree& changedTree, const juce::Identifier& property) { handlePropertyChange(changedTree, property); };
+    sampler.onModeChanged = [&]() { updateStatus(); };
+    itemContext.governor = &governor;
+
+    treeView.setDefaultOpenness(true);
+    treeView.setColour(TreeView::ColourIds::backgroundColourId, widgetBackgroundColour);
+
+    setSize(800, 600);
+
+    toolbarViewport.setViewedComponent(&toolbar, false);
+    toolbarViewport.setScrollBarsShown(true, false);
+    addAndMakeVisible(toolbarViewport);
+    addAndMakeVisible(treeView);
+    addChildComponent(buildProgressBar);
+
+    statsView.setMultiLine(true, false);
+    statsView.setReadOnly(true);
+    statsView.setScrollbarsShown(true);
+    statsView.setFont(theFontSmall());
+    addChildComponent(statsView);
+
+    setupToolbar();
+    updateExclusionButtons();
+}
+
+ValueTreeDebuggerMain::~ValueTreeDebuggerMain()
+{
+    if (tree != nullptr) hub.stopListening(*tree, *this);
+    hub.removeDebugger(*this);
+    timeTravelWindow.reset();
+    stress.stop();
+    treeView.setRootItem(nullptr);
+}
+
+void ValueTreeDebuggerMain::resized()
+{
+    auto bounds = getLocalBounds();
+    auto toolbarRect = bounds.removeFromLeft(toolbarWidth);
+    toolbarViewport.setBounds(toolbarRect);
+    const auto width = toolbarRect.getWidth() - toolbarViewport.getScrollBarThickness();
+    toolbar.setSize(width, toolbar.getIdealHeight(width));
+
+    if (buildProgressBar.isVisible())
+        buildProgressBar.setBounds(bounds.removeFromBottom(rowHeight));
+
+    if (statsView.isVisible())
+        statsView.setBounds(bounds.removeFromBottom(bounds.getHeight() / 3));
+
+    treeView.setBounds(bounds);
+}
+
+bool ValueTreeDebuggerMain::keyPressed(const juce::KeyPress& key)
+{
+    // Focused text editors take these first
+    if (key == KeyPress{ 'c', ModifierKeys::commandModifier, 0 })
+    {
+        copySelection();
+        return true;
+    }
+
+    if (key == KeyPress{ 'v', ModifierKeys::commandModifier, 0 })
+    {
+        pasteIntoSelection();
+        return true;
+    }
+
+    return false;
+}
+
+void ValueTreeDebuggerMain::valueTreePropertyChanged(juce::ValueTree& changedTree, const juce::Identifier& property)
+{
+    // Before anything else, so excluded changes cost only this
+    if (exclusions.isExcludedProperty(property) || isExcluded(changedTree)) return;
+
+    OverheadGovernor::ScopedMeasurement measurement{ governor };
+
+    // Changes in sampled subtrees are only counted, the sampler finds them when it polls
+    if (sampler.isActive() && sampler.eventArrived(changedTree)) return;
+
+    handlePropertyChange(changedTree, property);
+}
+
+void ValueTreeDebuggerMain::handlePropertyChange(juce::ValueTree& changedTree, const juce::Identifier& property)
+{
+    // The sampler finds changes by polling, which sees excluded properties too
+    if (exclusions.isExcludedProperty(property)) return;
+
+    OverheadGovernor::ScopedMeasurement measurement{ governor };
+    TraceExporter::ScopedCallback traceCallback{ trace, "vtdbg::propertyChanged" };
+    watchpoints.propertyChanged(changedTree, property);
+
+    // The value the view shows while frozen is the one the model has before it takes the change
+    if (updatesPaused)
+    {
+        const auto frozenNode = model.findNode(changedTree);
+        if (frozenNode != FlatTreeModel::none)
+            freeze.propertyChanging(model, frozenNode, property);
+    }
+
+    const auto node = model.propertyChanged(changedTree, property);
+    if (node == FlatTreeModel::none) return;
+
+    const auto level = governor.getLevel();
+    if (level == OverheadGovernor::Level::structureOnly)
+        diffStale = true;
+    else
+        modelChanged();
+
+    trace.propertyChanged(model.getNodeId(node), model.getType(node), property, changedTree[property]);
+    if (!replay.isApplying())
+        recorder.propertyChanged(model, node, property);
+    timeTravel.propertyChanged(model, node, property);
+    sessionStats.propertyChanged(model, node, property, changedTree[property]);
+    if (level != OverheadGovernor::Level::structureOnly)
+        history.propertyChanged(model.getNodeId(node), property, changedTree[property]);
+    if (updatesPaused) return;
+
+    if (deferringItemUpdates || level != OverheadGovernor::Level::full)
+    {
+        deferredItems.insert(model.getNodeId(node));
+        return;
+    }
+
+    if (auto* item = itemContext.findItem(model.getNodeId(node)))
+        item->propertyChanged(property);
+}
+
+void ValueTreeDebuggerMain::valueTreeChildAdded(juce::ValueTree& parentTree, juce::ValueTree& childWhichHasBeenAdded)
+{
+    if (isExcluded(parentTree)) return;
+
+    OverheadGovernor::ScopedMeasurement measurement{ governor };
+    TraceExporter::ScopedCallback traceCallback{ trace, "vtdbg::childAdded" };
+    watchpoints.structureChanged(parentTree);
+
+    // Either undo manager may be putting back a subtree it removed, which keeps its ids
+    const auto* appUndoManager = sessionStats.getUndoManager();
+    const auto undoingOrRedoing = (um != nullptr && um->isPerformingUndoRedo())
+                               || (appUndoManager != nullptr && appUndoManager->isPerformingUndoRedo());
+    const auto child = model.childAdded(parentTree, childWhichHasBeenAdded, undoingOrRedoing);
+    if (child == FlatTreeModel::none) return;
+
+    modelChanged();
+    if (sampler.isActive())
+        sampler.nodeAdded(child);
+    const auto node = model.getParent(child);
+    const auto index = parentTree.indexOf(childWhichHasBeenAdded);
+    trace.structureChanged("addChild", model.getNodeId(node), model.getType(node), index);
+    if (!replay.isApplying())
+        recorder.childAdded(model, child, index);
+    timeTravel.childAdded(model, child, index);
+    sessionStats.childAdded(model, node);
+    dispatchChildrenChanged(node);
+}
+
+void ValueTreeDebuggerMain::valueTreeChildRemoved(juce::ValueTree& parentTree, juce::ValueTree& childWhichHasBeenRemoved, int indexFromWhichChildWasRemoved)
+{
+    if (isExcluded(parentTree)) return;
+
+    OverheadGovernor::ScopedMeasurement measurement{ governor };
+    TraceExporter::ScopedCallback traceCallback{ trace, "vtdbg::childRemoved" };
+    watchpoints.structureChanged(parentTree);
+
+    // The sampler and the history need the removed nodes, which are gone once the model is updated
+    if (sampler.isActive() || !history.isEmpty())
+    {
+        if (const auto removed = model.findNode(childWhichHasBeenRemoved); removed != FlatTreeModel::none)
+        {
+            if (sampler.isActive())
+                sampler.nodeRemoved(removed);
+            if (!history.isEmpty())
+                forgetHistory(removed);
+        }
+    }
+
+    const auto node = model.childRemoved(parentTree, indexFromWhichChildWasRemoved);
+    if (node == FlatTreeModel::none) return;
+
+    modelChanged();
+    trace.structureChanged("removeChild", model.getNodeId(node), model.getType(node), indexFromWhichChildWasRemoved);
+    if (!replay.isApplying())
+        recorder.childRemoved(model, node, indexFromWhichChildWasRemoved);
+    timeTravel.childRemoved(model, node, indexFromWhichChildWasRemoved);
+    sessionStats.childRemoved(model, node);
+    dispatchChildrenChanged(node);
+}
+
+void ValueTreeDebuggerMain::valueTreeChildOrderChanged(juce::ValueTree& parentTreeWhoseChildrenHaveMoved, int oldIndex, int newIndex)
+{
+    if (isExcluded(parentTreeWhoseChildrenHaveMoved)) return;
+
+    OverheadGovernor::ScopedMeasurement measurement{ governor };
+    TraceExporter::ScopedCallback traceCallback{ trace, "vtdbg::childOrderChanged" };
+    watchpoints.structureChanged(parentTreeWhoseChildrenHaveMoved);
+
+    const auto node = model.childOrderChanged(parentTreeWhoseChildrenHaveMoved, oldIndex, newIndex);
+    if (node == FlatTreeModel::none) return;
+
+    modelChanged();
+    trace.structureChanged("moveChild", model.getNodeId(node), model.getType(node), newIndex);
+    if (!replay.isApplying())
+        recorder.childMoved(model, node, oldIndex, newIndex);
+    timeTravel.childMoved(model, node, oldIndex, newIndex);
+    sessionStats.childMoved(model, node);
+    dispatchChildrenChanged(node);
+}
+
+void ValueTreeDebuggerMain::dispatchChildrenChanged(int node)
+{
+    if (node == FlatTreeModel::none) return;
+
+    if (updatesPaused)
+    {
+        freeze.childrenChanged(model.getNodeId(node));
+        return;
+    }
+
+    if (auto* item = itemContext.findItem(model.getNodeId(node)))
+        item->childrenChanged();
+
+    if (rootItem != nullptr)
+        rootItem->treeHasChanged();
+}
+
+void ValueTreeDebuggerMain::valueTreeRedirected(juce::ValueTree& treeWhichHasBeenChanged)
+{
+    // The address of the value tree does not change, just the shared object the value tree is referencing
+    jassert(tree == &treeWhichHasBeenChanged);
+
+    // Every node is new, so closed items are matched by their path and type instead
+    itemContext.keepOpennessByPath();
+    setTree(&treeWhichHasBeenChanged);
+}
+
+void ValueTreeDebuggerMain::setTree(juce::ValueTree* newTree)
+{
+    modelChanged();
+    // Node ids don't survive a rebuild
+    sampler.clear();
+    if (tree != newTree)
+    {
+        sessionStats.reset();
+        timeTravel.reset();
+    }
+    treeView.setRootItem(nullptr);
+    rootItem.reset();
+
+    if (tree != newTree)
+        itemContext.clearOpenness();
+
+    if (tree != nullptr && tree != newTree)
+        hub.stopListening(*tree, *this);
+
+    tree = newTree;
+
+    if (newTree == nullptr)
+    {
+        exclusions.setRoot({});
+        model.clear();
+        buildProgressBar.setVisible(false);
+        updateTimer();
+        return;
+    }
+
+    // All changes reach the debugger through the hub's one listener
+    hub.listenTo(*tree, *this);
+
+    // The rules kept for trees of this type, a broken file leaves them empty
+    if (exclusionsRootType != tree->getType())
+    {
+        exclusionsRootType = tree->getType();
+        exclusions.load(ExclusionFilter::getDefaultFile(exclusionsRootType));
+        updateExclusionButtons();
+    }
+
+    exclusions.setRoot(*tree);
+
+    // Large trees would block the message thread, so the model and items are built a slice
+    // per timer tick, breadth first. The first slice shows the top levels straight away.
+    model.beginRebuild(*tree);
+
+    rootItem = std::make_unique<Item>(*tree, model.getNodeId(model.getRoot()), itemContext);
+    treeView.setRootItem(rootItem.get());
+
+    // What was kept for the old nodes is no use, the new root gets its children on unfreezing
+    if (updatesPaused)
+    {
+        freeze.clear();
+        freeze.childrenChanged(rootItem->nodeId);
+    }
+
+    buildSlice(buildSliceMs);
+}
+
+void ValueTreeDebuggerMain::buildSlice(double maxMs)
+{
+    modelChanged();
+
+    Array<int> expandedNodes;
+    const auto building = model.buildStep(Time::getMillisecondCounterHiRes() + maxMs, expandedNodes);
+
+    if (sampler.isActive())
+        for (auto node : expandedNodes)
+            for (int i = 0; i < model.getNumChildren(node); ++i)
+                sampler.nodeAdded(model.getChild(node, i));
+
+    // While frozen the items of the expanded nodes are updated on unfreezing
+    if (updatesPaused)
+    {
+        for (auto node : expandedNodes)
+            freeze.childrenChanged(model.getNodeId(node));
+    }
+    else if (rootItem != nullptr)
+    {
+        for (auto node : expandedNodes)
+            if (auto* item = itemContext.findItem(model.getNodeId(node)))
+                item->childrenAppended();
+
+        rootItem->treeHasChanged();
+    }
+
+    if (building)
+    {
+        buildProgressBar.setTextToDisplay("Building view, " + String{ model.getNumNodes() } + " nodes so far");
+    }
+    else
+    {
+        // Keyframes need every node mirrored, so the history starts once the model is complete
+        timeTravel.treeRebuilt(model);
+        updateStatus();
+    }
+
+    if (buildProgressBar.isVisible() != building)
+    {
+        buildProgressBar.setVisible(building);
+        resized();
+    }
+
+    updateTimer();
+}
+
+void ValueTreeDebuggerMain::finishBuilding()
+{
+    if (model.isBuilding())
+        buildSlice(std::numeric_limits<double>::infinity());
+}
+
+void ValueTreeDebuggerMain::setUpdatesPaused(bool shouldBePaused)
+{
+    if (updatesPaused == shouldBePaused) return;
+
+    updatesPaused = shouldBePaused;
+
+    if (updatesPaused)
+    {
+        // The lists of the nodes shown are kept now, values as they change
+        std::vector<FlatTreeModel::NodeId> shownNodes;
+        shownNodes.reserve(itemContext.items.size());
+        for (const auto& entry : itemContext.items)
+            shownNodes.push_back(entry.first);
+
+        freeze.freeze(model, shownNodes);
+        updateFreezeButton();
+        updateTimer();
+        return;
+    }
+
+    // Only the items of nodes which changed while frozen are refreshed, the structure first
+    // as it may replace items whose properties changed too
+    const auto structureChanged = freeze.getStructureChangedNodes();
+    for (auto id : freeze.getChangedNodes())
+        deferredItems.insert(id);
+
+    freeze.unfreeze();
+
+    for (auto id : structureChanged)
+        if (auto* item = itemContext.findItem(id))
+            item->childrenChanged();
+
+    // Items opened while frozen whose children weren't kept get them now
+    for (auto id : itemContext.withheldSubItems)
+        if (auto* item = itemContext.findItem(id))
+            if (item->getNumSubItems() == 0)
+                item->childrenChanged();
+
+    itemContext.withheldSubItems.clear();
+
+    flushDeferredItems();
+    if (rootItem != nullptr)
+        rootItem->treeHasChanged();
+
+    updateFreezeButton();
+    updateTimer();
+}
+
+void ValueTreeDebuggerMain::updateFreezeButton()
+{
+    if (!updatesPaused)
+    {
+        toolbar.butFreeze.setButtonText(ButtonText::freeze);
+        return;
+    }
+
+    toolbar.butFreeze.setButtonText(ButtonText::unfreeze + " (" + String{ freeze.getNumPending() } + " pending)");
+}
+
+juce::Result ValueTreeDebuggerMain::startTrace(const juce::File& file, bool includeCallbackDurations, std::function<double()> clockMicroseconds)
+{
+    const auto result = trace.start(file, includeCallbackDurations, std::move(clockMicroseconds));
+    if (result.wasOk())
+        toolbar.butTrace.setButtonText(ButtonText::stopTrace);
+
+    return result;
+}
+
+void ValueTreeDebuggerMain::stopTrace()
+{
+    trace.stop();
+    toolbar.butTrace.setButtonText(ButtonText::startTrace);
+}
+
+void ValueTreeDebuggerMain::startRecording()
+{
+    // The initial state needs the ids of every node
+    finishBuilding();
+    recorder.start(model);
+    toolbar.butRecord.setButtonText(ButtonText::stopRecording);
+}
+
+juce::ValueTree ValueTreeDebuggerMain::stopRecording()
+{
+    toolbar.butRecord.setButtonText(ButtonText::startRecording);
+    return recorder.stop();
+}
+
+juce::Result ValueTreeDebuggerMain::loadReplay(const juce::ValueTree& changeLog)
+{
+    // Only read here, the tree is reset when the replay is started
+    auto result = replay.load(changeLog);
+    if (result.wasOk() && tree != nullptr)
+        replay.setTarget(*tree, um);
+
+    actionStatus = result.wasOk() ? String{ replay.getNumOperations() } + " changes loaded to replay" : result.getErrorMessage();
+    updateReplayButtons();
+    updateStatus();
+    return result;
+}
+
+void ValueTreeDebuggerMain::confirmReplay(std::function<void()> startReplay)
+{
+    if (replay.hasStarted())
+    {
+        startReplay();
+        return;
+    }
+
+    auto options = MessageBoxOptions::makeOkCancel(MessageBoxIconType::WarningIcon, "Replay changes",
+                                                   "The tree is replaced by the state the log was recorded from, then the changes are applied to it."
+                                                   + String{ um != nullptr ? " It can be undone." : " It can't be undone." },
+                                                   "Replace the tree", "Cancel", this);
+    AlertWindow::showAsync(options,
+                           [safeThis = Component::SafePointer<ValueTreeDebuggerMain>{ this }, startReplay](int result)
+                           {
+                               if (safeThis == nullptr || result != 1) return;
+
+                               startReplay();
+                               safeThis->updateReplayButtons();
+                           });
+}
+
+void ValueTreeDebuggerMain::updateReplayButtons()
+{
+    const auto loaded = replay.isLoaded();
+    toolbar.butPlayReplay.setEnabled(loaded);
+    toolbar.butStepReplay.setEnabled(loaded);
+    toolbar.butPlayReplay.setButtonText(replay.isPlaying() ? ButtonText::pause : ButtonText::play);
+    toolbar.butStepReplay.setButtonText(ButtonText::step + " (" + String{ replay.getPosition() } + "/" + String{ replay.getNumOperations() } + ")");
+}
+
+void ValueTreeDebuggerMain::startStress(const StressGenerator::Profile& profile, bool useUndoManager)
+{
+    if (tree == nullptr) return;
+
+    // Stress the selected subtree, or the whole tree
+    auto target = *tree;
+    if (auto* selectedItem = dynamic_cast<Item*>(treeView.getSelectedItem(0)))
+        target = selectedItem->tree;
+
+    stress.start(target, profile, useUndoManager ? um : nullptr);
+    toolbar.butStress.setButtonText(ButtonText::stopStress);
+    updateTimer();
+}
+
+void ValueTreeDebuggerMain::stopStress()
+{
+    stress.stop();
+    toolbar.butStress.setButtonText(ButtonText::startStress);
+    updateStatus();
+}
+
+void ValueTreeDebuggerMain::setScrubRate(int writesPerSecond)
+{
+    // Used by property views created from now on
+    itemContext.scrubRateHz = jmax(1, writesPerSecond);
+}
+
+void ValueTreeDebuggerMain::forgetHistory(int removedNode)
+{
+    Array<FlatTreeModel::NodeId> freedNodes;
+    history.subtreeRemoved(model, removedNode, freedNodes);
+
+    // While frozen the items of removed nodes stay shown, their rows mustn't keep the freed buffers
+    for (auto id : freedNodes)
+        if (auto* item = itemContext.findItem(id))
+            if (item->comp != nullptr)
+                item->comp->createPropertyComponents();
+}
+
+void ValueTreeDebuggerMain::setHistoryTracked(const juce::ValueTree& node, const juce::Identifier& property, bool shouldTrack)
+{
+    const auto found = model.findNode(node);
+    if (found == FlatTreeModel::none) return;
+
+    const auto id = model.getNodeId(found);
+    if (shouldTrack)
+    {
+        history.watch(id, property);
+
+        // Start from the current value rather than an empty line
+        if (auto* buffer = history.find(id, property); buffer != nullptr && buffer->size() == 0)
+            history.propertyChanged(id, property, node[property]);
+    }
+    else
+    {
+        history.unwatch(id, property);
+    }
+
+    // Property views hold on to the buffer, so recreate them
+    if (auto* item = itemContext.findItem(id))
+        if (item->comp != nullptr)
+            item->comp->createPropertyComponents();
+}
+
+void ValueTreeDebuggerMain::setBaseline(const juce::ValueTree& baselineTree)
+{
+    diff.setBaseline(baselineTree);
+    updateStatus();
+}
+
+juce::Result ValueTreeDebuggerMain::loadBaseline(const juce::File& file)
+{
+    ValueTree baselineTree;
+
+    if (file.hasFileExtension("xml"))
+    {
+        if (auto xml = parseXML(file))
+            baselineTree = ValueTree::fromXml(*xml);
+    }
+    else
+    {
+        FileInputStream stream{ file };
+        if (!stream.openedOk())
+            return Result::fail("Can't open " + file.getFullPathName());
+
+        baselineTree = ValueTree::readFromStream(stream);
+    }
+
+    if (!baselineTree.isValid())
+        return Result::fail("No value tree in " + file.getFullPathName());
+
+    setBaseline(baselineTree);
+    return Result::ok();
+}
+
+void ValueTreeDebuggerMain::clearBaseline()
+{
+    diff.clearBaseline();
+    updateStatus();
+}
+
+juce::Result ValueTreeDebuggerMain::selectMatching(const juce::String& queryText)
+{
+    auto result = Result::ok();
+    const auto query = TreeQuery::compile(queryText, result);
+    if (result.failed()) return result;
+
+    // Matches can be anywhere, including where the build hasn't reached yet
+    finishBuilding();
+    const auto matches = query.evaluate(model);
+
+    queryMatches.clear();
+    for (auto node : matches.nodes)
+        queryMatches.push_back(model.getNodeId(node));
+
+    actionStatus = String{ (int)queryMatches.size() } + " matches in " + String{ matches.evaluationMs, 2 } + " ms, "
+                + String{ matches.nodesTested } + " nodes tested";
+    updateStatus();
+
+    // Items not created yet are selected when they are
+    treeView.clearSelectedItems();
+    itemContext.selectedNodes.clear();
+    itemContext.selectedNodes.insert(queryMatches.begin(), queryMatches.end());
+
+    for (auto id : queryMatches)
+        if (auto* item = itemContext.findItem(id))
+            item->setSelected(true, false, dontSendNotification);
+
+    if (!queryMatches.empty())
+        revealNode(queryMatches.front());
+
+    return result;
+}
+
+void ValueTreeDebuggerMain::revealNode(FlatTreeModel::NodeId id)
+{
+    const auto node = model.findNode(id);
+    if (node == FlatTreeModel::none) return;
+
+    // Opening an item creates the items of the next level, so open from the top down
+    std::vector<FlatTreeModel::NodeId> ancestors;
+    for (auto parent = model.getParent(node); parent != FlatTreeModel::none; parent = model.getParent(parent))
+        ancestors.push_back(model.getNodeId(parent));
+
+    for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it)
+        if (auto* item = itemContext.findItem(*it))
+            item->setOpen(true);
+
+    if (auto* item = itemContext.findItem(id))
+        treeView.scrollToKeepItemVisible(item);
+}
+
+void ValueTreeDebuggerMain::copySelection()
+{
+    Array<ValueTree> trees;
+    for (int i = 0; i < treeView.getNumSelectedItems(); ++i)
+        if (auto* item = dynamic_cast<Item*>(treeView.getSelectedItem(i)))
+            trees.add(item->tree);
+
+    if (!trees.isEmpty())
+        clipboard->copy(trees);
+}
+
+void ValueTreeDebuggerMain::pasteIntoSelection()
+{
+    if (itemContext.readOnly) return;
+
+    auto* selectedItem = dynamic_cast<Item*>(treeView.getSelectedItem(0));
+    if (selectedItem == nullptr) return;
+
+    const auto trees = clipboard->paste();
+    if (trees.isEmpty()) return;
+
+    // Each subtree is built detached, so adding it is one structural change however large it is
+    if (um) um->beginNewTransaction();
+    for (const auto& subtree : trees)
+        selectedItem->tree.addChild(subtree, -1, um);
+
+    if (um) um->beginNewTransaction();
+}
+
+void ValueTreeDebuggerMain::flushDeferredItems()
+{
+    // One refresh of each changed item, then one of the tree view if an item changed height
+    bool heightsChanged{ false };
+    for (auto id : deferredItems)
+        if (auto* item = itemContext.findItem(id))
+            heightsChanged = item->syncProperties() || heightsChanged;
+
+    deferredItems.clear();
+    if (heightsChanged && rootItem != nullptr)
+        rootItem->treeHasChanged();
+}
+
+juce::Result ValueTreeDebuggerMain::exportSessionStats(const juce::File& file)
+{
+    const auto result = sessionStats.exportTo(file);
+    actionStatus = result.wasOk() ? "Session stats of " + String{ sessionStats.getNumEvents() } + " changes saved to " + file.getFileName()
+                                  : result.getErrorMessage();
+    updateStatus();
+    return result;
+}
+
+void ValueTreeDebuggerMain::setReadOnly(bool shouldBeReadOnly)
+{
+    itemContext.readOnly = shouldBeReadOnly;
+
+    // A read only debugger shows a tree made by another, such as the time travel view, whose history it doesn't need
+    if (shouldBeReadOnly)
+        timeTravel.setRetention(0.0, 0);
+
+    for (auto* control : std::initializer_list<Component*>{
+             &toolbar.butAddNode, &toolbar.entryToAdd, &toolbar.comboPropType, &toolbar.entryNewValue, &toolbar.butAddProp,
+             &toolbar.butPaste, &toolbar.butDelNode, &toolbar.butDelProp, &toolbar.butRenameProp, &toolbar.butUndo, &toolbar.butRedo,
+             &toolbar.butTimeTravel, &toolbar.butExcludeSubtree, &toolbar.butExcludeType,
+             &toolbar.butExcludeProperty, &toolbar.butClearExclusions, &toolbar.butLoadReplay, &toolbar.butPlayReplay, &toolbar.butStepReplay, &toolbar.butStress })
+        control->setEnabled(!shouldBeReadOnly);
+}
+
+void ValueTreeDebuggerMain::setTimeTravelRetention(double seconds, juce::int64 maxBytes)
+{
+    timeTravel.setRetention(seconds, maxBytes);
+
+    // A history starting now needs a keyframe of the tree as it is
+    if (timeTravel.isEnabled() && !timeTravel.hasHistory())
+        timeTravel.treeRebuilt(model);
+}
+
+void ValueTreeDebuggerMain::showTimeTravel()
+{
+    if (itemContext.readOnly) return;
+
+    finishBuilding();
+
+    // Nothing is kept until asked for, the history starts when first opened
+    if (!timeTravel.isEnabled())
+        setTimeTravelRetention(TimeTravel::defaultRetentionSeconds, TimeTravel::defaultRetentionBytes);
+
+    if (timeTravelWindow == nullptr)
+        timeTravelWindow = std::make_unique<TimeTravelWindow>(timeTravel);
+
+    timeTravelWindow->setVisible(true);
+    timeTravelWindow->toFront(true);
+}
+
+void ValueTreeDebuggerMain::excludeType(const juce::Identifier& type)
+{
+    exclusions.excludeType(type);
+    updateExclusions();
+}
+
+void ValueTreeDebuggerMain::excludeSubtree(const juce::ValueTree& subtree)
+{
+    exclusions.excludeSubtree(subtree);
+    updateExclusions();
+}
+
+void ValueTreeDebuggerMain::excludeProperty(const juce::Identifier& property)
+{
+    exclusions.excludeProperty(property);
+    updateExclusions();
+}
+
+void ValueTreeDebuggerMain::clearExclusions()
+{
+    exclusions.clear();
+    updateExclusions();
+}
+
+void ValueTreeDebuggerMain::updateExclusions()
+{
+    // The history view shows the rules of the debugger it belongs to without saving them
+    if (!itemContext.readOnly && exclusionsRootType.isValid())
+    {
+        const auto result = exclusions.save(ExclusionFilter::getDefaultFile(exclusionsRootType));
+        actionStatus = result.wasOk() ? String{ exclusions.getNumRules() } + " exclusion rules" : result.getErrorMessage();
+
+        // Without an identifying property a subtree is kept by position, which a reorder breaks
+        if (const auto numPositional = exclusions.getNumPositionalRules(); result.wasOk() && numPositional > 0)
+            actionStatus << ", " << numPositional << " kept by position";
+    }
+
+    updateExclusionButtons();
+
+    // The model mirrors excluded subtrees without their children, so it is built again
+    if (tree != nullptr)
+    {
+        itemContext.keepOpennessByPath();
+        setTree(tree);
+    }
+
+    updateStatus();
+}
+
+bool ValueTreeDebuggerMain::isExcluded(const juce::ValueTree& changedTree) const
+{
+    if (!exclusions.hasSubtreeRules()) return false;
+
+    const auto node = model.findNode(changedTree);
+    if (node != FlatTreeModel::none)
+        return model.isExcluded(node);
+
+    // Only nodes inside excluded subtrees aren't mirrored, unless the build hasn't reached them yet
+    return !model.isBuilding() || exclusions.isInExcludedSubtree(changedTree);
+}
+
+void ValueTreeDebuggerMain::updateExclusionButtons()
+{
+    toolbar.butClearExclusions.setButtonText(ButtonText::clearExclusions + " (" + String{ exclusions.getNumRules() } + ")");
+    toolbar.butClearExclusions.setTooltip(exclusions.describe());
+}
+
+void ValueTreeDebuggerMain::setOverheadBudget(double msPerFrame, double frameMs)
+{
+    hub.setOverheadBudget(msPerFrame, frameMs);
+}
+
+void ValueTreeDebuggerMain::governorLevelChanged(OverheadGovernor::Level previous)
+{
+    using Level = OverheadGovernor::Level;
+    const auto level = governor.getLevel();
+
+    // Stepping back up shows what was held back
+    if (previous == Level::structureOnly && diffStale)
+    {
+        diffStale = false;
+        diff.liveChanged();
+    }
+
+    if (level == Level::full && !deferringItemUpdates)
+        flushDeferredItems();
+
+    updateStatus();
+}
+
+void ValueTreeDebuggerMain::governorFlushed()
+{
+    if (governor.getLevel() == OverheadGovernor::Level::coalesced && !deferringItemUpdates && !updatesPaused)
+        flushDeferredItems();
+}
+
+void ValueTreeDebuggerMain::setAdaptiveSampling(const juce::ValueTree& subtree, bool shouldSample)
+{
+    finishBuilding();
+
+    if (shouldSample)
+        sampler.addSubtree(subtree);
+    else
+        sampler.removeSubtree(subtree);
+
+    updateStatus();
+}
+
+int ValueTreeDebuggerMain::setPropertyOfSelection(const juce::Identifier& name, const juce::var& value)
+{
+    return editTrees(getSelectedTrees(), "Set " + name.toString(), [&](ValueTree& node)
+    {
+        node.setProperty(name, value, um);
+        return true;
+    });
+}
+
+int ValueTreeDebuggerMain::removePropertyOfSelection(const juce::Identifier& name)
+{
+    return editTrees(getSelectedTrees(), "Deleted " + name.toString(), [&](ValueTree& node)
+    {
+        if (!node.hasProperty(name)) return false;
+
+        node.removeProperty(name, um);
+        return true;
+    });
+}
+
+int ValueTreeDebuggerMain::renamePropertyOfSelection(const juce::Identifier& oldName, const juce::Identifier& newName)
+{
+    if (oldName == newName) return 0;
+
+    return editTrees(getSelectedTrees(), "Renamed " + oldName.toString() + " to " + newName.toString(), [&](ValueTree& node)
+    {
+        if (!node.hasProperty(oldName)) return false;
+
+        // Value trees can't rename, the renamed property moves to the end
+        const auto value = node[oldName];
+        node.setProperty(newName, value, um);
+        node.removeProperty(oldName, um);
+        return true;
+    });
+}
+
+juce::Array<juce::ValueTree> ValueTreeDebuggerMain::getSelectedTrees()
+{
+    finishBuilding();
+
+    Array<ValueTree> trees;
+    for (auto id : itemContext.selectedNodes)
+    {
+        const auto node = model.findNode(id);
+        if (node != FlatTreeModel::none)
+            trees.add(model.getTree(node));
+    }
+
+    return trees;
+}
+
+int ValueTreeDebuggerMain::editTrees(const juce::Array<juce::ValueTree>& trees, const juce::String& description, const std::function<bool(juce::ValueTree&)>& edit)
+{
+    if (trees.isEmpty() || itemContext.readOnly) return 0;
+
+    const auto startTicks = Time::getHighResolutionTicks();
+    deferringItemUpdates = true;
+    if (um) um->beginNewTransaction(description);
+
+    int numEdited{ 0 };
+    for (auto tree : trees)
+        if (edit(tree))
+            ++numEdited;
+
+    if (um) um->beginNewTransaction();
+    deferringItemUpdates = false;
+
+    flushDeferredItems();
+
+    actionStatus = description + " on " + String{ numEdited } + " nodes in " + String{ Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks) * 1000.0, 1 } + " ms";
+    updateStatus();
+    return numEdited;
+}
+
+void ValueTreeDebuggerMain::showStats()
+{
+    if (model.isBuilding())
+    {
+        statsView.setText("Waiting for the view to finish building");
+    }
+    else
+    {
+        // Stats of the selected subtree, or the whole tree
+        auto subtreeRoot = model.getRoot();
+        if (auto* selectedItem = dynamic_cast<Item*>(treeView.getSelectedItem(0)))
+            subtreeRoot = model.findNode(selectedItem->nodeId);
+
+        statsView.setText("Computing...");
+        statsCollector.start(model, subtreeRoot, [&, generation = model.getGeneration()](const SubtreeStats& stats)
+        {
+            auto text = stats.getDescription();
+            if (model.getGeneration() != generation)
+                text << "\n\nThe tree has changed since these were computed, show them again to update them";
+
+            statsView.setText(text);
+        });
+    }
+
+    toolbar.butStats.setButtonText(ButtonText::hideStats);
+    statsView.setVisible(true);
+    resized();
+}
+
+void ValueTreeDebuggerMain::hideStats()
+{
+    statsCollector.cancel();
+    toolbar.butStats.setButtonText(ButtonText::showStats);
+    statsView.setVisible(false);
+    resized();
+}
+
+void ValueTreeDebuggerMain::modelChanged()
+{
+    diff.liveChanged();
+}
+
+void ValueTreeDebuggerMain::tick()
+{
+    if (model.isBuilding())
+    {
+        buildSlice(buildSliceMs);
+        return;
+    }
+
+    updateStatus();
+    updateFreezeButton();
+    updateTimer();
+}
+
+void ValueTreeDebuggerMain::updateTimer()
+{
+    // Building takes priority, the stress statistics are shown once it is done
+    if (model.isBuilding())
+        hub.setTickInterval(*this, buildIntervalMs);
+    else if (stress.isRunning() || updatesPaused)
+        hub.setTickInterval(*this, 250);
+    else
+        hub.setTickInterval(*this, 0);
+}
+
+void ValueTreeDebuggerMain::updateStatus()
+{
+    String status;
+    status << model.getNumNodes() << " nodes";
+
+    if (stress.isRunning() || stress.getStats().mutations > 0)
+        status << newLine << stress.getStatsDescription();
+
+    if (governor.isEnabled())
+    {
+        status << newLine << "Budget " << String{ governor.getBudgetMs(), 2 } << " ms per " << String{ governor.getFrameMs(), 0 } << " ms frame: " << OverheadGovernor::getLevelName(governor.getLevel());
+        if (governor.getLevel() != OverheadGovernor::Level::full)
+            status << ", the view may lag";
+    }
+
+    if (sampler.isActive())
+        status << newLine << sampler.getSubtrees().size() << " adaptive subtrees, " << sampler.getNumSampling() << " sampled every " << sampler.getSampleIntervalMs() << " ms";
+
+    if (actionStatus.isNotEmpty())
+        status << newLine << actionStatus;
+
+    if (diff.hasBaseline())
+        status << newLine << diff.getNumDifferences() << " nodes differ from the baseline, compared in " << String{ diff.getLastUpdateMs(), 2 } << " ms";
+
+    toolbar.lblStatus.setText(status, NotificationType::dontSendNotification);
+}
+
+void ValueTreeDebuggerMain::updateWatchButtons()
+{
+    StringArray descriptions;
+    for (int i = 0; i < watchpoints.size(); ++i)
+        descriptions.add(watchpoints.getDescription(i));
+
+    toolbar.butClearWatches.setButtonText(ButtonText::clearWatches + " (" + String{ watchpoints.size() } + ")");
+    toolbar.butClearWatches.setTooltip(descriptions.joinIntoString("\n"));
+}
+
+void ValueTreeDebuggerMain::setupToolbar()
+{
+    // The listener passes the changes of an undo or redo on to the items they touch
+    toolbar.butUndo.onClick = [&]()
+    {
+        if (um) um->undo();
+    };
+    toolbar.butRedo.onClick = [&]()
+    {
+        if (um) um->redo();
+    };
+    toolbar.butAddProp.onClick = [&]()
+    {
+        if (!itemContext.selectedNodes.empty())
+        {
             using ComboVarType::comboTypeIndex;
             auto newName = toolbar.entryToAdd.getText();
-            auto newTypeIndex = static_cast<comboTypeIndex>(toolbar.comboPropType.getSelectedId());
-            auto newValText = toolbar.entryNewValue.getText();
+            auto newTypeIndex = static_cast<comboTypeIndex>(toolbar.comboPropType.getSelectedId());
+            auto newValText = toolbar.entryNewValue.getText();
+
+            if (Identifier::isValidIdentifier(newName))
+            {
+                var newVal;
+
+                switch (newTypeIndex)
+                {
+                case 0:
+                    // Nothing selected
+                    break;
+
+                case comboTypeIndex::Void:
+                    break;
+                    
+                case comboTypeIndex::Undefined:
+                    newVal = var::undefined();
+                    break;
+                    
+                case comboTypeIndex::Int:
+                    newVal = newValText.getIntValue();
+                    break;
+                    
+                case comboTypeIndex::Int64:
+                    newVal = newValText.getLargeIntValue();
+                    break;
+                    
+                case comboTypeIndex::Bool:
+                    newVal = getBoolValue(newValText);
+                    break;
+                    
+                case comboTypeIndex::Double:
+                    newVal = newValText.getDoubleValue();
+                    break;
+                    
+                case comboTypeIndex::String:
+                    newVal = newValText;
+                    break;
+                    
+                case comboTypeIndex::Object:
+                    // Not implemented
+                    jassertfalse;
+                    break;
+                    
+                case comboTypeIndex::Array:
+                    // Not implemented
+                    jassertfalse;
+                    break;
+                    
+                case comboTypeIndex::BinaryData:
+                    // Not implemented
+                    jassertfalse;
+                    break;
+                    
+                case comboTypeIndex::Method:
+                    // Not implemented
+                    jassertfalse;
+                    break;
+
+                default:
+                    jassertfalse;
+                    break;
+
+                };
+
+                setPropertyOfSelection(newName, newVal);
+            }
+        }
+    };
+    toolbar.butAddNode.onClick = [&]()
+    {
+        if (auto* selectedItem = dynamic_cast<Item*>(treeView.getSelectedItem(0)))
+        {
+            auto newName = toolbar.entryToAdd.getText();
+            if (Identifier::isValidIdentifier(newName))
+            {
+                selectedItem->tree.addChild(ValueTree{ newName }, -1, um);
+                if (um) um->beginNewTransaction();
+                selectedItem->treeHasChanged();
+            }
+        }
+    };
+    toolbar.butCopy.onClick = [&]() { copySelection(); };
+    toolbar.butPaste.onClick = [&]() { pasteIntoSelection(); };
+    toolbar.butDelNode.onClick = [&]()
+    {
+        const auto numSelected = treeView.getNumSelectedItems();
+        for (int i = 0; i < numSelected; ++i)
+        {
+            if (auto* item = dynamic_cast<vtdbg::Item*>(treeView.getSelectedItem(i)))
+            {
+                auto parent = item->tree.getParent();
+                if (parent.isValid())
+                {
+                    parent.removeChild(item->tree, um);
+                    if (um) um->beginNewTransaction();
+                }
+            }
+        }
+    };
+    toolbar.butAddWatch.onClick = [&]()
+    {
+        // Watch the selected subtree, or the whole tree
+        ValueTree scope;
+        if (auto* selectedItem = dynamic_cast<Item*>(treeView.getSelectedItem(0)))
+            if (selectedItem != rootItem.get())
+                scope = selectedItem->tree;
+
+        const auto action = static_cast<Watchpoints::Action>(jmax(0, toolbar.comboWatchAction.getSelectedItemIndex()));
+        const auto result = watchpoints.add(toolbar.entryWatch.getText(), action, scope);
+
+        const auto colour = result.wasOk() ? outlineColour : errorColour;
+        toolbar.entryWatch.setColour(TextEditor::ColourIds::outlineColourId, colour);
+        toolbar.entryWatch.setColour(TextEditor::ColourIds::focusedOutlineColourId, colour);
+        toolbar.entryWatch.setTooltip(result.getErrorMessage());
+
+        updateWatchButtons();
+    };
+    toolbar.butClearWatches.onClick = [&]()
+    {
+        watchpoints.clear();
+        updateWatchButtons();
+    };
+    toolbar.butFreeze.onClick = [&]()
+    {
+        setUpdatesPaused(!updatesPaused);
+    };
+    toolbar.butAdaptiveSampling.onClick = [&]()
+    {
+        for (const auto& selected : getSelectedTrees())
+            setAdaptiveSampling(selected, !sampler.containsSubtree(selected));
+    };
+    toolbar.butTrace.onClick = [&]()
+    {
+        if (trace.isRunning())
+        {
+            stopTrace();
+            return;
+        }
+
+        const auto defaultFile = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("valuetree.trace.json");
+        fileChooser = std::make_unique<FileChooser>("Save trace", defaultFile, "*.json");
+        fileChooser->launchAsync(
+            FileBrowserComponent::saveMode | FileBrowserComponent::canSelectFiles | FileBrowserComponent::warnAboutOverwriting,
+            [&](const FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (file != File{})
+                    startTrace(file, true);
+            }
+        );
+    };
+    toolbar.butRecord.onClick = [&]()
+    {
+        if (!recorder.isRecording())
+        {
+            startRecording();
+            return;
+        }
+
+        auto changeLog = stopRecording();
+        const auto defaultFile = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("valuetree.vtlog");
+        fileChooser = std::make_unique<FileChooser>("Save recorded changes", defaultFile, "*.vtlog");
+        fileChooser->launchAsync(
+            FileBrowserComponent::saveMode | FileBrowserComponent::canSelectFiles | FileBrowserComponent::warnAboutOverwriting,
+            [changeLog](const FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (file == File{}) return;
+
+                // Binary keeps the types of the recorded values
+                file.deleteFile();
+                FileOutputStream stream{ file };
+                if (stream.openedOk())
+                    changeLog.writeToStream(stream);
+            }
+        );
+    };
+    toolbar.butExportSession.onClick = [&]()
+    {
+        const auto defaultFile = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("valuetree.session.json");
+        fileChooser = std::make_unique<FileChooser>("Export session stats", defaultFile, "*.json;*.csv");
+        fileChooser->launchAsync(
+            FileBrowserComponent::saveMode | FileBrowserComponent::canSelectFiles | FileBrowserComponent::warnAboutOverwriting,
+            [&](const FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (file == File{}) return;
+
+                exportSessionStats(file);
+            }
+        );
+    };
+    toolbar.butTimeTravel.onClick = [&]() { showTimeTravel(); };
+    toolbar.butExcludeSubtree.onClick = [&]()
+    {
+        for (const auto& selected : getSelectedTrees())
+            exclusions.excludeSubtree(selected);
+
+        updateExclusions();
+    };
+    toolbar.butExcludeType.onClick = [&]()
+    {
+        for (const auto& selected : getSelectedTrees())
+            exclusions.excludeType(selected.getType());
+
+        updateExclusions();
+    };
+    toolbar.butExcludeProperty.onClick = [&]()
+    {
+        if (!selectedProperty.selected) return;
+
+        excludeProperty(selectedProperty.propertyName);
+    };
+    toolbar.butClearExclusions.onClick = [&]() { clearExclusions(); };
+    toolbar.butLoadReplay.onClick = [&]()
+    {
+        fileChooser = std::make_unique<FileChooser>("Load recorded changes", File::getSpecialLocation(File::userDocumentsDirectory), "*.vtlog");
+        fileChooser->launchAsync(
+            FileBrowserComponent::openMode | FileBrowserComponent::canSelectFiles,
+            [&](const FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (file == File{}) return;
+
+                FileInputStream stream{ file };
+                if (stream.openedOk())
+                    loadReplay(ValueTree::readFromStream(stream));
+            }
+        );
+    };
+    toolbar.butPlayReplay.onClick = [&]()
+    {
+        if (replay.isPlaying())
+            replay.pause();
+        else
+            confirmReplay([&]() { replay.play(); });
+
+        updateReplayButtons();
+    };
+    toolbar.butStepReplay.onClick = [&]()
+    {
+        replay.pause();
+        confirmReplay([&]() { replay.step(); });
+        updateReplayButtons();
+    };
+    toolbar.comboBudget.onChange = [&]()
+    {
+        static const double budgets[]{ 0.0, 0.25, 0.5, 1.0, 2.0 };
+        const auto index = jlimit(0, 4, toolbar.comboBudget.getSelectedItemIndex());
+        setOverheadBudget(budgets[index]);
+    };
+    toolbar.comboReplaySpeed.onChange = [&]()
+    {
+        static const double speeds[]{ 1.0, 2.0, 10.0, 0.0 };
+        const auto index = jlimit(0, 3, toolbar.comboReplaySpeed.getSelectedItemIndex());
+        replay.setSpeed(speeds[index]);
+    };
+    replay.onStateChanged = [&]() { updateReplayButtons(); };
+    toolbar.butStress.onClick = [&]()
+    {
+        if (stress.isRunning())
+        {
+            stopStress();
+            return;
+        }
+
+        StressGenerator::Profile profile;
+        switch (toolbar.comboStressProfile.getSelectedItemIndex())
+        {
+        case 1:
+            profile.rate = 10000.0;
+            profile.numProperties = 500;
+            break;
+
+        case 2:
+            profile.type = StressGenerator::Profile::Type::childBursts;
+            profile.rate = 10.0;
+            profile.burstSize = 100;
+            break;
+
+        default:
+            break;
+        }
+
+        startStress(profile, toolbar.toggleStressUndo.getToggleState());
+    };
+    updateReplayButtons();
+
+    toolbar.butTrackHistory.onClick = [&]()
+    {
+        if (!selectedProperty.selected) return;
+
+        const auto node = model.findNode(selectedProperty.tree);
+        if (node == FlatTreeModel::none) return;
+
+        const auto tracked = history.isWatched(model.getNodeId(node), selectedProperty.propertyName);
+        setHistoryTracked(selectedProperty.tree, selectedProperty.propertyName, !tracked);
+    };
+    toolbar.butStats.onClick = [&]()
+    {
+        if (statsView.isVisible())
+            hideStats();
+        else
+            showStats();
+    };
+    toolbar.butLoadBaseline.onClick = [&]()
+    {
+        fileChooser = std::make_unique<FileChooser>("Load baseline", File::getSpecialLocation(File::userDocumentsDirectory), "*.xml;*.bin;*.vtree");
+        fileChooser->launchAsync(
+            FileBrowserComponent::openMode | FileBrowserComponent::canSelectFiles,
+            [&](const FileChooser& chooser)
+            {
+                const auto file = chooser.getResult();
+                if (file == File{}) return;
+
+                const auto result = loadBaseline(file);
+                toolbar.butLoadBaseline.setTooltip(result.wasOk() ? file.getFullPathName() : result.getErrorMessage());
+            }
+        );
+    };
+    toolbar.butClearBaseline.onClick = [&]()
+    {
+        clearBaseline();
+    };
+    toolbar.butFind.onClick = [&]()
+    {
+        const auto result = selectMatching(toolbar.entryQuery.getText());
+
+        const auto colour = result.wasOk() ? outlineColour : errorColour;
+        toolbar.entryQuery.setColour(TextEditor::ColourIds::outlineColourId, colour);
+        toolbar.entryQuery.setColour(TextEditor::ColourIds::focusedOutlineColourId, colour);
+        toolbar.entryQuery.setTooltip(result.getErrorMessage());
+    };
+    toolbar.entryQuery.onReturnKey = [&]() { toolbar.butFind.triggerClick(); };
+    toolbar.butDelProp.onClick = [&]()
+    {
+        if (!selectedProperty.selected) return;
+
+        // The node of the selected property, and every selected node with a property of that name
+        auto trees = getSelectedTrees();
+        trees.addIfNotAlreadyThere(selectedProperty.tree);
+
+        const auto name = selectedProperty.propertyName;
+        editTrees(trees, "Deleted " + name.toString(), [&](ValueTree& node)
+        {
+            if (!node.hasProperty(name)) return false;
+
+            node.removeProperty(name, um);
+            return true;
+        });
+    };
+    toolbar.butRenameProp.onClick = [&]()
+    {
+        const auto newName = toolbar.entryToAdd.getText();
+        if (!selectedProperty.selected || !Identifier::isValidIdentifier(newName)) return;
+
+        const auto oldName = selectedProperty.propertyName;
+        selectedProperty.deselect();
+        renamePropertyOfSelection(oldName, newName);
+    };
+}
+
+// ============================================================================
+
+TimeTravelView::TimeTravelView(TimeTravel& timeTravelToBrowse) :
+    timeTravel(timeTravelToBrowse)
+{
+    main.setReadOnly(true);
+
+    slider.setColour(Slider::ColourIds::backgroundColourId, widgetBackgroundColour);
+    slider.onValueChange = [&]()
+    {
+        // Back at the end, the view follows the live tree again
+        followingLive = slider.getValue() >= slider.getMaximum();
+        seek();
+    };
+
+    lblTime.setFont(theFontSmall());
+    lblTime.setColour(Label::ColourIds::textColourId, hintTextColour);
+    lblTime.setJustificationType(Justification::centredRight);
+
+    addAndMakeVisible(slider);
+    addAndMakeVisible(lblTime);
+    addAndMakeVisible(main);
+
+    resetTarget();
+    setSize(800, 600);
+    startTimerHz(4);
+}
+
+TimeTravelView::~TimeTravelView()
+{
+    stopTimer();
+    main.setTree(nullptr);
+}
+
+void TimeTravelView::resized()
+{
+    auto bounds = getLocalBounds();
+    auto header = bounds.removeFromTop(rowHeight).reduced(padding, 0);
+    lblTime.setBounds(header.removeFromRight(header.getWidth() / 3));
+    slider.setBounds(header);
+    main.setBounds(bounds);
+}
+
+void TimeTravelView::timerCallback()
+{
+    if (!isShowing()) return;
+
+    // A history reset for another tree has no type until its first keyframe
+    if (timeTravel.getRootType().isValid() && timeTravel.getRootType() != historyTree.getType())
+    {
+        resetTarget();
+        return;
+    }
+
+    const auto start = timeTravel.getStartSeconds();
+    const auto end = jmax(timeTravel.getEndSeconds(), start + 0.001);
+    if (start != slider.getMinimum() || end != slider.getMaximum())
+    {
+        slider.setRange(start, end, 0.0);
+        slider.setValue(followingLive ? end : jlimit(start, end, slider.getValue()), dontSendNotification);
+        seek();
+    }
+}
+
+void TimeTravelView::seek()
+{
+    if (!timeTravel.hasHistory()) return;
+
+    timeTravel.seek(historyTree, slider.getValue());
+    updateLabel();
+}
+
+void TimeTravelView::resetTarget()
+{
+    main.setTree(nullptr);
+    historyTree = ValueTree{ timeTravel.getRootType().isValid() ? timeTravel.getRootType() : Identifier{ "NoHistory" } };
+    followingLive = true;
+
+    slider.setRange(timeTravel.getStartSeconds(), jmax(timeTravel.getEndSeconds(), timeTravel.getStartSeconds() + 0.001), 0.0);
+    slider.setValue(slider.getMaximum(), dontSendNotification);
+
+    // The first seek fills the tree, the debugger then mirrors it once
+    if (timeTravel.hasHistory())
+        timeTravel.seek(historyTree, slider.getValue());
+
+    main.setTree(&historyTree);
+    updateLabel();
+}
+
+void TimeTravelView::updateLabel()
+{
+    if (!timeTravel.hasHistory())
+    {
+        lblTime.setText("No history yet", dontSendNotification);
+        return;
+    }
+
+    String text;
+    text << String{ slider.getValue(), 1 } << " s" << (followingLive ? " (live)" : "") << ", "
+         << timeTravel.getNumKeyframes() << " keyframes, " << timeTravel.getNumDeltas() << " changes, "
+         << File::descriptionOfSizeInBytes(timeTravel.getNumBytes()) << ", seek " << String{ timeTravel.getLastSeekMs(), 2 } << " ms";
+    lblTime.setText(text, dontSendNotification);
+}
+
+// ============================================================================
+
+TimeTravelWindow::TimeTravelWindow(TimeTravel& timeTravelToBrowse) :
+    DocumentWindow(
+        "Value Tree Debugger - Time travel",
+        juce::Colours::transparentBlack,
+        DocumentWindow::allButtons
+    ),
+    view(timeTravelToBrowse)
+{
+    setLookAndFeel(lnf);
+    setBackgroundColour(lnf->getCurrentColourScheme().getUIColour(LookAndFeel_V4::ColourScheme::windowBackground));
+    setContentNonOwned(&view, true);
+    setResizable(true, false);
+    setResizeLimits(200, 100, 1920, 1080);
+    setUsingNativeTitleBar(true);
+    centreWithSize(getWidth(), getHeight());
+}
+
+TimeTravelWindow::~TimeTravelWindow()
+{
+    clearContentComponent();
+    setLookAndFeel(nullptr);
+}
+
+void TimeTravelWindow::closeButtonPressed()
+{
+    setVisible(false);
+}
+
+// ============================================================================
+
+SourcesView::SourcesView(juce::UndoManager* undoManager)
+{
+    tabs.onTabChanged = [&](int index)
+    {
+        if (!updatingTabs)
+            showSource(index);
+    };
+    addChildComponent(tabs);
 
-            if (Identifier::isValidIdentifier(newName))
-            {
-                var newVal;
+    sources.push_back({ {}, createMain(undoManager) });
+    addAndMakeVisible(getShown());
+    setSize(getShown().getWidth(), getShown().getHeight());
+}
 
-                switch (newTypeIndex)
-                {
-                case 0:
-                    // Nothing selected
-                    break;
+SourcesView::~SourcesView()
+{
+    for (auto& source : sources)
+        source.main->setTree(nullptr);
+}
 
-                case comboTypeIndex::Void:
-                    break;
-                    
-                case comboTypeIndex::Undefined:
-                    newVal = var::undefined();
-                    break;
-                    
-                case comboTypeIndex::Int:
-                    newVal = newValText.getIntValue();
-                    break;
-                    
-                case comboTypeIndex::Int64:
-                    newVal = newValText.getIntValue();
-                    break;
-                    
-                case comboTypeIndex::Bool:
-                    newVal = getBoolValue(newValText);
-                    break;
-                    
-                case comboTypeIndex::Double:
-                    newVal = newValText.getDoubleValue();
-                    break;
-                    
-                case comboTypeIndex::String:
-                    newVal = newValText;
-                    break;
-                    
-                case comboTypeIndex::Object:
-                    // Not implemented
-                    jassertfalse;
-                    break;
-                    
-                case comboTypeIndex::Array:
-                    // Not implemented
-                    jassertfalse;
-                    break;
-                    
-                case comboTypeIndex::BinaryData:
-                    // Not implemented
-                    jassertfalse;
-                    break;
-                    
-                case comboTypeIndex::Method:
-                    // Not implemented
-                    jassertfalse;
-                    break;
+void SourcesView::resized()
+{
+    auto bounds = getLocalBounds();
 
-                default:
-                    jassertfalse;
-                    break;
+    if (tabs.isVisible())
+        tabs.setBounds(bounds.removeFromTop(rowHeight + padding));
 
-                };
+    getShown().setBounds(bounds);
+}
 
-                selectedItem->tree.setProperty(newName, newVal, um);
-                if (um) um->beginNewTransaction();
-                selectedItem->comp->createPropertyComponents();
-                selectedItem->treeHasChanged();
-            }
-        }
-    };
-    toolbar.butAddNode.onClick = [&]()
+void SourcesView::addSource(const juce::String& name, juce::ValueTree& sourceTree, juce::UndoManager* undoManager)
+{
+    auto main = createMain(undoManager);
+    main->setTree(&sourceTree);
+
+    if (sources.size() == 1 && sources.front().name.isEmpty() && !sources.front().main->hasTree())
     {
-        if (auto* selectedItem = dynamic_cast<Item*>(treeView.getSelectedItem(0)))
-        {
-            auto newName = toolbar.entryToAdd.getText();
-            if (Identifier::isValidIdentifier(newName))
-            {
-                selectedItem->tree.addChild(ValueTree{ newName }, -1, um);
-                if (um) um->beginNewTransaction();
-                selectedItem->treeHasChanged();
-            }
-        }
-    };
-    toolbar.butDelNode.onClick = [&]()
+        sources.front() = { name, std::move(main) };
+        addAndMakeVisible(getShown());
+    }
+    else
     {
-        const auto numSelected = treeView.getNumSelectedItems();
-        for (int i = 0; i < numSelected; ++i)
-        {
-            if (auto* item = dynamic_cast<vtdbg::Item*>(treeView.getSelectedItem(i)))
-            {
-                auto parent = item->tree.getParent();
-                if (parent.isValid())
-                {
-                    parent.removeChild(item->tree, um);
-                    if (um) um->beginNewTransaction();
-                }
-            }
-        }
-    };
-    toolbar.butDelProp.onClick = [&]()
+        // Follows its tree from now on, but makes no rows until shown
+        addChildComponent(*main);
+        sources.push_back({ name, std::move(main) });
+    }
+
+    updateTabs();
+    resized();
+}
+
+void SourcesView::removeSource(int index)
+{
+    if (!juce::isPositiveAndBelow(index, (int)sources.size())) return;
+
+    sources[(size_t)index].main->setTree(nullptr);
+
+    // The window always shows a debugger, the last one is only emptied
+    if (sources.size() == 1)
     {
-        selectedProperty.tree.removeProperty(selectedProperty.propertyName, um);
-        if (um) um->beginNewTransaction();
-        
-        const auto itemIdString = getItemIdString(selectedProperty.tree);
+        sources.front().name = {};
+        updateTabs();
+        return;
+    }
 
-        if (auto* treeItem = treeView.findItemFromIdentifierString(itemIdString))
-        {
-            if (auto* item = dynamic_cast<Item*>(treeItem))
-            {
-                item->comp->createPropertyComponents();
-                treeView.getSelectedItem(0)->treeHasChanged();
-            }
-        }
-    };
+    const auto wasShown = index == shown;
+    sources.erase(sources.begin() + index);
+
+    if (shown > index)
+        --shown;
+    shown = juce::jmin(shown, (int)sources.size() - 1);
+
+    if (wasShown)
+        getShown().setVisible(true);
+
+    updateTabs();
+    resized();
+}
+
+void SourcesView::showSource(int index)
+{
+    if (index == shown || !juce::isPositiveAndBelow(index, (int)sources.size())) return;
+
+    // Without bounds the tree view of the hidden source hands its rows back to the pool
+    getShown().setVisible(false);
+    getShown().setBounds({});
+
+    shown = index;
+    tabs.setCurrentTabIndex(index, false);
+    getShown().setVisible(true);
+    resized();
+}
+
+int SourcesView::findSource(const juce::String& name) const
+{
+    for (size_t i = 0; i < sources.size(); ++i)
+        if (sources[i].name == name)
+            return (int)i;
+
+    return -1;
+}
+
+ValueTreeDebuggerMain* SourcesView::getSource(const juce::String& name)
+{
+    const auto index = findSource(name);
+    return index >= 0 ? sources[(size_t)index].main.get() : nullptr;
+}
+
+void SourcesView::setScrubRate(int writesPerSecond)
+{
+    scrubRate = writesPerSecond;
+
+    for (auto& source : sources)
+        source.main->setScrubRate(scrubRate);
+}
+
+std::unique_ptr<ValueTreeDebuggerMain> SourcesView::createMain(juce::UndoManager* undoManager)
+{
+    auto main = std::make_unique<ValueTreeDebuggerMain>(undoManager, &hub);
+    if (scrubRate > 0)
+        main->setScrubRate(scrubRate);
+
+    return main;
+}
+
+void SourcesView::updateTabs()
+{
+    const juce::ScopedValueSetter<bool> updating{ updatingTabs, true };
+
+    tabs.clearTabs();
+    for (const auto& source : sources)
+        tabs.addTab(source.name.isNotEmpty() ? source.name : "Source", widgetBackgroundColour, -1);
+    tabs.setCurrentTabIndex(shown, false);
+
+    // A single tree needs no tabs
+    tabs.setVisible(sources.size() > 1);
 }
 
 // ============================================================================
@@ -1073,7 +3939,7 @@ ValueTreeDebugger::ValueTreeDebugger() :
 {
     setLookAndFeel(lnf);
     setBackgroundColour(lnf->getCurrentColourScheme().getUIColour(LookAndFeel_V4::ColourScheme::windowBackground));
-    main = std::make_unique<vtdbg::ValueTreeDebuggerMain>(nullptr);
+    sources = std::make_unique<vtdbg::SourcesView>(nullptr);
     construct();
 }
 
@@ -1086,7 +3952,7 @@ ValueTreeDebugger::ValueTreeDebugger(juce::ValueTree& tree, juce::UndoManager* u
 {
     setLookAndFeel(lnf);
     setBackgroundColour(lnf->getCurrentColourScheme().getUIColour(LookAndFeel_V4::ColourScheme::windowBackground));
-    main = std::make_unique<vtdbg::ValueTreeDebuggerMain>(undoManager);
+    sources = std::make_unique<vtdbg::SourcesView>(undoManager);
     construct();
     setSource(tree);
 }
@@ -1094,7 +3960,6 @@ ValueTreeDebugger::ValueTreeDebugger(juce::ValueTree& tree, juce::UndoManager* u
 ValueTreeDebugger::~ValueTreeDebugger()
 {
     setLookAndFeel(nullptr);
-    main->setTree(nullptr);
 }
 
 void ValueTreeDebugger::closeButtonPressed()
@@ -1104,12 +3969,192 @@ void ValueTreeDebugger::closeButtonPressed()
 
 void ValueTreeDebugger::setSource(juce::ValueTree& v)
 {
-    main->setTree(&v);
+    sources->getPrimary().setTree(&v);
+}
+
+void ValueTreeDebugger::addSource(const juce::String& name, juce::ValueTree& tree, juce::UndoManager* undoManager)
+{
+    sources->addSource(name, tree, undoManager);
+}
+
+void ValueTreeDebugger::removeSource(const juce::String& name)
+{
+    sources->removeSource(sources->findSource(name));
+}
+
+void ValueTreeDebugger::showSource(const juce::String& name)
+{
+    sources->showSource(sources->findSource(name));
+}
+
+ValueTreeDebuggerMain* ValueTreeDebugger::getSourceDebugger(const juce::String& name)
+{
+    return sources->getSource(name);
+}
+
+Watchpoints& ValueTreeDebugger::getWatchpoints()
+{
+    return sources->getPrimary().getWatchpoints();
+}
+
+juce::Result ValueTreeDebugger::startTrace(const juce::File& file, bool includeCallbackDurations, std::function<double()> clockMicroseconds)
+{
+    return sources->getPrimary().startTrace(file, includeCallbackDurations, std::move(clockMicroseconds));
+}
+
+void ValueTreeDebugger::stopTrace()
+{
+    sources->getPrimary().stopTrace();
+}
+
+void ValueTreeDebugger::startRecording()
+{
+    sources->getPrimary().startRecording();
+}
+
+juce::ValueTree ValueTreeDebugger::stopRecording()
+{
+    return sources->getPrimary().stopRecording();
+}
+
+ReplayEngine& ValueTreeDebugger::getReplay()
+{
+    return sources->getPrimary().getReplay();
+}
+
+void ValueTreeDebugger::startStress(const StressGenerator::Profile& profile, bool useUndoManager)
+{
+    sources->getPrimary().startStress(profile, useUndoManager);
+}
+
+void ValueTreeDebugger::stopStress()
+{
+    sources->getPrimary().stopStress();
+}
+
+const StressGenerator::Stats& ValueTreeDebugger::getStressStats() const
+{
+    return sources->getPrimary().getStressStats();
+}
+
+void ValueTreeDebugger::setScrubRate(int writesPerSecond)
+{
+    sources->setScrubRate(writesPerSecond);
+}
+
+void ValueTreeDebugger::setHistoryTracked(const juce::ValueTree& node, const juce::Identifier& property, bool shouldTrack)
+{
+    sources->getPrimary().setHistoryTracked(node, property, shouldTrack);
+}
+
+ValueHistory& ValueTreeDebugger::getHistory()
+{
+    return sources->getPrimary().getHistory();
+}
+
+void ValueTreeDebugger::setBaseline(const juce::ValueTree& baselineTree)
+{
+    sources->getPrimary().setBaseline(baselineTree);
+}
+
+void ValueTreeDebugger::clearBaseline()
+{
+    sources->getPrimary().clearBaseline();
+}
+
+const TreeDiff& ValueTreeDebugger::getDiff() const
+{
+    return sources->getPrimary().getDiff();
+}
+
+juce::Result ValueTreeDebugger::selectMatching(const juce::String& query)
+{
+    return sources->getPrimary().selectMatching(query);
+}
+
+void ValueTreeDebugger::setAdaptiveSampling(const juce::ValueTree& subtree, bool shouldSample)
+{
+    sources->getPrimary().setAdaptiveSampling(subtree, shouldSample);
+}
+
+void ValueTreeDebugger::setAdaptiveSamplingThreshold(double eventsPerSecond)
+{
+    sources->getPrimary().getSampler().setThreshold(eventsPerSecond);
+}
+
+const SessionStats& ValueTreeDebugger::getSessionStats() const
+{
+    return sources->getPrimary().getSessionStats();
+}
+
+void ValueTreeDebugger::resetSessionStats()
+{
+    sources->getPrimary().resetSessionStats();
+}
+
+void ValueTreeDebugger::setSessionUndoManager(const juce::UndoManager* appUndoManager)
+{
+    sources->getPrimary().setSessionUndoManager(appUndoManager);
+}
+
+juce::Result ValueTreeDebugger::exportSessionStats(const juce::File& file)
+{
+    return sources->getPrimary().exportSessionStats(file);
+}
+
+void ValueTreeDebugger::setOverheadBudget(double msPerFrame, double frameMs)
+{
+    sources->getHub().setOverheadBudget(msPerFrame, frameMs);
+}
+
+void ValueTreeDebugger::setTimeTravelRetention(double seconds, double megabytes)
+{
+    sources->getPrimary().setTimeTravelRetention(seconds, (juce::int64)(megabytes * 1024.0 * 1024.0));
+}
+
+void ValueTreeDebugger::showTimeTravel()
+{
+    sources->getPrimary().showTimeTravel();
+}
+
+void ValueTreeDebugger::excludeType(const juce::Identifier& type)
+{
+    sources->getPrimary().excludeType(type);
+}
+
+void ValueTreeDebugger::excludeSubtree(const juce::ValueTree& subtree)
+{
+    sources->getPrimary().excludeSubtree(subtree);
+}
+
+void ValueTreeDebugger::excludeProperty(const juce::Identifier& property)
+{
+    sources->getPrimary().excludeProperty(property);
+}
+
+void ValueTreeDebugger::clearExclusions()
+{
+    sources->getPrimary().clearExclusions();
+}
+
+int ValueTreeDebugger::setPropertyOfSelection(const juce::Identifier& name, const juce::var& value)
+{
+    return sources->getPrimary().setPropertyOfSelection(name, value);
+}
+
+int ValueTreeDebugger::removePropertyOfSelection(const juce::Identifier& name)
+{
+    return sources->getPrimary().removePropertyOfSelection(name);
+}
+
+int ValueTreeDebugger::renamePropertyOfSelection(const juce::Identifier& oldName, const juce::Identifier& newName)
+{
+    return sources->getPrimary().renamePropertyOfSelection(oldName, newName);
 }
 
 void ValueTreeDebugger::construct()
 {
-    setContentNonOwned(main.get(), true);
+    setContentNonOwned(sources.get(), true);
     setResizable(true, false);
     setResizeLimits(200, 100, 1920, 1080);
     setUsingNativeTitleBar(true);
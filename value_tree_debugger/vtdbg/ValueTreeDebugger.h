@@ -2,6 +2,26 @@
 
 #include <juce_gui_basics/juce_gui_basics.h>
 
+#include "AdaptiveSampler.h"
+#include "ChangeLog.h"
+#include "ExclusionFilter.h"
+#include "OverheadGovernor.h"
+#include "FlatTreeModel.h"
+#include "FreezeSnapshot.h"
+#include "SessionStats.h"
+#include "StressGenerator.h"
+#include "SubtreeClipboard.h"
+#include "SubtreeStats.h"
+#include "TextLineIndex.h"
+#include "TimeTravel.h"
+#include "TraceExporter.h"
+#include "TreeDiff.h"
+#include "TreeQuery.h"
+#include "ValueHistory.h"
+#include "Watchpoints.h"
+
+#include <unordered_set>
+
 namespace vtdbg
 {
 class ValueTreeDebuggerLookAndFeel : public juce::LookAndFeel_V4
@@ -67,6 +87,9 @@ public:
 
     void resized() override;
 
+    /* Height needed to show every control at the given width */
+    int getIdealHeight(int width);
+
     void textEditorTextChanged(juce::TextEditor& textEditor) override;
 
     juce::TextButton butAddNode;
@@ -75,29 +98,148 @@ public:
     juce::ComboBox comboPropType;
     juce::TextEditor entryNewValue;
     juce::TextButton butDelProp;
+    juce::TextButton butRenameProp;
     juce::TextButton butDelNode;
+    juce::TextButton butCopy;
+    juce::TextButton butPaste;
+    juce::TextButton butTrackHistory;
+    juce::TextButton butStats;
+    juce::TextButton butLoadBaseline;
+    juce::TextButton butClearBaseline;
+    juce::TextEditor entryQuery;
+    juce::TextButton butFind;
     juce::TextButton butUndo;
     juce::TextButton butRedo;
+    juce::TextEditor entryWatch;
+    juce::ComboBox comboWatchAction;
+    juce::TextButton butAddWatch;
+    juce::TextButton butClearWatches;
+    juce::TextButton butFreeze;
+    juce::TextButton butAdaptiveSampling;
+    juce::ComboBox comboBudget;
+    juce::TextButton butTrace;
+    juce::TextButton butRecord;
+    juce::TextButton butExportSession;
+    juce::TextButton butTimeTravel;
+    juce::TextButton butExcludeSubtree;
+    juce::TextButton butExcludeType;
+    juce::TextButton butExcludeProperty;
+    juce::TextButton butClearExclusions;
+    juce::TextButton butLoadReplay;
+    juce::ComboBox comboReplaySpeed;
+    juce::TextButton butPlayReplay;
+    juce::TextButton butStepReplay;
+    juce::ComboBox comboStressProfile;
+    juce::ToggleButton toggleStressUndo;
+    juce::TextButton butStress;
+    juce::Label lblStatus;
 
 private:
     void addButtonToToolbar(juce::Component& but);
 
     juce::FlexBox fb;
-    TextButtonLargeLookAndFeel largeTextLnf;
+    juce::SharedResourcePointer<TextButtonLargeLookAndFeel> largeTextLnf;
+};
+
+/* Draws only the visible lines of an indexed text, with line numbers */
+class LargeTextView :
+    public juce::Component,
+    private juce::ScrollBar::Listener
+{
+public:
+    LargeTextView();
+    ~LargeTextView() override;
+
+    /* The index must outlive the view, or be replaced first */
+    void setIndex(const TextLineIndex* indexToShow);
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void mouseWheelMove(const juce::MouseEvent& evt, const juce::MouseWheelDetails& wheel) override;
+
+private:
+    void scrollBarMoved(juce::ScrollBar* scrollBarThatHasMoved, double newRangeStart) override;
+    void updateScrollBars();
+
+    const TextLineIndex* index{ nullptr };
+    juce::ScrollBar verticalBar{ true };
+    juce::ScrollBar horizontalBar{ false };
+    juce::Font font;
+    float lineHeight{ 14.f };
+    float characterWidth{ 7.f };
+};
+
+/* Views a large string property, reading only the lines it shows. The text is copied into an
+   editor only when editing starts, and written to the tree only when the edit is applied. */
+class LargeTextPanel :
+    public juce::Component,
+    private juce::Timer
+{
+public:
+    LargeTextPanel(const juce::ValueTree& treeToShow, const juce::Identifier& nameOfProperty, juce::UndoManager* undoManager, bool isReadOnly);
+    ~LargeTextPanel() override;
+
+    void resized() override;
+
+    /* Open a panel for the property in a call out box pointing at the component */
+    static void show(const juce::ValueTree& treeToShow, const juce::Identifier& nameOfProperty, juce::UndoManager* undoManager, bool isReadOnly, juce::Component& pointAt);
+
+private:
+    /* Picks up a new value, a cheap check as the index keeps the text it was built from */
+    void timerCallback() override;
+    void reindex();
+    void setEditing(bool shouldEdit);
+    void apply();
+    void updateSummary();
+
+    juce::ValueTree tree;
+    juce::Identifier propertyName;
+    juce::UndoManager* um;
+    bool readOnly;
+
+    TextLineIndex index;
+    juce::Label lblSummary;
+    juce::TextButton butEdit{ "Edit" };
+    juce::TextButton butApply{ "Apply" };
+    juce::TextButton butCancel{ "Cancel" };
+    LargeTextView view;
+    juce::TextEditor editor;
+    bool editing{ false };
+    bool changedWhileEditing{ false };
 };
 
 /* Displays a var according to its type */
 class DynamicValueView :
     public juce::Component,
-    public juce::ValueTree::Listener,
-    public juce::Label::Listener
+    public juce::Label::Listener,
+    private juce::Timer
 {
 public:
-    DynamicValueView(const juce::ValueTree parentOfValue, const juce::Identifier nameOfProperty, juce::UndoManager* undoManager);
+    DynamicValueView(const juce::ValueTree parentOfValue, const juce::Identifier nameOfProperty, juce::UndoManager* undoManager, int scrubWritesPerSecond);
     ~DynamicValueView() override;
     void resized() override;
 
-    void valueTreePropertyChanged(juce::ValueTree& changedTree, const juce::Identifier& prop) override;
+    /* Dragging over the label of a numeric value scrubs it */
+    void mouseDown(const juce::MouseEvent& evt) override;
+    void mouseDrag(const juce::MouseEvent& evt) override;
+    void mouseUp(const juce::MouseEvent& evt) override;
+
+    /* Show the current value of the property */
+    void refresh();
+
+    /* Show another property, for views recycled by the ViewPool, which may belong to another source */
+    void bind(const juce::ValueTree& parentOfValue, const juce::Identifier& nameOfProperty, juce::UndoManager* undoManager, int scrubWritesPerSecond);
+    /* End a gesture and let go of the tree while the view waits in the pool */
+    void unbind();
+
+    /* Without editing the value is only shown, as in the time travel view */
+    void setEditable(bool shouldBeEditable);
+
+    /* Show this value instead of the tree's, nullptr to show the tree's again. Kept until the next bind. */
+    void setFrozenValue(const juce::var* frozenValueToShow);
+
+    /* The value shown, the frozen one while there is one */
+    juce::var value();
 
     void labelTextChanged(juce::Label* labelThatHasChanged) override;
 
@@ -105,6 +247,8 @@ public:
     juce::TextButton butPlus{ "+" };
     juce::TextButton butMinus{ "-" };
     juce::ToggleButton butToggle;
+    /* Strings which are long or have several lines show their size in the label and open in a LargeTextPanel */
+    juce::TextButton butOpenText{ "Open" };
 
 private:
     void setVisibility();
@@ -115,29 +259,67 @@ private:
     void resizedBool();
     void resizedDefault();
 
-    juce::var value();
     void setValue(const juce::var newValue);
+    bool isNumeric();
+
+    /* A gesture (a drag, or a run of clicks on the steppers) is one undo transaction,
+       and its writes to the tree are throttled to scrubRateHz */
+    void timerCallback() override;
+    void beginGesture();
+    void writeDuringGesture(const juce::var newValue);
+    void flushGesture();
+    void endGesture();
 
     juce::ValueTree tree;
     juce::Identifier propertyName;
     juce::UndoManager* um;
     juce::SharedResourcePointer<TextButtonSmallLookAndFeel> textButtonLnf;
+
+    int scrubRateHz;
+    bool scrubbing{ false };
+    bool gestureOpen{ false };
+    bool writePending{ false };
+    juce::var scrubStartValue;
+    juce::var pendingValue;
+    double lastStepTime{ 0.0 };
+    bool largeText{ false };
+    /* Of the large string shown, for its size and line count */
+    TextLineIndex largeTextIndex;
+    bool editable{ true };
+    bool frozen{ false };
+    juce::var frozenValue;
 };
 
 /* Displays a property name, type and value according to its type */
 class ValueTreePropertyView :
     public juce::Component,
-    public juce::ValueTree::Listener,
     public juce::ChangeListener
 {
 public:
-    ValueTreePropertyView(const juce::ValueTree parentOfProperty, const juce::Identifier nameOfProperty, juce::UndoManager* undoManager, ValueTreePropertySelection& treeviewPropertySelection);
+    ValueTreePropertyView(const juce::ValueTree parentOfProperty, const juce::Identifier nameOfProperty, juce::UndoManager* undoManager, ValueTreePropertySelection& treeviewPropertySelection, int scrubWritesPerSecond);
     ~ValueTreePropertyView() override;
 
     void resized() override;
     void paint(juce::Graphics& g) override;
 
-    void valueTreePropertyChanged(juce::ValueTree& changedTree, const juce::Identifier& prop) override;
+    /* Show the current type and value of the property */
+    void refresh();
+
+    /* Show another property, for rows recycled by the ViewPool. Selection, history and the
+       baseline mark are reset. */
+    void bind(const juce::ValueTree& parentOfProperty, const juce::Identifier& nameOfProperty, juce::UndoManager* undoManager,
+              ValueTreePropertySelection* treeviewPropertySelection, int scrubWritesPerSecond);
+    /* Let go of the tree and the selection while the row waits in the pool */
+    void unbind();
+
+    /* Recent values drawn as a sparkline next to the value, nullptr to hide it */
+    void setHistory(const ValueHistory::Buffer* historyToShow);
+
+    /* Mark the property as differing from the baseline, the tooltip tells the baseline value */
+    void setDiffers(bool shouldBeMarked, const juce::String& baselineDescription);
+
+    /* While the debugger is frozen, the value the property had when it froze, see FreezeSnapshot */
+    void setFrozenValue(const juce::var* frozenValueToShow);
 
     void changeListenerCallback(juce::ChangeBroadcaster*) override;
 
@@ -147,61 +329,186 @@ public:
 
     int propNameLabelWidth{ 150 };
     int propTypeLabelWidth{ 80 };
+    int sparklineWidth{ 100 };
 
     bool selected{ false };
+    bool differs{ false };
 
     juce::ValueTree tree;
     juce::Identifier propertyName;
-    ValueTreePropertySelection& propertySelection;
+    /* Of the debugger the row is bound to, nullptr in the pool */
+    ValueTreePropertySelection* propertySelection;
+
+private:
+    void paintSparkline(juce::Graphics& g);
+
+    const ValueHistory::Buffer* history{ nullptr };
+    juce::Rectangle<int> sparklineArea;
 };
 
 class Item;
+class ValueTreeView;
+struct ItemContext;
+class TimeTravelWindow;
+class ValueTreeDebuggerMain;
+
+/* Item views and property rows scrolled out of the tree view are kept here and rebound to other
+   nodes, instead of being destroyed and set up again for each row scrolled in. The debuggers of
+   the sources of one window share a pool, so the rows made follow what is shown, not the sources.
+   Rebinding still allocates some: the TreeView deletes the component it is given for an item, so
+   each item scrolled in costs a PooledItemComponent, and the labels get new text, such as a
+   number's value as a String. The components and their setup aren't made again. */
+class ViewPool
+{
+public:
+    ViewPool() = default;
+    ~ViewPool();
+
+    /* A view showing the item, recycled if one is free */
+    std::unique_ptr<ValueTreeView> takeView(Item& item);
+    void releaseView(std::unique_ptr<ValueTreeView> view);
+
+    /* A row showing the property, recycled if one is free */
+    std::unique_ptr<ValueTreePropertyView> takeRow(ItemContext& context, const juce::ValueTree& tree, const juce::Identifier& name);
+    void releaseRow(std::unique_ptr<ValueTreePropertyView> row);
+
+    int getNumFreeViews() const { return (int)freeViews.size(); }
+    int getNumFreeRows() const { return (int)freeRows.size(); }
+
+private:
+    std::vector<std::unique_ptr<ValueTreeView>> freeViews;
+    std::vector<std::unique_ptr<ValueTreePropertyView>> freeRows;
+};
+
+/* State shared by every item of one debugger */
+struct ItemContext
+{
+    ItemContext(FlatTreeModel& treeModel, ValueTreePropertySelection& treeviewPropertySelection);
+
+    Item* findItem(FlatTreeModel::NodeId id) const;
+
+    /* Whether a new item should start closed */
+    bool isClosed(const Item& item);
+    /* Before a redirect, which gives every node a new id */
+    void keepOpennessByPath();
+    void clearOpenness();
+
+    FlatTreeModel& model;
+    ValueTreePropertySelection& propertySelection;
+    juce::UndoManager* um{ nullptr };
+    /* Writes per second while scrubbing a numeric value */
+    int scrubRateHz{ 30 };
+    const ValueHistory* history{ nullptr };
+    const TreeDiff* diff{ nullptr };
+    OverheadGovernor* governor{ nullptr };
+    const FreezeSnapshot* freeze{ nullptr };
+    const ExclusionFilter* exclusions{ nullptr };
+    /* Nothing can be edited, dragged or dropped */
+    bool readOnly{ false };
+
+    /* Items currently in the tree view, by the id of the node they show */
+    std::unordered_map<FlatTreeModel::NodeId, Item*> items;
+
+    /* Items differ from the default openness (open) only when closed, so only those are kept.
+       Node ids survive moves, reorders and undo, so the state follows the nodes. */
+    std::unordered_set<FlatTreeModel::NodeId> closedNodes;
+    std::unordered_set<FlatTreeModel::NodeId> selectedNodes;
+    /* Closed items carried over a redirect, until items with the same path and type are created */
+    std::unordered_set<juce::String> closedPaths;
+    /* Open items whose children weren't kept when frozen, their sub-items are built on unfreezing */
+    std::vector<FlatTreeModel::NodeId> withheldSubItems;
+
+    /* Shared by the debuggers of one window */
+    ViewPool* viewPool{ nullptr };
+
+private:
+    static juce::String getOpennessPath(const juce::ValueTree& tree);
+};
 
 /* The component displayed as a tree view item */
 class ValueTreeView : public juce::Component
 {
 public:
-    ValueTreeView(juce::String componentName, juce::ValueTree tree, Item& parentItem, juce::UndoManager* undoManager, ValueTreePropertySelection& treeviewPropertySelection);
+    explicit ValueTreeView(ItemContext& itemContext);
     ~ValueTreeView() override;
 
+    /* Show an item, reusing the property rows already made where possible */
+    void bind(Item& item);
+    /* Give the property rows back to the pool and forget the item */
+    void unbind();
+
     void resized() override;
     void paint(juce::Graphics& g) override;
+    void paintOverChildren(juce::Graphics& g) override;
     void mouseUp(const juce::MouseEvent& evt) override;
     void mouseEnter(const juce::MouseEvent&) override;
     void mouseExit(const juce::MouseEvent&) override;
 
     void createPropertyComponents();
 
+    /* Refresh the view of a property whose value has changed */
+    void propertyChanged(const juce::Identifier& property);
+
+    /* Re-read how the node differs from the baseline */
+    void updateDiff();
+
     /* Get the property view referenced in the mouse event or nullptr */
     ValueTreePropertyView* propertyMoused(const juce::MouseEvent& evt);
 
     juce::Label lblType{};
     juce::OwnedArray<ValueTreePropertyView> props{};
 
+    /* Summary row and pager shown instead of the full list for nodes with many properties */
+    juce::TextButton butPropertyBlock;
+    juce::TextButton butPrevPage{ "<" };
+    juce::TextButton butNextPage{ ">" };
+    juce::Label lblPage;
+
     int treeTypeLabelWidth{ 150 };
 
 private:
-    Item& parent;
-    juce::UndoManager* um;
-    ValueTreePropertySelection& propertySelection;
+    void setupPropertyBlock();
+    void updatePropertyBlock();
+
+    /* Of the item shown, views are pooled across the debuggers of a window */
+    ItemContext* context;
+    Item* parent{ nullptr };
     juce::Rectangle<int> propsArea;
+    TreeDiff::Difference difference;
+    /* From paint to paintOverChildren, the labels and rows in between, for the overhead budget */
+    juce::int64 paintStartTicks{ 0 };
     juce::SharedResourcePointer<ValueTreeDebuggerLookAndFeel> lnf{};
 };
 
+/* What the tree view owns for an item. The tree view deletes it when the item scrolls out of
+   view, which returns the ValueTreeView inside to the pool. */
+class PooledItemComponent : public juce::Component
+{
+public:
+    PooledItemComponent(std::unique_ptr<ValueTreeView> viewToShow, ViewPool& viewPool);
+    ~PooledItemComponent() override;
+
+    void resized() override;
+
+private:
+    std::unique_ptr<ValueTreeView> view;
+    ViewPool& pool;
+};
+
 /* Tree View Item */
 class Item :
     public juce::TreeViewItem,
-    public juce::ValueTree::Listener,
     public juce::MouseListener
 {
 public:
-    Item(juce::ValueTree treeToUse, juce::UndoManager* undoManager, ValueTreePropertySelection& treeviewPropertySelection);
+    Item(juce::ValueTree treeToUse, FlatTreeModel::NodeId id, ItemContext& itemContext);
     ~Item() override;
 
     // TreeViewItem
     bool mightContainSubItems() override;
     juce::String getUniqueName() const override;
     void itemOpennessChanged(bool isNowOpen) override;
+    void itemSelectionChanged(bool isNowSelected) override;
     int getItemHeight() const override;
     std::unique_ptr<juce::Component> createItemComponent() override;
     bool customComponentUsesTreeViewMouseHandler() const override;
@@ -209,61 +516,435 @@ public:
     bool isInterestedInDragSource(const juce::DragAndDropTarget::SourceDetails& dragSourceDetails) override;
     void itemDropped(const juce::DragAndDropTarget::SourceDetails&, int insertIndex) override;
 
-    // Value Tree Listener
-    void valueTreeChildAdded(juce::ValueTree& parentTree, juce::ValueTree& /*childWhichHasBeenAdded*/) override;
-    void valueTreeChildRemoved(juce::ValueTree& parentTree, juce::ValueTree& /*childWhichHasBeenRemoved*/, int) override;
-    void valueTreeChildOrderChanged(juce::ValueTree& parentTreeWhoseChildrenHaveMoved, int, int) override;
-    void valueTreeParentChanged(juce::ValueTree& /*treeWhoseParentHasChanged*/) override;
-    void valueTreeRedirected(juce::ValueTree& /*treeWhichHasBeenChanged*/) override;
+    // Changes dispatched by the ValueTreeDebuggerMain, after the model has been updated
+    void propertyChanged(const juce::Identifier& property);
+    void childrenChanged();
+    /* Add items for children mirrored since the sub-items were last updated */
+    void childrenAppended();
+    void diffChanged();
 
     void updateSubItems();
+    /* Re-read all properties of the node */
+    void refreshProperties();
+    /* The same without telling the tree view, for refreshing many items at once.
+       Returns true if the number of properties, and so the item height, changed. */
+    bool syncProperties();
     void deselectAll();
 
+    ItemContext& getContext() { return context; }
+
+    /* The properties of the node, those kept when frozen while the view is */
+    int getNumShownProperties() const;
+    juce::Identifier getShownPropertyName(int index) const;
+
+    /* Nodes with more properties than this show them collapsed behind a summary row, one page at a time */
+    bool usesPropertyBlock() const;
+    int getNumPropertyPages() const;
+    juce::Range<int> getVisiblePropertyRange() const;
+    void setPropertyBlockOpen(bool shouldBeOpen);
+    void setPropertyPage(int newPage);
+
     juce::ValueTree tree;
-    ValueTreeView* comp;
+    const FlatTreeModel::NodeId nodeId;
+    /* An excluded subtree, shown as a collapsed placeholder without properties or children */
+    const bool excluded;
+    ValueTreeView* comp{ nullptr };
+
+    bool propertyBlockOpen{ false };
+    int propertyPage{ 0 };
 
 private:
+    void propertyBlockChanged();
+    /* Add an item for a child node, with the openness and selection kept for it */
+    void addSubItemFor(const juce::ValueTree& child, FlatTreeModel::NodeId childId);
+    /* While frozen, what was kept of the node, or nullptr */
+    const FreezeSnapshot::Lists* findFrozenLists() const;
+
+    ItemContext& context;
     juce::UndoManager* um;
     ValueTreePropertySelection& propertySelection;
-    juce::Array<juce::Identifier> currentProperties;
+    int numProperties{ 0 };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Item)
 
 };
 
+/* One tab per source of a debugger hosting several trees */
+class SourceTabs : public juce::TabbedButtonBar
+{
+public:
+    SourceTabs();
+
+    void currentTabChanged(int newCurrentTabIndex, const juce::String& newCurrentTabName) override;
+
+    std::function<void(int)> onTabChanged;
+};
+
+/* What the debuggers of one window share, so its overhead grows with the rows shown rather than
+   with the number of sources: the pool of views, one listener which passes each change on to the
+   debugger of its tree, one timer ticking the debuggers which are building or showing live stats,
+   and one overhead governor measuring them all. */
+class DebuggerHub :
+    public juce::ValueTree::Listener,
+    private juce::Timer
+{
+public:
+    DebuggerHub();
+    ~DebuggerHub() override;
+
+    ViewPool& getViewPool() { return viewPool; }
+    OverheadGovernor& getGovernor() { return governor; }
+
+    /* Called by the debuggers as they are made and destroyed */
+    void addDebugger(ValueTreeDebuggerMain& main);
+    void removeDebugger(ValueTreeDebuggerMain& main);
+
+    /* Pass the changes of the tree on to the debugger. Trees of different debuggers mustn't be
+       inside each other, a change would reach the listener once for each. */
+    void listenTo(juce::ValueTree& tree, ValueTreeDebuggerMain& main);
+    void stopListening(juce::ValueTree& tree, ValueTreeDebuggerMain& main);
+
+    /* Tick the debugger every intervalMs, zero to stop */
+    void setTickInterval(ValueTreeDebuggerMain& main, int intervalMs);
+
+    /* The budget covers every debugger of the window, see OverheadGovernor */
+    void setOverheadBudget(double msPerFrame, double frameMs);
+
+    // Value Tree Listener
+    void valueTreePropertyChanged(juce::ValueTree& changedTree, const juce::Identifier& property) override;
+    void valueTreeChildAdded(juce::ValueTree& parentTree, juce::ValueTree& childWhichHasBeenAdded) override;
+    void valueTreeChildRemoved(juce::ValueTree& parentTree, juce::ValueTree& childWhichHasBeenRemoved, int indexFromWhichChildWasRemoved) override;
+    void valueTreeChildOrderChanged(juce::ValueTree& parentTreeWhoseChildrenHaveMoved, int oldIndex, int newIndex) override;
+    void valueTreeRedirected(juce::ValueTree& treeWhichHasBeenChanged) override;
+
+private:
+    /* The debugger of the tree a change is in, found from the changed node's ancestors, so the
+       cost is its depth whatever the number of sources */
+    ValueTreeDebuggerMain* findDebugger(const juce::ValueTree& changedTree) const;
+    void timerCallback() override;
+    void updateTimer();
+
+    struct Ticking
+    {
+        ValueTreeDebuggerMain* main;
+        int intervalMs;
+        double dueMs;
+    };
+
+    ViewPool viewPool;
+    OverheadGovernor governor;
+    std::vector<ValueTreeDebuggerMain*> debuggers;
+    std::unordered_map<juce::ValueTree, ValueTreeDebuggerMain*, ValueTreeHash> routes;
+    std::vector<Ticking> ticking;
+};
+
 /* Main component which fills the window */
 class ValueTreeDebuggerMain :
     public juce::Component,
     public juce::ValueTree::Listener
 {
 public:
-    ValueTreeDebuggerMain(juce::UndoManager* undoManager);
+    /* The debuggers of one window share its hub, nullptr for a hub of its own */
+    ValueTreeDebuggerMain(juce::UndoManager* undoManager, DebuggerHub* sharedHub = nullptr);
     ~ValueTreeDebuggerMain() override;
 
     // Component
     void resized() override;
+    bool keyPressed(const juce::KeyPress& key) override;
 
-    // Value Tree Listener
+    /* Called by the hub's timer at the interval asked for, to build a slice or update the status */
+    void tick();
+
+    // Value Tree Listener, called by the hub
+    void valueTreePropertyChanged(juce::ValueTree& changedTree, const juce::Identifier& property) override;
+    void valueTreeChildAdded(juce::ValueTree& parentTree, juce::ValueTree& childWhichHasBeenAdded) override;
+    void valueTreeChildRemoved(juce::ValueTree& parentTree, juce::ValueTree& childWhichHasBeenRemoved, int indexFromWhichChildWasRemoved) override;
+    void valueTreeChildOrderChanged(juce::ValueTree& parentTreeWhoseChildrenHaveMoved, int oldIndex, int newIndex) override;
     void valueTreeRedirected(juce::ValueTree& treeWhichHasBeenChanged) override;
     
     void setTree(juce::ValueTree* newTree);
+    bool hasTree() const { return tree != nullptr; }
+
+    const FlatTreeModel& getModel() const { return model; }
+    Watchpoints& getWatchpoints() { return watchpoints; }
+
+    /* Freeze the view, which keeps showing the tree as it was while the model and watchpoints
+       follow the changes. Only items shown or one level below when frozen can be opened until
+       unfreezing, which refreshes only the items of the nodes which changed. */
+    void setUpdatesPaused(bool shouldBePaused);
+    bool areUpdatesPaused() const { return updatesPaused; }
+    /* Changes which arrived while frozen */
+    juce::int64 getNumPendingChanges() const { return freeze.getNumPending(); }
+
+    /* Follow a subtree by polling instead of events while its properties change faster than the
+       sampler's threshold, see AdaptiveSampler */
+    void setAdaptiveSampling(const juce::ValueTree& subtree, bool shouldSample);
+    AdaptiveSampler& getSampler() { return sampler; }
+
+    /* Limit the message thread time spent by the debugger and the others of its hub, zero for no limit, see OverheadGovernor */
+    void setOverheadBudget(double msPerFrame, double frameMs = 16.0);
+    const OverheadGovernor& getGovernor() const { return governor; }
+
+    /* Nothing in the view can change the tree, and no time travel history is kept. Set before the tree. */
+    void setReadOnly(bool shouldBeReadOnly);
+    bool isReadOnly() const { return itemContext.readOnly; }
+
+    /* Keep the history of the tree for this long and at most this many bytes, zero seconds (the default) to keep none, see TimeTravel */
+    void setTimeTravelRetention(double seconds, juce::int64 maxBytes);
+    const TimeTravel& getTimeTravel() const { return timeTravel; }
+    /* Open the window browsing the history */
+    void showTimeTravel();
+
+    /* Leave subtrees and properties out of the debugger, see ExclusionFilter. The rules are saved
+       for the trees with the same type of root. Changing them rebuilds the view. */
+    void excludeType(const juce::Identifier& type);
+    void excludeSubtree(const juce::ValueTree& subtree);
+    void excludeProperty(const juce::Identifier& property);
+    void clearExclusions();
+    const ExclusionFilter& getExclusions() const { return exclusions; }
+
+    /* Counts of what happened to the tree since the tree was set or the stats reset, see SessionStats */
+    const SessionStats& getSessionStats() const { return sessionStats; }
+    void resetSessionStats() { sessionStats.reset(); }
+    /* The app's undo manager, whose transactions and undo or redo the stats count */
+    void setSessionUndoManager(const juce::UndoManager* appUndoManager) { sessionStats.setUndoManager(appUndoManager); }
+    juce::Result exportSessionStats(const juce::File& file);
+
+    /* Stream changes to a Chrome Trace Event JSON file, see TraceExporter */
+    juce::Result startTrace(const juce::File& file, bool includeCallbackDurations, std::function<double()> clockMicroseconds = {});
+    void stopTrace();
+
+    /* Record changes as a change log which can be replayed */
+    void startRecording();
+    juce::ValueTree stopRecording();
+
+    /* Read a change log to replay onto the tree, which is left as it is until the replay starts */
+    juce::Result loadReplay(const juce::ValueTree& changeLog);
+    ReplayEngine& getReplay() { return replay; }
+
+    /* Drive synthetic changes into the selected subtree */
+    void startStress(const StressGenerator::Profile& profile, bool useUndoManager);
+    void stopStress();
+    const StressGenerator::Stats& getStressStats() const { return stress.getStats(); }
+
+    void setScrubRate(int writesPerSecond);
+
+    /* Keep the recent values of a numeric property and show them as a sparkline. The history is
+       freed when the node is removed, its length is set by getHistory().setCapacity. */
+    void setHistoryTracked(const juce::ValueTree& node, const juce::Identifier& property, bool shouldTrack);
+    ValueHistory& getHistory() { return history; }
+
+    /* Highlight where the tree differs from a baseline, such as a default preset */
+    void setBaseline(const juce::ValueTree& baselineTree);
+    /* Read a baseline saved as XML, or in the binary format of ValueTree::writeToStream */
+    juce::Result loadBaseline(const juce::File& file);
+    void clearBaseline();
+    const TreeDiff& getDiff() const { return diff; }
+
+    /* Select the nodes matching a TreeQuery and show the first */
+    juce::Result selectMatching(const juce::String& queryText);
+    const std::vector<FlatTreeModel::NodeId>& getQueryMatches() const { return queryMatches; }
+
+    /* Copy the selected subtrees, to be pasted in this or any other debugger */
+    void copySelection();
+    /* Add the copied subtrees to the selected node, as one undo transaction */
+    void pasteIntoSelection();
+
+    /* Bulk edits of every selected node, which includes every match of the last query even where
+       no item has been created. Each is one undo transaction with one refresh of the view at the end.
+       They return the number of nodes changed. */
+    int setPropertyOfSelection(const juce::Identifier& name, const juce::var& value);
+    int removePropertyOfSelection(const juce::Identifier& name);
+    int renamePropertyOfSelection(const juce::Identifier& oldName, const juce::Identifier& newName);
 
 private:
+    friend class DebuggerHub;
+
     void setupToolbar();
+    /* Mirror more of the tree for at most about maxMs, and add the items for what was mirrored */
+    void buildSlice(double maxMs);
+    /* Mirror the rest of the tree now */
+    void finishBuilding();
+    void updateTimer();
+    /* Stats of the selected subtree are computed in the background over a snapshot, changes to the
+       tree meanwhile only mark the result as stale */
+    void showStats();
+    void hideStats();
+    /* After every change to the model, for what is derived from it */
+    void modelChanged();
+    juce::Array<juce::ValueTree> getSelectedTrees();
+    /* Apply an edit to each tree as one transaction, returning how many it changed */
+    int editTrees(const juce::Array<juce::ValueTree>& trees, const juce::String& description, const std::function<bool(juce::ValueTree&)>& edit);
+    /* Open the items above a node and scroll to it */
+    void revealNode(FlatTreeModel::NodeId id);
+    /* A property change which reached the debugger, by event or found by the sampler */
+    void handlePropertyChange(juce::ValueTree& changedTree, const juce::Identifier& property);
+    /* Refresh the items whose updates were held back by a bulk edit or the overhead governor */
+    void flushDeferredItems();
+    void governorLevelChanged(OverheadGovernor::Level previous);
+    /* Every flush interval of the governor, shows the changes coalesced meanwhile */
+    void governorFlushed();
+    /* Pass a structural change of a mirrored node on to its item */
+    void dispatchChildrenChanged(int node);
+    /* Free the value histories of a node about to be removed and of its descendants */
+    void forgetHistory(int removedNode);
+    void updateWatchButtons();
+    void updateReplayButtons();
+    /* The first play or step of a replay resets the tree, so it is asked for first */
+    void confirmReplay(std::function<void()> startReplay);
+    void updateFreezeButton();
+    /* Save the rules and mirror the tree again with them */
+    void updateExclusions();
+    /* Whether a change to the tree is left out, O(1) once the model is built */
+    bool isExcluded(const juce::ValueTree& changedTree) const;
+    void updateExclusionButtons();
+    void updateStatus();
 
-    std::unique_ptr<Item> rootItem;
+    /* Mirror of the tree, updated before any view sees a change */
+    FlatTreeModel model;
+
+    std::unique_ptr<DebuggerHub> ownHub;
+    DebuggerHub& hub;
 
     /* The currently selected property */
     ValueTreePropertySelection selectedProperty;
+
+    Watchpoints watchpoints;
+    ValueHistory history;
+    TreeDiff diff{ model };
+    AdaptiveSampler sampler{ model };
+    OverheadGovernor& governor;
+    SessionStats sessionStats;
+    TimeTravel timeTravel;
+    /* The baseline comparison is left out in structure only mode */
+    bool diffStale{ false };
+    std::vector<FlatTreeModel::NodeId> queryMatches;
+    /* The outcome of the last query or bulk edit */
+    juce::String actionStatus;
+    bool updatesPaused{ false };
+    FreezeSnapshot freeze;
+    ExclusionFilter exclusions;
+    /* The rules are kept per type of root, these are the ones of this type */
+    juce::Identifier exclusionsRootType;
+    /* During a bulk edit, or while the governor is below full updates, items are refreshed later.
+       These are the ones to refresh. */
+    bool deferringItemUpdates{ false };
+    std::unordered_set<FlatTreeModel::NodeId> deferredItems;
+
+    TraceExporter trace;
+    ChangeRecorder recorder;
+    ReplayEngine replay;
+    StressGenerator stress;
+    std::unique_ptr<juce::FileChooser> fileChooser;
+    juce::SharedResourcePointer<SubtreeClipboard> clipboard;
+
+    ItemContext itemContext{ model, selectedProperty };
+    std::unique_ptr<Item> rootItem;
     
-    juce::ValueTree* tree;
+    juce::ValueTree* tree{ nullptr };
     juce::UndoManager* um;
     
     juce::TreeView treeView;
     vtdbg::MiniToolbar toolbar;
+    juce::Viewport toolbarViewport;
+    double buildProgress{ -1.0 };
+    juce::ProgressBar buildProgressBar{ buildProgress };
+    StatsCollector statsCollector;
+    juce::TextEditor statsView;
+    juce::TooltipWindow tooltipWindow{ this };
+    std::unique_ptr<TimeTravelWindow> timeTravelWindow;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ValueTreeDebuggerMain)
 };
 
+/* The tree as it was at the time picked on the slider, in a read only debugger. With the slider
+   at the end it follows the live tree. */
+class TimeTravelView :
+    public juce::Component,
+    private juce::Timer
+{
+public:
+    explicit TimeTravelView(TimeTravel& timeTravelToBrowse);
+    ~TimeTravelView() override;
+
+    void resized() override;
+
+private:
+    /* Extends the slider as the history grows, and drops what the retention dropped */
+    void timerCallback() override;
+    void seek();
+    /* A new tree, or the history of a tree of another type */
+    void resetTarget();
+    void updateLabel();
+
+    TimeTravel& timeTravel;
+    juce::ValueTree historyTree;
+    juce::Slider slider{ juce::Slider::LinearHorizontal, juce::Slider::NoTextBox };
+    juce::Label lblTime;
+    ValueTreeDebuggerMain main{ nullptr };
+    bool followingLive{ true };
+};
+
+class TimeTravelWindow : public juce::DocumentWindow
+{
+public:
+    explicit TimeTravelWindow(TimeTravel& timeTravelToBrowse);
+    ~TimeTravelWindow() override;
+
+    void closeButtonPressed() override;
+
+private:
+    TimeTravelView view;
+    juce::SharedResourcePointer<vtdbg::ValueTreeDebuggerLookAndFeel> lnf{};
+};
+
+/* The sources of a window in tabs, each with a debugger of its own which keeps following its tree,
+   so switching tabs loses no statistics, history or watchpoints. The debuggers share one hub,
+   with its listener, timer, governor and pool, and only the shown one has rows. */
+class SourcesView : public juce::Component
+{
+public:
+    explicit SourcesView(juce::UndoManager* undoManager);
+    ~SourcesView() override;
+
+    void resized() override;
+
+    /* Replaces the first source while it is still unnamed and empty */
+    void addSource(const juce::String& name, juce::ValueTree& tree, juce::UndoManager* undoManager);
+    void removeSource(int index);
+    void showSource(int index);
+    int findSource(const juce::String& name) const;
+
+    ValueTreeDebuggerMain& getShown() { return *sources[(size_t)shown].main; }
+    /* The first source, whichever is shown */
+    ValueTreeDebuggerMain& getPrimary() { return *sources.front().main; }
+    const ValueTreeDebuggerMain& getPrimary() const { return *sources.front().main; }
+    ValueTreeDebuggerMain* getSource(const juce::String& name);
+    DebuggerHub& getHub() { return hub; }
+
+    /* For every source, also those added later */
+    void setScrubRate(int writesPerSecond);
+
+private:
+    struct Source
+    {
+        juce::String name;
+        std::unique_ptr<ValueTreeDebuggerMain> main;
+    };
+
+    std::unique_ptr<ValueTreeDebuggerMain> createMain(juce::UndoManager* undoManager);
+    void updateTabs();
+
+    // Declared first so the rows outlive every debugger
+    DebuggerHub hub;
+    SourceTabs tabs;
+    std::vector<Source> sources;
+    int shown{ 0 };
+    bool updatingTabs{ false };
+    /* Zero until set, leaving the debuggers' default */
+    int scrubRate{ 0 };
+};
+
 /* Window containing the VT debugger */
 class ValueTreeDebugger :
     public juce::DocumentWindow,
@@ -278,10 +959,92 @@ public:
     
     void setSource(juce::ValueTree& v);
 
+    /* Host several trees, such as processor state, UI state and the session model, in tabs of
+       this one window. Every source keeps its own statistics, history and watchpoints, they share
+       one listener, timer and overhead governor, and only the rows of the shown one are made.
+       The methods below act on the first source, the one of the constructor or setSource, whichever
+       tab is shown. The debugger of any source has methods of the same names. The scrub rate and the
+       overhead budget apply to every source. */
+    void addSource(const juce::String& name, juce::ValueTree& tree, juce::UndoManager* undoManager = nullptr);
+    void removeSource(const juce::String& name);
+    void showSource(const juce::String& name);
+    /* The debugger of a source, nullptr if there is none of that name. The first source is
+       unnamed unless it was added with addSource. */
+    ValueTreeDebuggerMain* getSourceDebugger(const juce::String& name);
+
+    /* Watchpoints on writes to the source tree */
+    Watchpoints& getWatchpoints();
+
+    /* Record changes to the source tree, and the time the debugger spends handling them,
+       to a trace file for Perfetto or chrome://tracing. Events are timed by the clock, in microseconds,
+       Time::getMillisecondCounterHiRes if there is none, so they line up with the app's own trace. */
+    juce::Result startTrace(const juce::File& file, bool includeCallbackDurations = true, std::function<double()> clockMicroseconds = {});
+    void stopTrace();
+
+    /* Record changes to the source tree into a change log, nodes are referred to by stable ids */
+    void startRecording();
+    juce::ValueTree stopRecording();
+
+    /* Replays a change log onto the source tree, also usable as a load generator */
+    ReplayEngine& getReplay();
+
+    /* Drive synthetic changes into the selected subtree and measure their cost */
+    void startStress(const StressGenerator::Profile& profile, bool useUndoManager);
+    void stopStress();
+    const StressGenerator::Stats& getStressStats() const;
+
+    /* Limit the writes per second made while dragging a numeric value, the whole drag is one undo transaction */
+    void setScrubRate(int writesPerSecond);
+
+    /* Keep the recent values of a numeric property of the source tree, shown as a sparkline */
+    void setHistoryTracked(const juce::ValueTree& node, const juce::Identifier& property, bool shouldTrack);
+    ValueHistory& getHistory();
+
+    /* Highlight where the source tree differs from a baseline tree, which is copied */
+    void setBaseline(const juce::ValueTree& baselineTree);
+    void clearBaseline();
+    const TreeDiff& getDiff() const;
+
+    /* Select the nodes matching a path query such as /Session/Track[@muted=true]//Plugin, see TreeQuery */
+    juce::Result selectMatching(const juce::String& query);
+
+    /* Poll a subtree instead of following its events while they arrive faster than the threshold */
+    void setAdaptiveSampling(const juce::ValueTree& subtree, bool shouldSample);
+    void setAdaptiveSamplingThreshold(double eventsPerSecond);
+    /* Keep the debugger's message thread time under msPerFrame, stepping down to cheaper updates
+       when it isn't. Zero removes the budget. */
+    void setOverheadBudget(double msPerFrame, double frameMs = 16.0);
+
+    /* Statistics of the changes since the tree was set, exported as CSV for a .csv file and JSON otherwise */
+    const SessionStats& getSessionStats() const;
+    void resetSessionStats();
+    /* The undo manager the app changes the source tree with. The stats count its transactions and
+       undo or redo, and have no undo section without one. */
+    void setSessionUndoManager(const juce::UndoManager* appUndoManager);
+    juce::Result exportSessionStats(const juce::File& file);
+
+    /* Keep the history of the source tree, browsed with showTimeTravel. None is kept by default,
+       opening time travel first keeps 5 minutes and 64 MB. Zero seconds stops and forgets it. */
+    void setTimeTravelRetention(double seconds, double megabytes);
+    void showTimeTravel();
+
+    /* Leave noisy subtrees, such as meters, and properties out of the debugger at no cost.
+       Excluded subtrees are shown collapsed. The rules are kept for the next session,
+       for trees with the same type of root. */
+    void excludeType(const juce::Identifier& type);
+    void excludeSubtree(const juce::ValueTree& subtree);
+    void excludeProperty(const juce::Identifier& property);
+    void clearExclusions();
+
+    /* Edit every selected node as one undo transaction, returning the number of nodes changed */
+    int setPropertyOfSelection(const juce::Identifier& name, const juce::var& value);
+    int removePropertyOfSelection(const juce::Identifier& name);
+    int renamePropertyOfSelection(const juce::Identifier& oldName, const juce::Identifier& newName);
+
 private:
     void construct();
 
-    std::unique_ptr<vtdbg::ValueTreeDebuggerMain> main;
+    std::unique_ptr<vtdbg::SourcesView> sources;
     juce::SharedResourcePointer<vtdbg::ValueTreeDebuggerLookAndFeel> lnf{};
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ValueTreeDebugger)
@@ -0,0 +1,523 @@
+#include "Watchpoints.h"
+#include "ValueComparison.h"
+
+namespace vtdbg
+{
+/* Recursive descent parser emitting the postfix program of a WatchCondition */
+class WatchConditionParser
+{
+public:
+    WatchConditionParser(const juce::String& text, WatchCondition& conditionToBuild) :
+        p(text.getCharPointer()),
+        condition(conditionToBuild)
+    {
+    }
+
+    juce::Result parse()
+    {
+        skipWhitespace();
+        if (p.isEmpty()) return juce::Result::ok();
+
+        auto result = parseOr();
+        if (result.failed()) return result;
+
+        skipWhitespace();
+        if (!p.isEmpty()) return fail("Unexpected \"" + juce::String(p) + "\"");
+
+        if (maxDepth > WatchCondition::maxStackDepth) return fail("Condition is too complex");
+
+        // A "changed" test which the whole condition requires means only writes to that
+        // property can make it true
+        if (!topLevelOr && !topLevelChangedProperties.isEmpty())
+        {
+            for (const auto& id : topLevelChangedProperties)
+                condition.triggers.push_back(id);
+
+            return juce::Result::ok();
+        }
+
+        // The node type, or a negated "changed" test, can make it true on a write to any property
+        if (usesType || negatedChangedTest)
+            return juce::Result::ok();
+
+        // Otherwise a write to any property it tests can change its result
+        for (const auto& id : comparedProperties)
+            condition.triggers.push_back(id);
+
+        for (const auto& id : changedProperties)
+            if (!comparedProperties.contains(id))
+                condition.triggers.push_back(id);
+
+        return juce::Result::ok();
+    }
+
+private:
+    juce::Result parseOr()
+    {
+        auto result = parseAnd();
+
+        while (result.wasOk() && match("||"))
+        {
+            if (groupDepth == 0)
+                topLevelOr = true;
+
+            result = parseAnd();
+            emit(WatchCondition::Op::logicalOr);
+        }
+
+        return result;
+    }
+
+    juce::Result parseAnd()
+    {
+        auto result = parseUnary();
+
+        while (result.wasOk() && match("&&"))
+        {
+            result = parseUnary();
+            emit(WatchCondition::Op::logicalAnd);
+        }
+
+        return result;
+    }
+
+    juce::Result parseUnary()
+    {
+        if (match("!"))
+        {
+            ++groupDepth;
+            ++negationDepth;
+            auto result = parseUnary();
+            --negationDepth;
+            --groupDepth;
+
+            emit(WatchCondition::Op::logicalNot);
+            return result;
+        }
+
+        if (match("("))
+        {
+            ++groupDepth;
+            auto result = parseOr();
+            --groupDepth;
+
+            if (result.failed()) return result;
+            return match(")") ? juce::Result::ok() : fail("Expected )");
+        }
+
+        bool wasChangedTest = false;
+        auto result = parseOperand(wasChangedTest);
+        if (result.failed() || wasChangedTest) return result;
+
+        using Op = WatchCondition::Op;
+        Op comparison;
+
+        if (match("==")) comparison = Op::equal;
+        else if (match("!=")) comparison = Op::notEqual;
+        else if (match("<=")) comparison = Op::lessOrEqual;
+        else if (match(">=")) comparison = Op::greaterOrEqual;
+        else if (match("<")) comparison = Op::less;
+        else if (match(">")) comparison = Op::greater;
+        else return juce::Result::ok(); // A lone operand is tested for truth
+
+        result = parseOperand(wasChangedTest);
+        if (result.failed()) return result;
+        if (wasChangedTest) return fail("Cannot compare a \"changed\" test");
+
+        emit(comparison);
+        return juce::Result::ok();
+    }
+
+    juce::Result parseOperand(bool& wasChangedTest)
+    {
+        using Op = WatchCondition::Op;
+        skipWhitespace();
+        wasChangedTest = false;
+
+        const auto c = *p;
+
+        if (c == '"' || c == '\'')
+        {
+            ++p;
+            juce::String text;
+            while (!p.isEmpty() && *p != c)
+                text += p.getAndAdvance();
+
+            if (p.isEmpty()) return fail("Unterminated string");
+            ++p;
+
+            emit(Op::pushConstant, addConstant(text));
+            return juce::Result::ok();
+        }
+
+        if (juce::CharacterFunctions::isDigit(c) || c == '-' || c == '.')
+        {
+            double number;
+            if (!ValueComparison::readNumber(p, number)) return fail("Invalid number");
+
+            emit(Op::pushConstant, addConstant(number));
+            return juce::Result::ok();
+        }
+
+        const auto name = readWord();
+        if (name.isEmpty()) return fail(p.isEmpty() ? "Unexpected end of condition" : "Unexpected \"" + juce::String(p) + "\"");
+
+        if (name == "true" || name == "false")
+        {
+            emit(Op::pushConstant, addConstant(name == "true"));
+            return juce::Result::ok();
+        }
+
+        if (name == "type")
+        {
+            usesType = true;
+            emit(Op::pushType);
+            return juce::Result::ok();
+        }
+
+        if (!juce::Identifier::isValidIdentifier(name)) return fail("Invalid property name " + name);
+
+        const juce::Identifier property{ name };
+        const auto identifierIndex = addIdentifier(property);
+
+        const auto beforeKeyword = p;
+        if (readWord() == "changed")
+        {
+            changedProperties.addIfNotAlreadyThere(property);
+            if (groupDepth == 0)
+                topLevelChangedProperties.addIfNotAlreadyThere(property);
+            if (negationDepth > 0)
+                negatedChangedTest = true;
+
+            wasChangedTest = true;
+            emit(Op::changed, identifierIndex);
+            return juce::Result::ok();
+        }
+        p = beforeKeyword;
+
+        comparedProperties.addIfNotAlreadyThere(property);
+        emit(Op::pushProperty, identifierIndex);
+        return juce::Result::ok();
+    }
+
+    juce::String readWord()
+    {
+        skipWhitespace();
+        juce::String word;
+        while (juce::CharacterFunctions::isLetterOrDigit(*p) || *p == '_')
+            word += p.getAndAdvance();
+
+        return word;
+    }
+
+    bool match(const char* token)
+    {
+        skipWhitespace();
+        auto start = p;
+
+        for (auto* t = token; *t != 0; ++t, ++p)
+        {
+            if (*p != (juce::juce_wchar)*t)
+            {
+                p = start;
+                return false;
+            }
+        }
+
+        // Don't take the first character of "<=", ">=" and "!=" as a token of its own
+        if (token[1] == 0 && (token[0] == '<' || token[0] == '>' || token[0] == '!') && *p == '=')
+        {
+            p = start;
+            return false;
+        }
+
+        return true;
+    }
+
+    void skipWhitespace()
+    {
+        p = p.findEndOfWhitespace();
+    }
+
+    void emit(WatchCondition::Op op, int operand = 0)
+    {
+        using Op = WatchCondition::Op;
+
+        switch (op)
+        {
+        case Op::pushProperty:
+        case Op::pushType:
+        case Op::pushConstant:
+        case Op::changed:
+            maxDepth = juce::jmax(maxDepth, ++depth);
+            break;
+
+        case Op::logicalNot:
+            break;
+
+        default:
+            --depth;
+            break;
+        }
+
+        condition.program.push_back({ op, operand });
+    }
+
+    int addConstant(const juce::var& value)
+    {
+        condition.constants.push_back(value);
+        return static_cast<int>(condition.constants.size()) - 1;
+    }
+
+    int addIdentifier(const juce::Identifier& id)
+    {
+        const auto it = std::find(condition.identifiers.begin(), condition.identifiers.end(), id);
+        if (it != condition.identifiers.end())
+            return static_cast<int>(std::distance(condition.identifiers.begin(), it));
+
+        condition.identifiers.push_back(id);
+        return static_cast<int>(condition.identifiers.size()) - 1;
+    }
+
+    juce::Result fail(const juce::String& message) const
+    {
+        return juce::Result::fail(message);
+    }
+
+    juce::String::CharPointerType p;
+    WatchCondition& condition;
+
+    int depth{ 0 };
+    int maxDepth{ 0 };
+    bool usesType{ false };
+    juce::Array<juce::Identifier> changedProperties;
+    juce::Array<juce::Identifier> comparedProperties;
+
+    /* Parentheses and negations around the current test, zero for a conjunct of the whole condition */
+    int groupDepth{ 0 };
+    int negationDepth{ 0 };
+    bool topLevelOr{ false };
+    bool negatedChangedTest{ false };
+    juce::Array<juce::Identifier> topLevelChangedProperties;
+};
+
+// ============================================================================
+
+WatchCondition WatchCondition::compile(const juce::String& text, juce::Result& result)
+{
+    WatchCondition condition;
+    result = WatchConditionParser{ text, condition }.parse();
+
+    if (result.failed())
+        return {};
+
+    return condition;
+}
+
+bool WatchCondition::evaluate(const juce::ValueTree& tree, const juce::Identifier& changedProperty) const
+{
+    if (program.empty()) return true;
+
+    juce::var stack[maxStackDepth];
+    int top = 0;
+
+    for (const auto& instruction : program)
+    {
+        switch (instruction.op)
+        {
+        case Op::pushProperty:
+            stack[top++] = tree[identifiers[(size_t)instruction.operand]];
+            break;
+
+        case Op::pushType:
+            stack[top++] = tree.getType().toString();
+            break;
+
+        case Op::pushConstant:
+            stack[top++] = constants[(size_t)instruction.operand];
+            break;
+
+        case Op::changed:
+            stack[top++] = changedProperty == identifiers[(size_t)instruction.operand];
+            break;
+
+        case Op::logicalNot:
+            stack[top - 1] = !static_cast<bool>(stack[top - 1]);
+            break;
+
+        case Op::logicalAnd:
+            --top;
+            stack[top - 1] = static_cast<bool>(stack[top - 1]) && static_cast<bool>(stack[top]);
+            break;
+
+        case Op::logicalOr:
+            --top;
+            stack[top - 1] = static_cast<bool>(stack[top - 1]) || static_cast<bool>(stack[top]);
+            break;
+
+        case Op::equal:
+        case Op::notEqual:
+        case Op::less:
+        case Op::lessOrEqual:
+        case Op::greater:
+        case Op::greaterOrEqual:
+        {
+            --top;
+            const auto comparison = ValueComparison::compare(stack[top - 1], stack[top]);
+            bool isTrue = false;
+
+            switch (instruction.op)
+            {
+            case Op::equal:          isTrue = comparison == 0; break;
+            case Op::notEqual:       isTrue = comparison != 0; break;
+            case Op::less:           isTrue = comparison < 0; break;
+            case Op::lessOrEqual:    isTrue = comparison <= 0; break;
+            case Op::greater:        isTrue = comparison > 0; break;
+            case Op::greaterOrEqual: isTrue = comparison >= 0; break;
+            default: break;
+            }
+
+            stack[top - 1] = isTrue;
+            break;
+        }
+        }
+    }
+
+    jassert(top == 1);
+    return static_cast<bool>(stack[0]);
+}
+
+// ============================================================================
+
+juce::Result Watchpoints::add(const juce::String& condition, Action action, juce::ValueTree scope)
+{
+    auto result = juce::Result::ok();
+    auto compiled = WatchCondition::compile(condition, result);
+    if (result.failed()) return result;
+
+    watchpoints.push_back({ condition.trim(), std::move(compiled), action, scope });
+    rebuildIndex();
+    return result;
+}
+
+void Watchpoints::remove(int index)
+{
+    if (!juce::isPositiveAndBelow(index, size())) return;
+
+    watchpoints.erase(watchpoints.begin() + index);
+    rebuildIndex();
+}
+
+void Watchpoints::clear()
+{
+    watchpoints.clear();
+    rebuildIndex();
+}
+
+juce::String Watchpoints::getDescription(int index) const
+{
+    const auto& watchpoint = watchpoints[(size_t)index];
+
+    juce::String description{ watchpoint.text.isEmpty() ? "any write" : watchpoint.text };
+
+    if (watchpoint.scope.isValid())
+        description << " in " << watchpoint.scope.getType().toString();
+
+    switch (watchpoint.action)
+    {
+    case Action::log:           description << " -> log"; break;
+    case Action::debugBreak:    description << " -> break"; break;
+    case Action::pauseUpdates:  description << " -> pause"; break;
+    }
+
+    return description << " (" << watchpoint.hits << " hits)";
+}
+
+void Watchpoints::propertyChanged(const juce::ValueTree& tree, const juce::Identifier& property)
+{
+    if (watchpoints.empty()) return;
+
+    if (!byProperty.empty())
+    {
+        const auto it = byProperty.find(property);
+        if (it != byProperty.end())
+            for (auto index : it->second)
+                check(index, tree, property);
+    }
+
+    for (auto index : anyProperty)
+        check(index, tree, property);
+}
+
+void Watchpoints::structureChanged(const juce::ValueTree& parentTree)
+{
+    for (auto index : subtreeWrites)
+    {
+        auto& watchpoint = watchpoints[(size_t)index];
+        if (parentTree == watchpoint.scope || parentTree.isAChildOf(watchpoint.scope))
+            hit(watchpoint, parentTree, {});
+    }
+}
+
+void Watchpoints::rebuildIndex()
+{
+    byProperty.clear();
+    anyProperty.clear();
+    subtreeWrites.clear();
+
+    for (int i = 0; i < size(); ++i)
+    {
+        const auto& watchpoint = watchpoints[(size_t)i];
+        const auto& triggers = watchpoint.condition.getTriggers();
+
+        if (watchpoint.condition.isAlwaysTrue() && watchpoint.scope.isValid())
+            subtreeWrites.push_back(i);
+
+        if (triggers.empty())
+            anyProperty.push_back(i);
+
+        for (const auto& property : triggers)
+            byProperty[property].push_back(i);
+    }
+}
+
+void Watchpoints::check(int index, const juce::ValueTree& tree, const juce::Identifier& property)
+{
+    auto& watchpoint = watchpoints[(size_t)index];
+
+    if (watchpoint.scope.isValid() && tree != watchpoint.scope && !tree.isAChildOf(watchpoint.scope))
+        return;
+
+    if (watchpoint.condition.evaluate(tree, property))
+        hit(watchpoint, tree, property);
+}
+
+void Watchpoints::hit(Watchpoint& watchpoint, const juce::ValueTree& tree, const juce::Identifier& property)
+{
+    ++watchpoint.hits;
+
+    juce::String message{ "Watchpoint \"" + watchpoint.text + "\" hit on " + tree.getType().toString() };
+    if (property.isNull())
+        message << " (children changed)";
+    else
+        message << "." << property.toString() << " = " << tree[property].toString();
+
+    switch (watchpoint.action)
+    {
+    case Action::log:
+        juce::Logger::writeToLog(message + juce::newLine + juce::SystemStats::getStackBacktrace());
+        break;
+
+    case Action::debugBreak:
+        juce::Logger::writeToLog(message);
+        // The writer of the property is further up the call stack
+        jassertfalse;
+        break;
+
+    case Action::pauseUpdates:
+        if (onPauseRequested) onPauseRequested(message);
+        break;
+    }
+}
+
+} // namespace vtdbg
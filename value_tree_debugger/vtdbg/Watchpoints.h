@@ -0,0 +1,119 @@
+#pragma once
+
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "FlatTreeModel.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace vtdbg
+{
+/* A property condition compiled once into a postfix program.
+   Grammar:
+       condition  := or
+       or         := and ( "||" and )*
+       and        := unary ( "&&" unary )*
+       unary      := "!" unary | "(" or ")" | name "changed" | operand ( op operand )?
+       operand    := name | "type" | number | "string" | true | false
+       op         := == != < <= > >=
+   "type" is the type of the changed node, "name changed" is true when that property was written. */
+class WatchCondition
+{
+public:
+    static WatchCondition compile(const juce::String& text, juce::Result& result);
+
+    bool evaluate(const juce::ValueTree& tree, const juce::Identifier& changedProperty) const;
+    bool isAlwaysTrue() const { return program.empty(); }
+
+    /* Properties whose writes can make the condition true, empty if any write can */
+    const std::vector<juce::Identifier>& getTriggers() const { return triggers; }
+
+    enum class Op : juce::uint8
+    {
+        pushProperty,
+        pushType,
+        pushConstant,
+        changed,
+        equal,
+        notEqual,
+        less,
+        lessOrEqual,
+        greater,
+        greaterOrEqual,
+        logicalAnd,
+        logicalOr,
+        logicalNot,
+    };
+
+    struct Instruction
+    {
+        Op op;
+        int operand;
+    };
+
+    static constexpr int maxStackDepth{ 16 };
+
+private:
+    friend class WatchConditionParser;
+
+    std::vector<Instruction> program;
+    std::vector<juce::Identifier> identifiers;
+    std::vector<juce::var> constants;
+    std::vector<juce::Identifier> triggers;
+};
+
+/* Watchpoints on property writes, indexed by property so that writes to
+   properties no watchpoint mentions cost a single hash lookup */
+class Watchpoints
+{
+public:
+    enum class Action
+    {
+        log,         // Log the change and a stack trace
+        debugBreak,  // Stop in the debugger
+        pauseUpdates // Stop updating the debugger view
+    };
+
+    /* Add a watchpoint. An empty condition watches every write.
+       If scope is valid, only writes to it and its descendants are watched. */
+    juce::Result add(const juce::String& condition, Action action, juce::ValueTree scope = {});
+    void remove(int index);
+    void clear();
+
+    int size() const { return static_cast<int>(watchpoints.size()); }
+    bool isEmpty() const { return watchpoints.empty(); }
+    juce::String getDescription(int index) const;
+    int getNumHits(int index) const { return watchpoints[(size_t)index].hits; }
+
+    // Change path
+    void propertyChanged(const juce::ValueTree& tree, const juce::Identifier& property);
+    void structureChanged(const juce::ValueTree& parentTree);
+
+    /* Called for hits of watchpoints with the pauseUpdates action */
+    std::function<void(const juce::String& message)> onPauseRequested;
+
+private:
+    struct Watchpoint
+    {
+        juce::String text;
+        WatchCondition condition;
+        Action action;
+        juce::ValueTree scope;
+        int hits{ 0 };
+    };
+
+    void rebuildIndex();
+    void check(int index, const juce::ValueTree& tree, const juce::Identifier& property);
+    void hit(Watchpoint& watchpoint, const juce::ValueTree& tree, const juce::Identifier& property);
+
+    std::vector<Watchpoint> watchpoints;
+    std::unordered_map<juce::Identifier, std::vector<int>, IdentifierHash> byProperty;
+    /* Watchpoints triggered by writes to any property */
+    std::vector<int> anyProperty;
+    /* Watchpoints on any write to a subtree, also triggered by structural changes */
+    std::vector<int> subtreeWrites;
+};
+
+} // namespace vtdbg